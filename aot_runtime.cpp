@@ -0,0 +1,137 @@
+#include "aot_runtime.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace aot {
+
+    using runtime::ObjectHolder;
+
+    // ----------------------NativeMethod-----------------------
+
+    NativeMethod::NativeMethod(Function function)
+        : function_(function) {}
+
+    ObjectHolder NativeMethod::Execute(runtime::Closure& closure, runtime::Context& context) {
+        return function_(closure, context);
+    }
+
+    // ----------------------Local-----------------------
+
+    Local::Local(const runtime::Closure& closure, const char* name)
+        : value_(closure.at(name))
+        , defined_(true) {}
+
+    const ObjectHolder& Local::Get(const char* name) const {
+        if (!defined_) {
+            Undefined(name);
+        }
+        return value_;
+    }
+
+    void Local::Set(ObjectHolder value) {
+        value_ = move(value);
+        defined_ = true;
+    }
+
+    // ----------------------ClassBuilder-----------------------
+
+    ObjectHolder MakeClass(const char* name, initializer_list<MethodSpec> methods, const ObjectHolder& parent) {
+        vector<runtime::Method> class_methods;
+        for (const MethodSpec& spec : methods) {
+            class_methods.push_back({spec.name, spec.params, make_unique<NativeMethod>(spec.function)});
+        }
+        return ObjectHolder::Own(runtime::Class(name, move(class_methods), parent.TryAs<runtime::Class>()));
+    }
+
+    // ----------------------Operations-----------------------
+
+    ObjectHolder Load(const runtime::Closure& closure, const char* name) {
+        if (auto it = closure.find(name); it != closure.end()) {
+            return it->second;
+        }
+        Undefined(name);
+    }
+
+    ObjectHolder Undefined(const char* name) {
+        throw runtime_error("Not field"s + name);
+    }
+
+    ObjectHolder LoadField(const ObjectHolder& object, const char* name) {
+        auto instance = object.TryAs<runtime::ClassInstance>();
+        if (!instance) {
+            throw runtime_error("This isn't object"s);
+        }
+        return Load(instance->Fields(), name);
+    }
+
+    runtime::ClassInstance* AsInstance(const ObjectHolder& object) {
+        return object.TryAs<runtime::ClassInstance>();
+    }
+
+    ObjectHolder NewInstance(const ObjectHolder& cls) {
+        return ObjectHolder::Own(runtime::ClassInstance(*cls.TryAs<runtime::Class>()));
+    }
+
+    ObjectHolder Add(const ObjectHolder& lhs, const ObjectHolder& rhs, runtime::Context& context) {
+        auto lhs_number = lhs.TryAs<runtime::Number>();
+        auto rhs_number = rhs.TryAs<runtime::Number>();
+        if (lhs_number && rhs_number) {
+            return ObjectHolder::Own(runtime::Number(lhs_number->GetValue() + rhs_number->GetValue()));
+        }
+        auto lhs_string = lhs.TryAs<runtime::String>();
+        auto rhs_string = rhs.TryAs<runtime::String>();
+        if (lhs_string && rhs_string) {
+            return ObjectHolder::Own(runtime::String(lhs_string->GetValue() + rhs_string->GetValue()));
+        }
+        if (auto instance = lhs.TryAs<runtime::ClassInstance>(); instance) {
+            return instance->Call("__add__"s, {rhs}, context);
+        }
+        throw runtime_error("The operator is not overloaded +"s);
+    }
+
+    ObjectHolder Sub(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+        auto lhs_number = lhs.TryAs<runtime::Number>();
+        auto rhs_number = rhs.TryAs<runtime::Number>();
+        if (lhs_number && rhs_number) {
+            return ObjectHolder::Own(runtime::Number(lhs_number->GetValue() - rhs_number->GetValue()));
+        }
+        throw runtime_error("The operator is not overloaded -"s);
+    }
+
+    ObjectHolder Mult(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+        auto lhs_number = lhs.TryAs<runtime::Number>();
+        auto rhs_number = rhs.TryAs<runtime::Number>();
+        if (lhs_number && rhs_number) {
+            return ObjectHolder::Own(runtime::Number(lhs_number->GetValue() * rhs_number->GetValue()));
+        }
+        throw runtime_error("The operator is not overloaded *"s);
+    }
+
+    ObjectHolder Div(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+        auto lhs_number = lhs.TryAs<runtime::Number>();
+        auto rhs_number = rhs.TryAs<runtime::Number>();
+        if (lhs_number && rhs_number) {
+            if (rhs_number->GetValue() == 0) {
+                throw runtime_error("The denominator is zero"s);
+            }
+            return ObjectHolder::Own(runtime::Number(lhs_number->GetValue() / rhs_number->GetValue()));
+        }
+        throw runtime_error("The operator is not overloaded /"s);
+    }
+
+    ObjectHolder MakeBool(bool value) {
+        return ObjectHolder::Own(runtime::Bool(value));
+    }
+
+    ObjectHolder Stringify(const ObjectHolder& object, runtime::Context& context) {
+        if (!object) {
+            return ObjectHolder::Own(runtime::String("None"s));
+        }
+        string buffer;
+        object->FormatTo(buffer, context);
+        return ObjectHolder::Own(runtime::String(move(buffer)));
+    }
+
+}  // namespace aot
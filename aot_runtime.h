@@ -0,0 +1,84 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Support library for C++ code produced by aot::Transpile. Each helper does exactly what the
+// corresponding statement of the interpreter does, so a transpiled program behaves like the
+// interpreted one, errors included.
+namespace aot {
+
+    // ----------------------NativeMethod-----------------------
+
+    // The body of a transpiled method: runs the generated function on the call closure.
+    class NativeMethod : public runtime::Executable {
+    public:
+        using Function = runtime::ObjectHolder (*)(runtime::Closure& closure, runtime::Context& context);
+
+        explicit                                       NativeMethod(Function function);
+
+        runtime::ObjectHolder                          Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    private:
+        Function                                       function_;
+    };
+
+    // ----------------------Local-----------------------
+
+    // A local variable of a method. Reading it before it is assigned fails as it does in the
+    // interpreter.
+    class Local {
+    public:
+        Local() = default;
+
+        Local(const runtime::Closure& closure, const char* name);
+
+        [[nodiscard]] const runtime::ObjectHolder& Get(const char* name) const;
+
+        void                                           Set(runtime::ObjectHolder value);
+
+    private:
+        runtime::ObjectHolder                          value_;
+        bool                                           defined_ = false;
+    };
+
+    // ----------------------ClassBuilder-----------------------
+
+    struct MethodSpec {
+        const char* name;
+        std::vector<std::string>                       params;
+        NativeMethod::Function                         function;
+    };
+
+    [[nodiscard]] runtime::ObjectHolder                MakeClass(const char* name, std::initializer_list<MethodSpec> methods,
+                                                                 const runtime::ObjectHolder& parent);
+
+    // ----------------------Operations-----------------------
+
+    [[nodiscard]] runtime::ObjectHolder                Load(const runtime::Closure& closure, const char* name);
+
+    [[noreturn]] runtime::ObjectHolder                 Undefined(const char* name);
+
+    [[nodiscard]] runtime::ObjectHolder                LoadField(const runtime::ObjectHolder& object, const char* name);
+
+    [[nodiscard]] runtime::ClassInstance* AsInstance(const runtime::ObjectHolder& object);
+
+    [[nodiscard]] runtime::ObjectHolder                NewInstance(const runtime::ObjectHolder& cls);
+
+    [[nodiscard]] runtime::ObjectHolder                Add(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs,
+                                                           runtime::Context& context);
+
+    [[nodiscard]] runtime::ObjectHolder                Sub(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs);
+
+    [[nodiscard]] runtime::ObjectHolder                Mult(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs);
+
+    [[nodiscard]] runtime::ObjectHolder                Div(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs);
+
+    [[nodiscard]] runtime::ObjectHolder                MakeBool(bool value);
+
+    [[nodiscard]] runtime::ObjectHolder                Stringify(const runtime::ObjectHolder& object, runtime::Context& context);
+
+}  // namespace aot
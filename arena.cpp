@@ -0,0 +1,125 @@
+#include "arena.h"
+
+#include "runtime.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        ObjectHolder PromoteObject(const Arena& arena, const ObjectHolder& object,
+            unordered_map<const Object*, ObjectHolder>& promoted) {
+            if (!object || !arena.Owns(object.Get())) {
+                return object;
+            }
+            if (auto it = promoted.find(object.Get()); it != promoted.end()) {
+                return it->second;
+            }
+            if (auto ptr = object.TryAs<Number>(); ptr) {
+                return promoted[ptr] = ObjectHolder::Own(Number(ptr->GetValue()));
+            }
+            if (auto ptr = object.TryAs<String>(); ptr) {
+                return promoted[ptr] = ObjectHolder::Own(String(ptr->GetValue()));
+            }
+            if (auto ptr = object.TryAs<Bool>(); ptr) {
+                return promoted[ptr] = ObjectHolder::Own(Bool(ptr->GetValue()));
+            }
+            if (auto ptr = object.TryAs<ClassInstance>(); ptr) {
+                ObjectHolder copy = ObjectHolder::Own(ClassInstance(ptr->GetClass()));
+                promoted[ptr] = copy;
+                auto* instance = copy.TryAs<ClassInstance>();
+                for (const auto& [name, value] : ptr->Fields()) {
+                    instance->SetField(name, PromoteObject(arena, value, promoted));
+                }
+                return copy;
+            }
+            return object;
+        }
+    }  // namespace
+
+    // ----------------------Scope-----------------------
+
+    Arena::Scope::Scope(Arena& arena)
+        : previous_(current_) {
+        current_ = &arena;
+    }
+
+    Arena::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    // ----------------------State-----------------------
+
+    Arena::State::State(size_t block_size)
+        : block_size(block_size) {}
+
+    void* Arena::State::Allocate(size_t size, size_t alignment) {
+        auto aligned = [alignment](std::byte* ptr) {
+            const auto address = reinterpret_cast<uintptr_t>(ptr);
+            return reinterpret_cast<std::byte*>((address + alignment - 1) & ~(alignment - 1));
+        };
+        std::byte* result = cursor ? aligned(cursor) : nullptr;
+        if (!result || result + size > limit) {
+            const size_t new_block_size = max(block_size, size + alignment);
+            blocks.push_back(make_unique<std::byte[]>(new_block_size));
+            cursor = blocks.back().get();
+            block_sizes.emplace(cursor, new_block_size);
+            limit = cursor + new_block_size;
+            result = aligned(cursor);
+        }
+        cursor = result + size;
+        allocated_bytes += size;
+        return result;
+    }
+
+    // ----------------------Arena-----------------------
+
+    Arena::Arena(size_t block_size)
+        : state_(make_shared<State>(block_size)) {}
+
+    void* Arena::Allocate(size_t size, size_t alignment) {
+        return state_->Allocate(size, alignment);
+    }
+
+    bool Arena::Owns(const void* ptr) const {
+        const auto* byte_ptr = static_cast<const std::byte*>(ptr);
+        auto it = state_->block_sizes.upper_bound(byte_ptr);
+        if (it == state_->block_sizes.begin()) {
+            return false;
+        }
+        --it;
+        return byte_ptr < it->first + it->second;
+    }
+
+    ObjectHolder Arena::Promote(const ObjectHolder& object) const {
+        Arena* previous = current_;
+        current_ = nullptr;
+        unordered_map<const Object*, ObjectHolder> promoted;
+        try {
+            ObjectHolder result = PromoteObject(*this, object, promoted);
+            current_ = previous;
+            return result;
+        }
+        catch (...) {
+            current_ = previous;
+            throw;
+        }
+    }
+
+    size_t Arena::GetAllocatedBytes() const {
+        return state_->allocated_bytes;
+    }
+
+    size_t Arena::GetBlockCount() const {
+        return state_->blocks.size();
+    }
+
+    size_t Arena::GetLiveObjects() const {
+        return state_->live_objects.load(memory_order_relaxed);
+    }
+
+}  // namespace runtime
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace runtime {
+
+    class ObjectHolder;
+
+    // ----------------------Arena-----------------------
+
+    // Bump allocation of runtime objects for one execution, bound to the thread by Scope. Only an
+    // object and its shared_ptr control block are carved from the arena: the field maps of
+    // instances, their keys and the payloads of Strings still come from the global heap. Dropping
+    // the arena does not skip destruction either. Every object is still destroyed through its
+    // holders, and only the blocks are released together, once the last object in them is gone.
+    // What an arena saves is the malloc and free of each object, not the teardown walk. Each
+    // object also keeps a reference to the arena state, an atomic increment and decrement per
+    // object, which is what keeps objects that escape the run valid.
+    class Arena {
+    public:
+        static constexpr size_t                        DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        class Scope {
+        public:
+            explicit                                   Scope(Arena& arena);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            Arena* previous_;
+        };
+
+        explicit                                       Arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+        [[nodiscard]] static Arena* Current();
+
+        [[nodiscard]] void* Allocate(size_t size, size_t alignment);
+
+        [[nodiscard]] bool                             Owns(const void* ptr) const;
+
+        [[nodiscard]] ObjectHolder                     Promote(const ObjectHolder& object) const;
+
+        [[nodiscard]] size_t                           GetAllocatedBytes() const;
+
+        [[nodiscard]] size_t                           GetBlockCount() const;
+
+        [[nodiscard]] size_t                           GetLiveObjects() const;
+
+    private:
+        struct State {
+            explicit                                   State(size_t block_size);
+
+            void* Allocate(size_t size, size_t alignment);
+
+            size_t                                     block_size;
+            std::vector<std::unique_ptr<std::byte[]>>  blocks;
+            // Block sizes by block start, so Owns finds the block below a pointer in log time.
+            std::map<const std::byte*, size_t>         block_sizes;
+            std::byte* cursor = nullptr;
+            std::byte* limit = nullptr;
+            size_t                                     allocated_bytes = 0;
+            std::atomic<size_t>                        live_objects = 0;
+        };
+
+        template <typename T>
+        friend class ArenaAllocator;
+
+        // Every object allocated from the arena holds a reference to the state, so the blocks
+        // outlive the Arena handle while anything allocated in them is still reachable.
+        std::shared_ptr<State>                         state_;
+
+        static inline thread_local Arena* current_ = nullptr;
+    };
+
+    inline Arena* Arena::Current() {
+        return current_;
+    }
+
+    // ----------------------ArenaAllocator-----------------------
+
+    template <typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        explicit                                       ArenaAllocator(const Arena& arena);
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other);
+
+        [[nodiscard]] T* allocate(size_t n);
+
+        void                                           deallocate(T* ptr, size_t n);
+
+        template <typename U>
+        bool                                           operator==(const ArenaAllocator<U>& other) const;
+
+        template <typename U>
+        bool                                           operator!=(const ArenaAllocator<U>& other) const;
+
+    private:
+        template <typename U>
+        friend class ArenaAllocator;
+
+        std::shared_ptr<Arena::State>                  state_;
+    };
+
+    template <typename T>
+    ArenaAllocator<T>::ArenaAllocator(const Arena& arena)
+        : state_(arena.state_) {}
+
+    template <typename T>
+    template <typename U>
+    ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& other)
+        : state_(other.state_) {}
+
+    template <typename T>
+    T* ArenaAllocator<T>::allocate(size_t n) {
+        state_->live_objects.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<T*>(state_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    template <typename T>
+    void ArenaAllocator<T>::deallocate([[maybe_unused]] T* ptr, [[maybe_unused]] size_t n) {
+        state_->live_objects.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    template <typename U>
+    bool ArenaAllocator<T>::operator==(const ArenaAllocator<U>& other) const {
+        return state_ == other.state_;
+    }
+
+    template <typename T>
+    template <typename U>
+    bool ArenaAllocator<T>::operator!=(const ArenaAllocator<U>& other) const {
+        return !(*this == other);
+    }
+
+}  // namespace runtime
@@ -0,0 +1,136 @@
+#include "arena.h"
+#include "lexer.h"
+#include "parse.h"
+#include "quota.h"
+#include "runtime.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestArenaAllocatesInScope() {
+    Arena arena(1024);
+    ObjectHolder outside = ObjectHolder::Own(Number(1));
+    ObjectHolder inside;
+    {
+        Arena::Scope scope(arena);
+        ASSERT_EQUAL(Arena::Current(), &arena);
+        inside = ObjectHolder::Own(String("in arena"s));
+    }
+    ASSERT(Arena::Current() == nullptr);
+    ASSERT(arena.Owns(inside.Get()));
+    ASSERT(!arena.Owns(outside.Get()));
+    ASSERT_EQUAL(arena.GetLiveObjects(), 1U);
+    ASSERT_EQUAL(arena.GetBlockCount(), 1U);
+
+    inside = ObjectHolder::None();
+    ASSERT_EQUAL(arena.GetLiveObjects(), 0U);
+}
+
+void TestArenaGrowsBlocks() {
+    Arena arena(256);
+    Arena::Scope scope(arena);
+    vector<ObjectHolder> numbers;
+    for (int i = 0; i < 100; ++i) {
+        numbers.push_back(ObjectHolder::Own(Number(i)));
+    }
+    ASSERT(arena.GetBlockCount() > 1U);
+    ASSERT_EQUAL(arena.GetLiveObjects(), 100U);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQUAL(numbers[i].TryAs<Number>()->GetValue(), i);
+    }
+}
+
+void TestEscapedObjectKeepsArenaAlive() {
+    ObjectHolder escaped;
+    {
+        Arena arena;
+        Arena::Scope scope(arena);
+        escaped = ObjectHolder::Own(String("still here"s));
+    }
+    ASSERT_EQUAL(escaped.TryAs<String>()->GetValue(), "still here"s);
+}
+
+void TestPromoteCopiesObjectGraph() {
+    Class cls("Node"s, {}, nullptr);
+    Arena arena;
+    ObjectHolder node;
+    {
+        Arena::Scope scope(arena);
+        node = ObjectHolder::Own(ClassInstance(cls));
+        node.TryAs<ClassInstance>()->Fields()["value"s] = ObjectHolder::Own(Number(42));
+        node.TryAs<ClassInstance>()->Fields()["name"s] = ObjectHolder::Own(String("n"s));
+    }
+    ObjectHolder promoted = arena.Promote(node);
+    ASSERT(promoted.Get() != node.Get());
+    ASSERT(!arena.Owns(promoted.Get()));
+
+    auto* instance = promoted.TryAs<ClassInstance>();
+    ASSERT(instance != nullptr);
+    ASSERT_EQUAL(&instance->GetClass(), &cls);
+    ASSERT(!arena.Owns(instance->Fields().at("value"s).Get()));
+    ASSERT_EQUAL(instance->Fields().at("value"s).TryAs<Number>()->GetValue(), 42);
+    ASSERT_EQUAL(instance->Fields().at("name"s).TryAs<String>()->GetValue(), "n"s);
+
+    ObjectHolder heap_value = ObjectHolder::Own(Number(7));
+    ASSERT_EQUAL(arena.Promote(heap_value).Get(), heap_value.Get());
+
+    // Promoted fields are charged like any other assignment.
+    MemoryAccount account;
+    {
+        MemoryAccount::Scope scope(&account);
+        ObjectHolder charged = arena.Promote(node);
+        ASSERT_EQUAL(charged.TryAs<ClassInstance>()->Fields().size(), 2U);
+        ASSERT(account.GetCurrentBytes()
+               >= sizeof(ClassInstance) + sizeof(Number) + sizeof(String) + 2 * sizeof(Closure::value_type));
+    }
+    ASSERT_EQUAL(account.GetCurrentBytes(), 0U);
+}
+
+void TestProgramRunsInArena() {
+    istringstream input(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add(n):
+    self.value = self.value + n
+
+c = Counter()
+c.add(2)
+c.add(3)
+message = 'total ' + str(c.value)
+print message
+)");
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+
+    Arena arena;
+    DummyContext context;
+    Closure closure;
+    {
+        Arena::Scope scope(arena);
+        program->Execute(closure, context);
+    }
+    ASSERT_EQUAL(context.output.str(), "total 5\n"s);
+    ASSERT(arena.GetLiveObjects() > 0U);
+
+    ObjectHolder message = arena.Promote(closure.at("message"s));
+    closure.clear();
+    ASSERT_EQUAL(message.TryAs<String>()->GetValue(), "total 5"s);
+}
+
+}  // namespace
+
+void RunArenaTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestArenaAllocatesInScope);
+    RUN_TEST(tr, runtime::TestArenaGrowsBlocks);
+    RUN_TEST(tr, runtime::TestEscapedObjectKeepsArenaAlive);
+    RUN_TEST(tr, runtime::TestPromoteCopiesObjectGraph);
+    RUN_TEST(tr, runtime::TestProgramRunsInArena);
+}
+
+}  // namespace runtime
@@ -0,0 +1,191 @@
+#include "corpus.h"
+
+using namespace std;
+
+namespace bench {
+
+    namespace {
+
+        const string RECURSIVE_CALLS = R"(
+class Fib:
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+f = Fib()
+print f.fib(20)
+)";
+
+        const string INHERITANCE_DISPATCH = R"(
+class Base:
+  def value():
+    return 1
+
+  def weight():
+    return 2
+
+class Level1(Base):
+  def name():
+    return 'level1'
+
+class Level2(Level1):
+  def name():
+    return 'level2'
+
+class Level3(Level2):
+  def describe():
+    return 'three'
+
+class Level4(Level3):
+  def describe():
+    return 'four'
+
+class Level5(Level4):
+  def name():
+    return 'level5'
+
+class Level6(Level5):
+  def describe():
+    return 'six'
+
+class Level7(Level6):
+  def label():
+    return 'seven'
+
+class Runner:
+  def __init__(target):
+    self.target = target
+
+  def run(n):
+    if n == 0:
+      return self.target.value() + self.target.weight()
+    return self.run(n - 1) + self.run(n - 1)
+
+r = Runner(Level7())
+print r.run(12)
+)";
+
+        const string FIELD_GRAPH = R"(
+class Node:
+  def __init__(value):
+    self.value = value
+    self.left = None
+    self.right = None
+
+class Builder:
+  def build(depth, value):
+    node = Node(value)
+    if depth > 0:
+      node.left = self.build(depth - 1, value * 2)
+      node.right = self.build(depth - 1, value * 2 + 1)
+    return node
+
+class Walker:
+  def total(node, depth):
+    if depth == 0:
+      return node.value
+    return node.value + self.total(node.left, depth - 1) + self.total(node.right, depth - 1)
+
+  def leftmost(node, depth):
+    if depth == 0:
+      return node.value
+    return self.leftmost(node.left, depth - 1)
+
+b = Builder()
+root = b.build(11, 1)
+w = Walker()
+print w.total(root, 11), w.leftmost(root, 11), root.left.right.left.value
+)";
+
+        const string STRING_CONCAT = R"(
+class Joiner:
+  def join(n, sep):
+    if n == 0:
+      return 'x'
+    return self.join(n - 1, sep) + sep + str(n) + sep + self.join(n - 1, sep)
+
+  def wrap(text, depth):
+    if depth == 0:
+      return text
+    return '<' + self.wrap(text, depth - 1) + '>'
+
+j = Joiner()
+s = j.join(11, ',')
+print j.wrap('core', 300)
+print s == j.join(11, ','), s < j.join(11, ';')
+)";
+
+        const string COMPARISONS = R"(
+class Version:
+  def __init__(major, minor):
+    self.major = major
+    self.minor = minor
+
+  def __eq__(other):
+    return self.major == other.major and self.minor == other.minor
+
+  def __lt__(other):
+    if self.major < other.major:
+      return True
+    if self.major == other.major:
+      return self.minor < other.minor
+    return False
+
+class Checker:
+  def __init__(a, b, c):
+    self.a = a
+    self.b = b
+    self.c = c
+
+  def count(n):
+    if n == 0:
+      result = 0
+      if self.a < self.b:
+        result = result + 1
+      if self.b >= self.c:
+        result = result + 1
+      if self.a == self.c or self.b != self.c:
+        result = result + 1
+      if self.c > self.a:
+        result = result + 1
+      return result
+    return self.count(n - 1) + self.count(n - 1)
+
+c = Checker(Version(1, 2), Version(1, 10), Version(2, 0))
+print c.count(11)
+)";
+
+        const string PRINT_HEAVY = R"(
+class Printer:
+  def __init__(prefix):
+    self.prefix = prefix
+
+  def __str__():
+    return '[' + self.prefix + ']'
+
+  def emit(n, line):
+    if n == 0:
+      print self, line, 'value', line * 3, True, None
+      return 1
+    return self.emit(n - 1, line * 2) + self.emit(n - 1, line * 2 + 1)
+
+p = Printer('log')
+print p.emit(11, 1)
+)";
+
+    }  // namespace
+
+    const vector<Workload>& Corpus() {
+        static const vector<Workload> corpus = {
+            {"recursive_calls", "binary-recursive fib(20) on one instance", RECURSIVE_CALLS},
+            {"inheritance_dispatch", "4096 calls resolved through an eight-level class chain", INHERITANCE_DISPATCH},
+            {"field_graph", "builds and walks a 4095-node object tree through fields", FIELD_GRAPH},
+            {"string_concat", "joins and nests strings, then compares the results", STRING_CONCAT},
+            {"comparisons", "__eq__ and __lt__ driven comparisons of user objects", COMPARISONS},
+            {"print_heavy", "prints 2048 lines mixing objects, strings and numbers", PRINT_HEAVY},
+        };
+        return corpus;
+    }
+
+}  // namespace bench
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    // ----------------------Workload-----------------------
+
+    struct Workload {
+        std::string                                    name;
+        std::string                                    description;
+        std::string                                    source;
+    };
+
+    // Representative Mython programs, each stressing one hot path of the interpreter. Mython has
+    // no loops, so the workloads repeat through binary recursion, which keeps the call depth low
+    // enough for the tree-walking interpreter.
+    const std::vector<Workload>& Corpus();
+
+}  // namespace bench
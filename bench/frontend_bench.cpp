@@ -0,0 +1,300 @@
+// Scaling benchmark of the Mython front end over programs produced by bench::GenerateProgram.
+//
+// Build from the repository root, for example
+//     c++ -std=c++17 -O2 -pthread -I. -o frontend_bench bench/frontend_bench.cpp bench/generator.cpp $(ls *.cpp | grep -v -e main.cpp -e test)
+// and run
+//     ./frontend_bench [--min-bytes=N] [--max-bytes=N] [--factor=N] [--seed=N] [--classes=N]
+//                      [--methods=N] [--statements=N] [--depth=N] [--strings=P] [--dir=PATH]
+//
+// Sizes grow geometrically from min-bytes (default 1 KiB) to max-bytes (default 64 MiB; pass
+// --max-bytes=1073741824 for 1 GiB). For each size a program is generated into a file under dir
+// (the system temporary directory by default) and then read twice: once to time parse::Lexer and
+// count its tokens, once to time ParseProgram on a fresh lexer and count the nodes it builds.
+// Peak bytes are the high-water mark of live heap memory during each phase. ns_per_byte staying
+// flat as the size grows means the phase scales linearly. The report is one JSON document:
+//     {"schema": "mython-frontend-bench/1", "results": [{"source_bytes", "tokens", "lex_ns",
+//      "tokens_per_second", "lex_ns_per_byte", "lex_peak_bytes", "nodes", "parse_ns",
+//      "nodes_per_second", "parse_ns_per_byte", "parse_peak_bytes", "max_rss_bytes"}, ...]}
+
+#include "generator.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    // Every block carries its size in front, so that live bytes can be tracked on delete.
+    constexpr size_t HEADER_BYTES = alignof(max_align_t);
+
+    atomic<size_t> live_bytes{0};
+    atomic<size_t> peak_bytes{0};
+
+}  // namespace
+
+[[gnu::noinline]] void* operator new(size_t size) {
+    auto* block = static_cast<char*>(malloc(size + HEADER_BYTES));
+    if (!block) {
+        throw bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    const size_t live = live_bytes.fetch_add(size, memory_order_relaxed) + size;
+    size_t peak = peak_bytes.load(memory_order_relaxed);
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {
+    }
+    return block + HEADER_BYTES;
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept {
+    if (!pointer) {
+        return;
+    }
+    char* block = static_cast<char*>(pointer) - HEADER_BYTES;
+    live_bytes.fetch_sub(*reinterpret_cast<size_t*>(block), memory_order_relaxed);
+    free(block);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept {
+    operator delete(pointer);
+}
+
+namespace bench {
+
+    namespace {
+
+        // ----------------------Options-----------------------
+
+        struct Options {
+            size_t                                     min_bytes = 1 << 10;
+            size_t                                     max_bytes = 64 << 20;
+            size_t                                     factor = 4;
+            GeneratorOptions                           generator;
+            filesystem::path                           directory = filesystem::temp_directory_path();
+        };
+
+        bool ParseOptions(int argc, char** argv, Options& options) {
+            for (int i = 1; i < argc; ++i) {
+                const string_view argument = argv[i];
+                const size_t equals = argument.find('=');
+                if (equals == string_view::npos) {
+                    return false;
+                }
+                const string_view key = argument.substr(0, equals);
+                const string value(argument.substr(equals + 1));
+                if (key == "--min-bytes"sv) {
+                    options.min_bytes = max<size_t>(1, stoull(value));
+                }
+                else if (key == "--max-bytes"sv) {
+                    options.max_bytes = stoull(value);
+                }
+                else if (key == "--factor"sv) {
+                    options.factor = max<size_t>(2, stoull(value));
+                }
+                else if (key == "--seed"sv) {
+                    options.generator.seed = stoull(value);
+                }
+                else if (key == "--classes"sv) {
+                    options.generator.classes = max<size_t>(1, stoull(value));
+                }
+                else if (key == "--methods"sv) {
+                    options.generator.methods_per_class = max<size_t>(1, stoull(value));
+                }
+                else if (key == "--statements"sv) {
+                    options.generator.statements_per_block = max<size_t>(1, stoull(value));
+                }
+                else if (key == "--depth"sv) {
+                    options.generator.nesting_depth = stoull(value);
+                }
+                else if (key == "--strings"sv) {
+                    options.generator.string_density = stod(value);
+                }
+                else if (key == "--dir"sv) {
+                    options.directory = value;
+                }
+                else {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // ----------------------Measurement-----------------------
+
+        struct Measurement {
+            size_t                                     source_bytes = 0;
+            size_t                                     tokens = 0;
+            chrono::nanoseconds                        lex_time{0};
+            size_t                                     lex_peak_bytes = 0;
+            size_t                                     nodes = 0;
+            chrono::nanoseconds                        parse_time{0};
+            size_t                                     parse_peak_bytes = 0;
+            size_t                                     max_rss_bytes = 0;
+        };
+
+        void ResetPeak() {
+            peak_bytes.store(live_bytes.load(memory_order_relaxed), memory_order_relaxed);
+        }
+
+        size_t PeakSinceReset(size_t baseline) {
+            return peak_bytes.load(memory_order_relaxed) - baseline;
+        }
+
+        size_t CountNodes(const runtime::Executable& statement);
+
+        size_t CountAll(const vector<unique_ptr<ast::Statement>>& statements) {
+            size_t count = 0;
+            for (const auto& statement : statements) {
+                count += CountNodes(*statement);
+            }
+            return count;
+        }
+
+        size_t CountNodes(const runtime::Executable& statement) {
+            size_t count = 1;
+            if (auto node = dynamic_cast<const ast::Assignment*>(&statement); node) {
+                count += CountNodes(*node->GetValue());
+            }
+            else if (auto node = dynamic_cast<const ast::FieldAssignment*>(&statement); node) {
+                count += 1 + CountNodes(*node->GetValue());
+            }
+            else if (auto node = dynamic_cast<const ast::Print*>(&statement); node) {
+                count += CountAll(node->GetArgs());
+            }
+            else if (auto node = dynamic_cast<const ast::MethodCall*>(&statement); node) {
+                count += CountNodes(*node->GetObject()) + CountAll(node->GetArgs());
+            }
+            else if (auto node = dynamic_cast<const ast::NewInstance*>(&statement); node) {
+                count += CountAll(node->GetArgs());
+            }
+            else if (auto node = dynamic_cast<const ast::UnaryOperation*>(&statement); node) {
+                count += CountNodes(*node->GetArgument());
+            }
+            else if (auto node = dynamic_cast<const ast::BinaryOperation*>(&statement); node) {
+                count += CountNodes(*node->GetLhs()) + CountNodes(*node->GetRhs());
+            }
+            else if (auto node = dynamic_cast<const ast::Compound*>(&statement); node) {
+                count += CountAll(node->GetStatements());
+            }
+            else if (auto node = dynamic_cast<const ast::MethodBody*>(&statement); node) {
+                count += CountNodes(*node->GetBody());
+            }
+            else if (auto node = dynamic_cast<const ast::Return*>(&statement); node) {
+                count += CountNodes(*node->GetStatement());
+            }
+            else if (auto node = dynamic_cast<const ast::IfElse*>(&statement); node) {
+                count += CountNodes(*node->GetCondition()) + CountNodes(*node->GetIfBody());
+                if (node->GetElseBody()) {
+                    count += CountNodes(*node->GetElseBody());
+                }
+            }
+            else if (auto node = dynamic_cast<const ast::ClassDefinition*>(&statement); node) {
+                for (const auto& method : node->GetClass().TryAs<runtime::Class>()->GetMethods()) {
+                    count += CountNodes(*method.body);
+                }
+            }
+            return count;
+        }
+
+        size_t MaxRssBytes() {
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            return static_cast<size_t>(usage.ru_maxrss) * 1024;
+        }
+
+        Measurement Measure(const Options& options, size_t target_bytes) {
+            Measurement result;
+            const filesystem::path path = options.directory / "mython_frontend_bench.my";
+            {
+                GeneratorOptions generator = options.generator;
+                generator.target_bytes = target_bytes;
+                ofstream output(path, ios::binary);
+                result.source_bytes = GenerateProgram(generator, output);
+            }
+            {
+                ifstream input(path, ios::binary);
+                const size_t baseline = live_bytes.load(memory_order_relaxed);
+                ResetPeak();
+                const auto start = chrono::steady_clock::now();
+                parse::Lexer lexer(input);
+                for (; !lexer.CurrentToken().Is<parse::token_type::Eof>(); lexer.NextToken()) {
+                    ++result.tokens;
+                }
+                result.lex_time = chrono::steady_clock::now() - start;
+                result.lex_peak_bytes = PeakSinceReset(baseline);
+            }
+            {
+                ifstream input(path, ios::binary);
+                const size_t baseline = live_bytes.load(memory_order_relaxed);
+                parse::Lexer lexer(input);
+                ResetPeak();
+                const auto start = chrono::steady_clock::now();
+                auto program = ParseProgram(lexer);
+                result.parse_time = chrono::steady_clock::now() - start;
+                result.parse_peak_bytes = PeakSinceReset(baseline);
+                result.nodes = CountNodes(*program);
+            }
+            filesystem::remove(path);
+            result.max_rss_bytes = MaxRssBytes();
+            return result;
+        }
+
+        double PerSecond(size_t count, chrono::nanoseconds time) {
+            return time.count() ? static_cast<double>(count) * 1e9 / static_cast<double>(time.count()) : 0.0;
+        }
+
+        double PerByte(chrono::nanoseconds time, size_t bytes) {
+            return bytes ? static_cast<double>(time.count()) / static_cast<double>(bytes) : 0.0;
+        }
+
+        void Report(ostream& out, const Measurement& m, bool first) {
+            out << (first ? "\n" : ",\n") << "    {\"source_bytes\": " << m.source_bytes
+                << ", \"tokens\": " << m.tokens
+                << ", \"lex_ns\": " << m.lex_time.count()
+                << ", \"tokens_per_second\": " << static_cast<uint64_t>(PerSecond(m.tokens, m.lex_time))
+                << ", \"lex_ns_per_byte\": " << PerByte(m.lex_time, m.source_bytes)
+                << ", \"lex_peak_bytes\": " << m.lex_peak_bytes
+                << ", \"nodes\": " << m.nodes
+                << ", \"parse_ns\": " << m.parse_time.count()
+                << ", \"nodes_per_second\": " << static_cast<uint64_t>(PerSecond(m.nodes, m.parse_time))
+                << ", \"parse_ns_per_byte\": " << PerByte(m.parse_time, m.source_bytes)
+                << ", \"parse_peak_bytes\": " << m.parse_peak_bytes
+                << ", \"max_rss_bytes\": " << m.max_rss_bytes << '}' << flush;
+        }
+
+    }  // namespace
+
+}  // namespace bench
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    if (!bench::ParseOptions(argc, argv, options)) {
+        cerr << "usage: " << argv[0] << " [--min-bytes=N] [--max-bytes=N] [--factor=N] [--seed=N] [--classes=N]"
+             << " [--methods=N] [--statements=N] [--depth=N] [--strings=P] [--dir=PATH]" << endl;
+        return 2;
+    }
+
+    cout << "{\n  \"schema\": \"mython-frontend-bench/1\",\n  \"seed\": " << options.generator.seed
+         << ",\n  \"results\": [";
+    bool first = true;
+    for (size_t size = options.min_bytes; size <= options.max_bytes; size *= options.factor) {
+        bench::Report(cout, bench::Measure(options, size), first);
+        first = false;
+    }
+    cout << "\n  ]\n}\n";
+    return 0;
+}
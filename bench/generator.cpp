@@ -0,0 +1,235 @@
+#include "generator.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace bench {
+
+    namespace {
+
+        // splitmix64, so that programs do not depend on the standard library's distributions.
+        class Random {
+        public:
+            explicit Random(uint64_t seed)
+                : state_(seed) {}
+
+            uint64_t Next() {
+                uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                return z ^ (z >> 31);
+            }
+
+            size_t Below(size_t bound) {
+                return bound == 0 ? 0 : static_cast<size_t>(Next() % bound);
+            }
+
+            bool Chance(double probability) {
+                return static_cast<double>(Next() >> 11) * 0x1.0p-53 < probability;
+            }
+
+        private:
+            uint64_t                                   state_;
+        };
+
+        struct MethodInfo {
+            string                                     name;
+            size_t                                     arity;
+        };
+
+        struct ClassInfo {
+            string                                     name;
+            vector<MethodInfo>                         methods;
+        };
+
+        class Generator {
+        public:
+            explicit Generator(const GeneratorOptions& options)
+                : options_(options)
+                , random_(options.seed) {}
+
+            // Generates a group of classes, stopping early once it reaches budget bytes (if not 0).
+            string Group(size_t group, size_t budget) {
+                string text;
+                vector<ClassInfo> classes;
+                for (size_t i = 0; i < options_.classes; ++i) {
+                    ClassInfo info{"C"s + to_string(group) + "_"s + to_string(i), {}};
+                    info.methods.push_back({"__init__"s, 1});
+                    for (size_t j = 1; j < options_.methods_per_class; ++j) {
+                        info.methods.push_back({"m"s + to_string(j), random_.Below(3)});
+                    }
+                    text += "class "s + info.name;
+                    if (i > 0 && random_.Chance(0.5)) {
+                        text += "("s + classes[random_.Below(i)].name + ")"s;
+                    }
+                    text += ":\n"s;
+                    for (size_t j = 0; j < info.methods.size(); ++j) {
+                        Method(text, info, j);
+                    }
+                    text += '\n';
+                    classes.push_back(move(info));
+                    if (budget != 0 && text.size() >= budget) {
+                        break;
+                    }
+                }
+                TopLevel(text, group, classes);
+                return text;
+            }
+
+        private:
+            void Method(string& text, const ClassInfo& cls, size_t index) {
+                const MethodInfo& method = cls.methods[index];
+                locals_.clear();
+                in_method_ = true;
+                text += "  def "s + method.name + "("s;
+                for (size_t i = 0; i < method.arity; ++i) {
+                    text += (i ? ", p"s : "p"s) + to_string(i);
+                    locals_.push_back("p"s + to_string(i));
+                }
+                text += "):\n"s;
+                if (index == 0) {
+                    text += "    self.f0 = p0\n"s;
+                }
+                Block(text, cls, 2, options_.nesting_depth);
+                text += "    return "s + Expression(2) + "\n"s;
+            }
+
+            void Block(string& text, const ClassInfo& cls, size_t indent, size_t depth) {
+                const StatementMix& mix = options_.mix;
+                const unsigned total = mix.assignment + mix.field_assignment + mix.print + mix.method_call
+                    + (depth > 0 ? mix.if_else : 0);
+                const string pad(indent * 2, ' ');
+                for (size_t i = 0; i < max<size_t>(options_.statements_per_block, 1); ++i) {
+                    size_t pick = random_.Below(total == 0 ? 1 : total);
+                    if (pick < mix.assignment || total == 0) {
+                        string name = "v"s + to_string(random_.Below(6));
+                        if (random_.Chance(options_.string_density)) {
+                            text += pad + name + " = "s + Text(2) + "\n"s;
+                            locals_.erase(remove(locals_.begin(), locals_.end(), name), locals_.end());
+                        }
+                        else {
+                            text += pad + name + " = "s + Number(2) + "\n"s;
+                            locals_.push_back(move(name));
+                        }
+                        continue;
+                    }
+                    pick -= mix.assignment;
+                    if (pick < mix.field_assignment) {
+                        text += pad + "self.f"s + to_string(random_.Below(4)) + " = "s + Expression(2) + "\n"s;
+                        continue;
+                    }
+                    pick -= mix.field_assignment;
+                    if (pick < mix.print) {
+                        text += pad + "print "s + Expression(1) + ", "s + Expression(1) + "\n"s;
+                        continue;
+                    }
+                    pick -= mix.print;
+                    if (pick < mix.method_call) {
+                        const MethodInfo& target = cls.methods[random_.Below(cls.methods.size())];
+                        text += pad + "self."s + target.name + "("s + Arguments(target.arity) + ")\n"s;
+                        continue;
+                    }
+                    const vector<string> scope = locals_;
+                    text += pad + "if "s + Condition() + ":\n"s;
+                    Block(text, cls, indent + 1, depth - 1);
+                    locals_ = scope;
+                    if (random_.Chance(0.5)) {
+                        text += pad + "else:\n"s;
+                        Block(text, cls, indent + 1, depth - 1);
+                        locals_ = scope;
+                    }
+                }
+            }
+
+            string Arguments(size_t arity) {
+                string text;
+                for (size_t i = 0; i < arity; ++i) {
+                    text += (i ? ", "s : ""s) + Expression(1);
+                }
+                return text;
+            }
+
+            string Condition() {
+                string text = Number(1) + (random_.Chance(0.5) ? " < "s : " == "s) + Number(1);
+                switch (random_.Below(4)) {
+                case 0:
+                    return text + " and not "s + Number(0) + " > "s + Number(0);
+                case 1:
+                    return text + " or "s + Number(0) + " != "s + Number(0);
+                default:
+                    return text;
+                }
+            }
+
+            string Expression(size_t depth) {
+                return random_.Chance(options_.string_density) ? Text(depth) : Number(depth);
+            }
+
+            string Number(size_t depth) {
+                if (depth > 0 && random_.Chance(0.5)) {
+                    static const char* const operators[] = {" + ", " - ", " * ", " / "};
+                    return Number(depth - 1) + operators[random_.Below(4)] + Number(depth - 1);
+                }
+                if (!locals_.empty() && random_.Chance(0.5)) {
+                    return locals_[random_.Below(locals_.size())];
+                }
+                if (in_method_ && random_.Chance(0.2)) {
+                    return "self.f0"s;
+                }
+                return to_string(1 + random_.Below(1000));
+            }
+
+            string Text(size_t depth) {
+                if (depth > 0 && random_.Chance(0.5)) {
+                    return Text(depth - 1) + " + "s + (random_.Chance(0.5) ? Text(depth - 1) : "str("s + Number(depth - 1) + ")"s);
+                }
+                static const char* const words[] = {"alpha", "beta", "gamma", "delta", "mython", "value", "node", "text"};
+                string literal = "'"s + words[random_.Below(8)];
+                for (size_t i = random_.Below(4); i > 0; --i) {
+                    literal += ' ';
+                    literal += words[random_.Below(8)];
+                }
+                if (random_.Chance(0.1)) {
+                    literal += "\\n"s;
+                }
+                return literal + "'"s;
+            }
+
+            void TopLevel(string& text, size_t group, const vector<ClassInfo>& classes) {
+                locals_.clear();
+                in_method_ = false;
+                for (size_t i = 0; i < classes.size(); ++i) {
+                    const string object = "o"s + to_string(group) + "_"s + to_string(i);
+                    text += object + " = "s + classes[i].name + "("s + Expression(1) + ")\n"s;
+                    const MethodInfo& method = classes[i].methods[random_.Below(classes[i].methods.size())];
+                    if (method.name != "__init__"s) {
+                        text += "print "s + object + "."s + method.name + "("s + Arguments(method.arity) + ")\n"s;
+                    }
+                }
+                text += '\n';
+            }
+
+            const GeneratorOptions& options_;
+            Random                                     random_;
+            vector<string>                             locals_;
+            bool                                       in_method_ = false;
+        };
+
+    }  // namespace
+
+    size_t GenerateProgram(const GeneratorOptions& options, ostream& output) {
+        Generator generator(options);
+        size_t written = 0;
+        size_t group = 0;
+        do {
+            const string text = generator.Group(group++, options.target_bytes - written);
+            output << text;
+            written += text.size();
+        } while (written < options.target_bytes);
+        return written;
+    }
+
+}  // namespace bench
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace bench {
+
+    // ----------------------StatementMix-----------------------
+
+    // Relative weights of the statements generated inside method bodies.
+    struct StatementMix {
+        unsigned                                       assignment = 4;
+        unsigned                                       field_assignment = 2;
+        unsigned                                       print = 1;
+        unsigned                                       method_call = 2;
+        unsigned                                       if_else = 2;
+    };
+
+    // ----------------------GeneratorOptions-----------------------
+
+    struct GeneratorOptions {
+        uint64_t                                       seed = 1;
+        size_t                                         classes = 8;
+        size_t                                         methods_per_class = 4;
+        size_t                                         statements_per_block = 4;
+        size_t                                         nesting_depth = 3;
+        StatementMix                                   mix;
+        // Probability that an expression is a string rather than a number.
+        double                                         string_density = 0.2;
+        // The program is extended with further groups of classes until it has at least this many
+        // bytes; with 0 a single group is generated.
+        size_t                                         target_bytes = 0;
+    };
+
+    // Writes a syntactically valid Mython program and returns its size in bytes. The output
+    // depends only on the options, on every platform. Each group of classes is followed by
+    // top-level statements that instantiate its classes and call their methods.
+    size_t                                             GenerateProgram(const GeneratorOptions& options, std::ostream& output);
+
+}  // namespace bench
@@ -0,0 +1,311 @@
+// Runtime benchmark of the Mython interpreter over the programs of bench::Corpus().
+//
+// Build from the repository root, for example
+//     c++ -std=c++17 -O2 -pthread -I. -o mython_bench bench/mython_bench.cpp bench/corpus.cpp $(ls *.cpp | grep -v -e main.cpp -e test)
+// and run
+//     ./mython_bench [--iterations=N] [--warmup=N] [--mode=tree|stackless|closure|sealed|all]
+//                    [--filter=SUBSTRING] [--label=TEXT] [--arena]
+//
+// Every workload is parsed once and then executed iterations times in each selected mode, each
+// time with a fresh closure and context, and with --arena inside a fresh runtime::Arena. The
+// report is one JSON document on standard output:
+//     {"schema": "mython-bench/2", "label": ..., "results": [{"workload", "mode", "iterations",
+//      "median_ns", "p99_ns", "min_ns", "heap_allocations", "heap_bytes", "slab_allocations",
+//      "slab_bytes", ["arena_bytes", "arena_blocks",] "output_bytes"}, ...]}
+// Allocation counts are those of one execution. The heap ones come from every replaceable
+// operator new, including the aligned one runtime::Slab carves its slabs from; the slab ones are
+// the blocks handed out by runtime::Slab, which never reach operator new one by one, and the
+// arena ones what the execution's arena carved for objects.
+
+#include "arena.h"
+#include "corpus.h"
+#include "lexer.h"
+#include "program.h"
+#include "slab.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    atomic<size_t> allocations{0};
+    atomic<size_t> allocated_bytes{0};
+
+    void Count(size_t size) {
+        allocations.fetch_add(1, memory_order_relaxed);
+        allocated_bytes.fetch_add(size, memory_order_relaxed);
+    }
+
+}  // namespace
+
+[[gnu::noinline]] void* operator new(size_t size) {
+    Count(size);
+    if (void* pointer = malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(size_t size, align_val_t alignment) {
+    Count(size);
+    const size_t align = max(static_cast<size_t>(alignment), sizeof(void*));
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    if (void* pointer = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, align_val_t /*alignment*/) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/, align_val_t /*alignment*/) noexcept {
+    free(pointer);
+}
+
+namespace bench {
+
+    namespace {
+
+        // ----------------------Options-----------------------
+
+        struct Options {
+            size_t                                     iterations = 20;
+            size_t                                     warmup = 2;
+            vector<ExecutionMode>                      modes = {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS,
+                                                                ExecutionMode::CLOSURE_COMPILED, ExecutionMode::SEALED_TREE};
+            string                                     filter;
+            string                                     label;
+            bool                                       arena = false;
+        };
+
+        // ----------------------Result-----------------------
+
+        struct Result {
+            string                                     workload;
+            ExecutionMode                              mode = ExecutionMode::TREE_WALKING;
+            vector<chrono::nanoseconds>                times;
+            size_t                                     heap_allocations = 0;
+            size_t                                     heap_bytes = 0;
+            size_t                                     slab_allocations = 0;
+            size_t                                     slab_bytes = 0;
+            optional<size_t>                           arena_bytes;
+            size_t                                     arena_blocks = 0;
+            size_t                                     output_bytes = 0;
+            string                                     error;
+        };
+
+        const char* ModeName(ExecutionMode mode) {
+            switch (mode) {
+            case ExecutionMode::TREE_WALKING:
+                return "tree";
+            case ExecutionMode::STACKLESS:
+                return "stackless";
+            case ExecutionMode::CLOSURE_COMPILED:
+                return "closure";
+            case ExecutionMode::SEALED_TREE:
+                return "sealed";
+            }
+            return "unknown";
+        }
+
+        bool ParseMode(string_view name, vector<ExecutionMode>& modes) {
+            if (name == "all"sv) {
+                modes = Options{}.modes;
+                return true;
+            }
+            for (ExecutionMode mode : Options{}.modes) {
+                if (name == ModeName(mode)) {
+                    modes = {mode};
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool ParseOptions(int argc, char** argv, Options& options) {
+            for (int i = 1; i < argc; ++i) {
+                const string_view argument = argv[i];
+                const size_t equals = argument.find('=');
+                const string_view key = argument.substr(0, equals);
+                const string value(equals == string_view::npos ? ""sv : argument.substr(equals + 1));
+                if (key == "--iterations"sv) {
+                    options.iterations = max<size_t>(1, stoul(value));
+                }
+                else if (key == "--warmup"sv) {
+                    options.warmup = stoul(value);
+                }
+                else if (key == "--mode"sv) {
+                    if (!ParseMode(value, options.modes)) {
+                        return false;
+                    }
+                }
+                else if (key == "--filter"sv) {
+                    options.filter = value;
+                }
+                else if (key == "--label"sv) {
+                    options.label = value;
+                }
+                else if (argument == "--arena"sv) {
+                    options.arena = true;
+                }
+                else {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Nearest-rank percentile of sorted samples.
+        chrono::nanoseconds Percentile(const vector<chrono::nanoseconds>& sorted, size_t percent) {
+            const size_t rank = (sorted.size() * percent + 99) / 100;
+            return sorted[max<size_t>(rank, 1) - 1];
+        }
+
+        // Blocks handed out by runtime::Slab so far, and their bytes.
+        pair<size_t, size_t> SlabTotals() {
+            pair<size_t, size_t> totals;
+            for (const auto& stats : runtime::Slab::GetStats()) {
+                totals.first += stats.allocations;
+                totals.second += stats.allocations * stats.block_size;
+            }
+            return totals;
+        }
+
+        Result Measure(const Workload& workload, const Program& program, ExecutionMode mode, const Options& options) {
+            Result result;
+            result.workload = workload.name;
+            result.mode = mode;
+            for (size_t i = 0; i < options.warmup + options.iterations; ++i) {
+                optional<runtime::Arena> arena;
+                optional<runtime::Arena::Scope> arena_scope;
+                if (options.arena) {
+                    arena_scope.emplace(arena.emplace());
+                }
+                runtime::DummyContext context;
+                runtime::Closure closure;
+                const size_t allocations_before = allocations.load(memory_order_relaxed);
+                const size_t bytes_before = allocated_bytes.load(memory_order_relaxed);
+                const auto slab_before = SlabTotals();
+                const auto start = chrono::steady_clock::now();
+                try {
+                    program.Execute(closure, context, mode);
+                }
+                catch (const exception& error) {
+                    result.error = error.what();
+                    return result;
+                }
+                const auto elapsed = chrono::steady_clock::now() - start;
+                if (i < options.warmup) {
+                    continue;
+                }
+                const auto slab_after = SlabTotals();
+                result.times.push_back(chrono::duration_cast<chrono::nanoseconds>(elapsed));
+                result.heap_allocations = allocations.load(memory_order_relaxed) - allocations_before;
+                result.heap_bytes = allocated_bytes.load(memory_order_relaxed) - bytes_before;
+                result.slab_allocations = slab_after.first - slab_before.first;
+                result.slab_bytes = slab_after.second - slab_before.second;
+                if (arena) {
+                    result.arena_bytes = arena->GetAllocatedBytes();
+                    result.arena_blocks = arena->GetBlockCount();
+                }
+                result.output_bytes = context.output.str().size();
+            }
+            return result;
+        }
+
+        string Quote(string_view text) {
+            string quoted = "\"";
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    quoted += '\\';
+                    quoted += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20) {
+                    static const char digits[] = "0123456789abcdef";
+                    quoted += "\\u00";
+                    quoted += digits[(c >> 4) & 0xF];
+                    quoted += digits[c & 0xF];
+                }
+                else {
+                    quoted += c;
+                }
+            }
+            return quoted + '"';
+        }
+
+        void Report(ostream& out, const Options& options, vector<Result>& results) {
+            out << "{\n  \"schema\": \"mython-bench/2\",\n  \"label\": " << Quote(options.label)
+                << ",\n  \"iterations\": " << options.iterations << ",\n  \"results\": [";
+            for (size_t i = 0; i < results.size(); ++i) {
+                Result& result = results[i];
+                out << (i ? ",\n" : "\n") << "    {\"workload\": " << Quote(result.workload)
+                    << ", \"mode\": " << Quote(ModeName(result.mode));
+                if (!result.error.empty()) {
+                    out << ", \"error\": " << Quote(result.error) << '}';
+                    continue;
+                }
+                sort(result.times.begin(), result.times.end());
+                out << ", \"iterations\": " << result.times.size()
+                    << ", \"median_ns\": " << Percentile(result.times, 50).count()
+                    << ", \"p99_ns\": " << Percentile(result.times, 99).count()
+                    << ", \"min_ns\": " << result.times.front().count()
+                    << ", \"heap_allocations\": " << result.heap_allocations
+                    << ", \"heap_bytes\": " << result.heap_bytes
+                    << ", \"slab_allocations\": " << result.slab_allocations
+                    << ", \"slab_bytes\": " << result.slab_bytes;
+                if (result.arena_bytes) {
+                    out << ", \"arena_bytes\": " << *result.arena_bytes << ", \"arena_blocks\": " << result.arena_blocks;
+                }
+                out << ", \"output_bytes\": " << result.output_bytes << '}';
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    }  // namespace
+
+}  // namespace bench
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    if (!bench::ParseOptions(argc, argv, options)) {
+        cerr << "usage: " << argv[0] << " [--iterations=N] [--warmup=N] [--mode=tree|stackless|closure|sealed|all]"
+             << " [--filter=SUBSTRING] [--label=TEXT] [--arena]" << endl;
+        return 2;
+    }
+
+    vector<bench::Result> results;
+    for (const auto& workload : bench::Corpus()) {
+        if (workload.name.find(options.filter) == string::npos) {
+            continue;
+        }
+        istringstream input(workload.source);
+        parse::Lexer lexer(input);
+        auto program = CompileProgram(lexer);
+        for (ExecutionMode mode : options.modes) {
+            results.push_back(bench::Measure(workload, *program, mode, options));
+        }
+    }
+    bench::Report(cout, options, results);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "budget.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace runtime {
+
+    // ----------------------BudgetExceededError-----------------------
+
+    BudgetExceededError::BudgetExceededError(Reason reason)
+        : runtime_error(reason == Reason::STEPS ? "Execution budget exceeded: step limit"s
+                                                : "Execution budget exceeded: deadline"s)
+        , reason_(reason) {}
+
+    BudgetExceededError::Reason BudgetExceededError::GetReason() const {
+        return reason_;
+    }
+
+    // ----------------------ExecutionBudget-----------------------
+
+    ExecutionBudget::ExecutionBudget(size_t max_steps, Clock::time_point deadline)
+        : max_steps_(max_steps)
+        , deadline_(deadline) {}
+
+    ExecutionBudget ExecutionBudget::WithTimeout(Clock::duration timeout, size_t max_steps) {
+        return ExecutionBudget(max_steps, Clock::now() + timeout);
+    }
+
+    size_t ExecutionBudget::GetStepsUsed() const {
+        return used_ + granted_ - countdown_;
+    }
+
+    size_t ExecutionBudget::GetClockReads() const {
+        return clock_reads_;
+    }
+
+    void ExecutionBudget::Refill() {
+        used_ += granted_;
+        granted_ = 0;
+        if (used_ >= max_steps_) {
+            throw BudgetExceededError(BudgetExceededError::Reason::STEPS);
+        }
+        if (deadline_ != Clock::time_point::max()) {
+            ++clock_reads_;
+            if (Clock::now() >= deadline_) {
+                throw BudgetExceededError(BudgetExceededError::Reason::DEADLINE);
+            }
+        }
+        granted_ = min(CLOCK_CHECK_INTERVAL, max_steps_ - used_);
+        countdown_ = granted_;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+namespace runtime {
+
+    // ----------------------BudgetExceededError-----------------------
+
+    class BudgetExceededError : public std::runtime_error {
+    public:
+        enum class Reason {
+            STEPS,
+            DEADLINE
+        };
+
+        explicit                                       BudgetExceededError(Reason reason);
+
+        [[nodiscard]] Reason                           GetReason() const;
+
+    private:
+        Reason                                         reason_;
+    };
+
+    // ----------------------ExecutionBudget-----------------------
+
+    // Limits how many steps (statements and method calls) an execution may take and until when it
+    // may run. Charge is a counter decrement on the fast path; the step limit and the clock are
+    // only checked once per CLOCK_CHECK_INTERVAL steps. Once exhausted, every further Charge throws.
+    class ExecutionBudget {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t                        UNLIMITED = std::numeric_limits<size_t>::max();
+        static constexpr size_t                        CLOCK_CHECK_INTERVAL = 1024;
+
+        ExecutionBudget() = default;
+
+        explicit                                       ExecutionBudget(size_t max_steps,
+                                                                       Clock::time_point deadline = Clock::time_point::max());
+
+        [[nodiscard]] static ExecutionBudget           WithTimeout(Clock::duration timeout, size_t max_steps = UNLIMITED);
+
+        void                                           Charge();
+
+        [[nodiscard]] size_t                           GetStepsUsed() const;
+
+        [[nodiscard]] size_t                           GetClockReads() const;
+
+    private:
+        void                                           Refill();
+
+        size_t                                         max_steps_ = UNLIMITED;
+        Clock::time_point                              deadline_ = Clock::time_point::max();
+        size_t                                         used_ = 0;
+        size_t                                         granted_ = 0;
+        size_t                                         countdown_ = 0;
+        size_t                                         clock_reads_ = 0;
+    };
+
+    inline void ExecutionBudget::Charge() {
+        if (countdown_ == 0) {
+            Refill();
+        }
+        --countdown_;
+    }
+
+}  // namespace runtime
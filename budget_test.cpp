@@ -0,0 +1,144 @@
+#include "executor.h"
+#include "scheduler.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+#include <thread>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string RECURSIVE_PROGRAM = R"(
+class Walker:
+  def down(n):
+    if n == 0:
+      return 0
+    return self.down(n - 1) + 1
+
+w = Walker()
+print w.down(n)
+)"s;
+
+string RunWithBudget(const Program& program, ExecutionBudget& budget, int n, ExecutionMode mode) {
+    DummyContext context;
+    context.SetBudget(&budget);
+    Closure closure;
+    closure["n"s] = ObjectHolder::Own(Number(n));
+    program.Execute(closure, context, mode);
+    return context.output.str();
+}
+
+void TestBudgetCountsSteps() {
+    ExecutionBudget budget(10);
+    for (int i = 0; i < 10; ++i) {
+        budget.Charge();
+    }
+    ASSERT_EQUAL(budget.GetStepsUsed(), 10U);
+    ASSERT_EQUAL(budget.GetClockReads(), 0U);
+    try {
+        budget.Charge();
+        ASSERT(false);
+    }
+    catch (const BudgetExceededError& error) {
+        ASSERT(error.GetReason() == BudgetExceededError::Reason::STEPS);
+    }
+    ASSERT_THROWS(budget.Charge(), BudgetExceededError);
+}
+
+void TestDeadlineReadsClockRarely() {
+    auto budget = ExecutionBudget::WithTimeout(chrono::hours(1));
+    for (size_t i = 0; i < 100 * ExecutionBudget::CLOCK_CHECK_INTERVAL; ++i) {
+        budget.Charge();
+    }
+    ASSERT_EQUAL(budget.GetClockReads(), 100U);
+
+    auto expired = ExecutionBudget::WithTimeout(chrono::milliseconds(5));
+    this_thread::sleep_for(chrono::milliseconds(10));
+    try {
+        expired.Charge();
+        ASSERT(false);
+    }
+    catch (const BudgetExceededError& error) {
+        ASSERT(error.GetReason() == BudgetExceededError::Reason::DEADLINE);
+    }
+}
+
+void TestInterpretersEnforceBudget() {
+    auto program = CompileFromString(RECURSIVE_PROGRAM);
+    for (auto mode : {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS, ExecutionMode::CLOSURE_COMPILED,
+                      ExecutionMode::SEALED_TREE}) {
+        ExecutionBudget enough(1000);
+        ASSERT_EQUAL(RunWithBudget(*program, enough, 50, mode), "50\n"s);
+        ASSERT(enough.GetStepsUsed() > 100);
+
+        ExecutionBudget small(100);
+        ASSERT_THROWS(RunWithBudget(*program, small, 1000, mode), BudgetExceededError);
+        ASSERT_EQUAL(small.GetStepsUsed(), 100U);
+    }
+}
+
+void TestCallsChargeOneStepInEveryMode() {
+    auto program = CompileFromString(R"(
+class Walker:
+  def __init__():
+    self.x = 1
+
+  def __str__():
+    return 'w'
+
+  def __add__(other):
+    return other
+
+  def down(n):
+    if n == 0:
+      return 0
+    return self.down(n - 1) + 1
+
+w = Walker()
+print w.down(n), w, w + 1
+)"s);
+    vector<size_t> steps;
+    for (auto mode : {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS, ExecutionMode::CLOSURE_COMPILED,
+                      ExecutionMode::SEALED_TREE}) {
+        ExecutionBudget budget(1000);
+        ASSERT_EQUAL(RunWithBudget(*program, budget, 50, mode), "50 w 1\n"s);
+        steps.push_back(budget.GetStepsUsed());
+    }
+    for (const size_t used : steps) {
+        ASSERT_EQUAL(used, steps.front());
+    }
+}
+
+void TestJobsCarryBudget() {
+    auto program = CompileFromString(RECURSIVE_PROGRAM);
+    auto make_job = [&program](size_t max_steps) {
+        Job job{program, {}, nullptr, ExecutionBudget(max_steps)};
+        job.inputs["n"s] = ObjectHolder::Own(Number(500));
+        return job;
+    };
+
+    Executor executor(1);
+    ASSERT(executor.Submit(make_job(ExecutionBudget::UNLIMITED)).get().ok);
+    JobResult result = executor.Submit(make_job(200)).get();
+    ASSERT(!result.ok);
+    ASSERT_EQUAL(result.error, "Execution budget exceeded: step limit"s);
+
+    Scheduler scheduler(1, 10);
+    ASSERT(scheduler.Submit(make_job(ExecutionBudget::UNLIMITED)).get().ok);
+    ASSERT(!scheduler.Submit(make_job(200)).get().ok);
+}
+
+}  // namespace
+
+void RunBudgetTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestBudgetCountsSteps);
+    RUN_TEST(tr, runtime::TestDeadlineReadsClockRarely);
+    RUN_TEST(tr, runtime::TestInterpretersEnforceBudget);
+    RUN_TEST(tr, runtime::TestCallsChargeOneStepInEveryMode);
+    RUN_TEST(tr, runtime::TestJobsCarryBudget);
+}
+
+}  // namespace runtime
@@ -0,0 +1,179 @@
+#include "buffered_context.h"
+
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+#ifdef IOV_MAX
+        constexpr size_t MAX_IOVECS = IOV_MAX;
+#else
+        constexpr size_t MAX_IOVECS = 1024;
+#endif
+    }  // namespace
+
+    // ----------------------StreamBuffer-----------------------
+
+    BufferedContext::StreamBuffer::StreamBuffer(BufferedContext& owner)
+        : owner_(owner) {}
+
+    BufferedContext::StreamBuffer::int_type BufferedContext::StreamBuffer::overflow(int_type c) {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            const char ch = traits_type::to_char_type(c);
+            owner_.Write(string_view(&ch, 1));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    streamsize BufferedContext::StreamBuffer::xsputn(const char* s, streamsize n) {
+        owner_.Write(string_view(s, static_cast<size_t>(n)));
+        return n;
+    }
+
+    // ----------------------BufferedContext-----------------------
+
+    BufferedContext::BufferedContext(int fd, FlushPolicy policy, size_t capacity)
+        : fd_(fd)
+        , policy_(policy)
+        , capacity_(max<size_t>(capacity, 1))
+        , stream_buffer_(*this)
+        , stream_(&stream_buffer_) {}
+
+    BufferedContext::~BufferedContext() {
+        if (policy_ == FlushPolicy::ON_DEMAND) {
+            return;
+        }
+        try {
+            Flush();
+        }
+        catch (...) {
+        }
+    }
+
+    std::ostream& BufferedContext::GetOutputStream() {
+        return stream_;
+    }
+
+    void BufferedContext::Write(std::string_view data) {
+        if (data.empty()) {
+            return;
+        }
+        if (chunks_.empty()) {
+            chunks_.emplace_back().reserve(capacity_);
+        }
+        string& last = chunks_.back();
+        if (last.size() + data.size() < capacity_) {
+            last.append(data);
+            buffered_size_ += data.size();
+            return;
+        }
+        if (policy_ == FlushPolicy::ON_SIZE) {
+            WriteChunks(data);
+            return;
+        }
+        while (!data.empty()) {
+            string& chunk = chunks_.back();
+            if (chunk.size() == capacity_) {
+                chunks_.emplace_back().reserve(capacity_);
+                continue;
+            }
+            const size_t part = min(capacity_ - chunk.size(), data.size());
+            chunk.append(data.substr(0, part));
+            buffered_size_ += part;
+            data.remove_prefix(part);
+        }
+    }
+
+    void BufferedContext::Flush() {
+        WriteChunks({});
+    }
+
+    size_t BufferedContext::GetBytesWritten() const {
+        return bytes_written_;
+    }
+
+    size_t BufferedContext::GetBufferedSize() const {
+        return buffered_size_;
+    }
+
+    size_t BufferedContext::GetWriteCalls() const {
+        return write_calls_;
+    }
+
+    void BufferedContext::WriteChunks(std::string_view tail) {
+        vector<iovec> iov;
+        iov.reserve(chunks_.size() + 1);
+        for (string& chunk : chunks_) {
+            if (!chunk.empty()) {
+                iov.push_back({chunk.data(), chunk.size()});
+            }
+        }
+        if (!tail.empty()) {
+            iov.push_back({const_cast<char*>(tail.data()), tail.size()});
+        }
+        trace::Tracer::Span span("io", nullptr, "flush"sv, "bytes", buffered_size_ + tail.size());
+
+        size_t first = 0;
+        size_t total = 0;
+        while (first < iov.size()) {
+            const size_t count = min(iov.size() - first, MAX_IOVECS);
+            const ssize_t written = count == 1
+                ? ::write(fd_, iov[first].iov_base, iov[first].iov_len)
+                : ::writev(fd_, iov.data() + first, static_cast<int>(count));
+            ++write_calls_;
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                const int error = errno;
+                KeepUnwritten(total, tail);
+                throw system_error(error, generic_category(), "BufferedContext write failed"s);
+            }
+            bytes_written_ += static_cast<size_t>(written);
+            total += static_cast<size_t>(written);
+            size_t rest = static_cast<size_t>(written);
+            while (first < iov.size() && rest >= iov[first].iov_len) {
+                rest -= iov[first].iov_len;
+                ++first;
+            }
+            if (rest > 0) {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + rest;
+                iov[first].iov_len -= rest;
+            }
+        }
+
+        chunks_.resize(min<size_t>(chunks_.size(), 1));
+        if (!chunks_.empty()) {
+            chunks_.front().clear();
+        }
+        buffered_size_ = 0;
+    }
+
+    void BufferedContext::KeepUnwritten(size_t written, std::string_view tail) {
+        string rest;
+        rest.reserve(buffered_size_ + tail.size() - written);
+        for (const string& chunk : chunks_) {
+            const size_t skip = min(written, chunk.size());
+            rest.append(chunk, skip, string::npos);
+            written -= skip;
+        }
+        rest.append(tail.substr(min(written, tail.size())));
+
+        chunks_.clear();
+        buffered_size_ = rest.size();
+        for (size_t offset = 0; offset < rest.size(); offset += capacity_) {
+            chunks_.push_back(rest.substr(offset, capacity_));
+        }
+    }
+
+}  // namespace runtime
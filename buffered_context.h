@@ -0,0 +1,80 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace runtime {
+
+    // ----------------------FlushPolicy-----------------------
+
+    enum class FlushPolicy {
+        ON_SIZE,    // write a chunk as soon as it fills up, the rest on destruction
+        AT_EXIT,    // keep everything buffered and write it on destruction
+        ON_DEMAND   // write only on explicit Flush(), unflushed output is discarded
+    };
+
+    // ----------------------BufferedContext-----------------------
+
+    class BufferedContext : public Context {
+    public:
+        static constexpr size_t                        DEFAULT_CAPACITY = 1 << 20;
+
+        explicit                                       BufferedContext(int fd,
+            FlushPolicy policy = FlushPolicy::ON_SIZE,
+            size_t capacity = DEFAULT_CAPACITY);
+
+        BufferedContext(const BufferedContext&) = delete;
+        BufferedContext& operator=(const BufferedContext&) = delete;
+
+        ~BufferedContext();
+
+        std::ostream& GetOutputStream() override;
+
+        void                                           Write(std::string_view data) override;
+
+        void                                           Flush();
+
+        [[nodiscard]] size_t                           GetBytesWritten() const;
+
+        [[nodiscard]] size_t                           GetBufferedSize() const;
+
+        [[nodiscard]] size_t                           GetWriteCalls() const;
+
+    private:
+        class StreamBuffer : public std::streambuf {
+        public:
+            explicit                                   StreamBuffer(BufferedContext& owner);
+
+        protected:
+            int_type                                   overflow(int_type c) override;
+
+            std::streamsize                            xsputn(const char* s, std::streamsize n) override;
+
+        private:
+            BufferedContext& owner_;
+        };
+
+        void                                           WriteChunks(std::string_view tail);
+
+        // After a failed write: drops the first written bytes of the buffer followed by tail,
+        // so that they are not written twice, and keeps the rest for the next flush.
+        void                                           KeepUnwritten(size_t written, std::string_view tail);
+
+        int                                            fd_;
+        FlushPolicy                                    policy_;
+        size_t                                         capacity_;
+        std::vector<std::string>                       chunks_;
+        size_t                                         buffered_size_ = 0;
+        size_t                                         bytes_written_ = 0;
+        size_t                                         write_calls_ = 0;
+        StreamBuffer                                   stream_buffer_;
+        std::ostream                                   stream_;
+    };
+
+}  // namespace runtime
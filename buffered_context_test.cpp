@@ -0,0 +1,172 @@
+#include "buffered_context.h"
+#include "lexer.h"
+#include "parse.h"
+#include "test_runner_p.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <system_error>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+class Pipe {
+public:
+    Pipe() {
+        ASSERT(::pipe(fds_) == 0);
+    }
+
+    ~Pipe() {
+        ::close(fds_[0]);
+        ::close(fds_[1]);
+    }
+
+    [[nodiscard]] int WriteEnd() const {
+        return fds_[1];
+    }
+
+    string ReadAvailable() {
+        ::close(fds_[1]);
+        fds_[1] = -1;
+        string result;
+        char buffer[4096];
+        for (ssize_t n; (n = ::read(fds_[0], buffer, sizeof(buffer))) > 0;) {
+            result.append(buffer, static_cast<size_t>(n));
+        }
+        return result;
+    }
+
+private:
+    int fds_[2] = {-1, -1};
+};
+
+void TestBufferedContextFlushOnSize() {
+    Pipe pipe;
+    size_t bytes_written = 0;
+    {
+        BufferedContext context(pipe.WriteEnd(), FlushPolicy::ON_SIZE, 8);
+        context.Write("abc"sv);
+        ASSERT_EQUAL(context.GetBytesWritten(), 0U);
+        ASSERT_EQUAL(context.GetBufferedSize(), 3U);
+
+        context.Write("defghijkl"sv);
+        ASSERT_EQUAL(context.GetBytesWritten(), 12U);
+        ASSERT_EQUAL(context.GetBufferedSize(), 0U);
+        ASSERT_EQUAL(context.GetWriteCalls(), 1U);
+
+        context.GetOutputStream() << "mn"sv << 5;
+        ASSERT_EQUAL(context.GetBufferedSize(), 3U);
+        bytes_written = context.GetBytesWritten();
+    }
+    ASSERT_EQUAL(bytes_written, 12U);
+    ASSERT_EQUAL(pipe.ReadAvailable(), "abcdefghijklmn5"s);
+}
+
+void TestBufferedContextAtExit() {
+    Pipe pipe;
+    {
+        BufferedContext context(pipe.WriteEnd(), FlushPolicy::AT_EXIT, 4);
+        for (int i = 0; i < 10; ++i) {
+            context.Write("line\n"sv);
+        }
+        ASSERT_EQUAL(context.GetBytesWritten(), 0U);
+        ASSERT_EQUAL(context.GetBufferedSize(), 50U);
+    }
+    string expected;
+    for (int i = 0; i < 10; ++i) {
+        expected += "line\n"s;
+    }
+    ASSERT_EQUAL(pipe.ReadAvailable(), expected);
+}
+
+void TestBufferedContextOnDemand() {
+    Pipe pipe;
+    {
+        BufferedContext context(pipe.WriteEnd(), FlushPolicy::ON_DEMAND, 4);
+        context.Write("kept "sv);
+        context.Flush();
+        ASSERT_EQUAL(context.GetBytesWritten(), 5U);
+        ASSERT_EQUAL(context.GetWriteCalls(), 1U);
+        context.Write("dropped"sv);
+    }
+    ASSERT_EQUAL(pipe.ReadAvailable(), "kept "s);
+}
+
+void TestBufferedContextKeepsUnwrittenOutput() {
+    // A non-blocking pipe takes only part of the output and then fails with EAGAIN.
+    int fds[2];
+    ASSERT(::pipe2(fds, O_NONBLOCK) == 0);
+    string expected;
+    for (int i = 0; i < 40000; ++i) {
+        expected += to_string(i) + '\n';
+    }
+
+    string received;
+    auto drain = [&received, read_end = fds[0]] {
+        char buffer[4096];
+        for (ssize_t n; (n = ::read(read_end, buffer, sizeof(buffer))) > 0;) {
+            received.append(buffer, static_cast<size_t>(n));
+        }
+    };
+    {
+        BufferedContext context(fds[1], FlushPolicy::ON_DEMAND, 1000);
+        context.Write(expected);
+        ASSERT_THROWS(context.Flush(), system_error);
+        ASSERT(context.GetBufferedSize() < expected.size());
+        ASSERT_EQUAL(context.GetBufferedSize() + context.GetBytesWritten(), expected.size());
+        for (bool done = false; !done;) {
+            drain();
+            try {
+                context.Flush();
+                done = true;
+            }
+            catch (const system_error&) {
+            }
+        }
+        drain();
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+    ASSERT_EQUAL(received.size(), expected.size());
+    ASSERT(received == expected);
+}
+
+void TestBufferedContextRunsProgram() {
+    istringstream input(R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def __str__():
+    return '(' + str(self.x) + ', ' + str(self.y) + ')'
+
+print Point(1, -2), 'done', True, None
+)");
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+
+    Pipe pipe;
+    {
+        BufferedContext context(pipe.WriteEnd());
+        Closure closure;
+        program->Execute(closure, context);
+    }
+    ASSERT_EQUAL(pipe.ReadAvailable(), "(1, -2) done True None\n"s);
+}
+
+}  // namespace
+
+void RunBufferedContextTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestBufferedContextFlushOnSize);
+    RUN_TEST(tr, runtime::TestBufferedContextAtExit);
+    RUN_TEST(tr, runtime::TestBufferedContextOnDemand);
+    RUN_TEST(tr, runtime::TestBufferedContextKeepsUnwrittenOutput);
+    RUN_TEST(tr, runtime::TestBufferedContextRunsProgram);
+}
+
+}  // namespace runtime
@@ -0,0 +1,632 @@
+#include "compiled.h"
+
+#include "jit.h"
+#include "statement.h"
+
+#include <optional>
+
+using namespace std;
+
+namespace compiled {
+
+    using runtime::Closure;
+    using runtime::Context;
+    using runtime::ObjectHolder;
+
+    namespace {
+        const string ADD_METHOD = "__add__"s;
+        const string INIT_METHOD = "__init__"s;
+        const string SELF = "self"s;
+
+        using Comparator = bool (*)(const ObjectHolder&, const ObjectHolder&, Context&);
+
+        // Thrown while compiling a method that contains a statement this backend does not know.
+        struct Unsupported {};
+    }  // namespace
+
+    // ----------------------Frame-----------------------
+
+    struct Slot {
+        ObjectHolder                                   value;
+        bool                                           defined = false;
+    };
+
+    struct Frame {
+        Frame(const Module& module, Context& context)
+            : module(module)
+            , context(context) {}
+
+        const Module& module;
+        Context& context;
+        Closure* globals = nullptr;
+        Slot* slots = nullptr;
+        ObjectHolder                                   result;
+        bool                                           returning = false;
+    };
+
+    namespace {
+
+        // ----------------------Operands-----------------------
+
+        struct ConstOperand {
+            ObjectHolder                               value;
+
+            const ObjectHolder& operator()(Frame& /*frame*/) const {
+                return value;
+            }
+        };
+
+        struct SlotOperand {
+            size_t                                     slot;
+            string                                     name;
+
+            const ObjectHolder& operator()(Frame& frame) const {
+                const Slot& local = frame.slots[slot];
+                if (!local.defined) {
+                    throw runtime_error("Not field"s + name);
+                }
+                return local.value;
+            }
+        };
+
+        struct NodeOperand {
+            Node                                       node;
+
+            ObjectHolder operator()(Frame& frame) const {
+                return node(frame);
+            }
+        };
+
+        // ----------------------Operations-----------------------
+
+        template <typename T, typename Operation>
+        optional<ObjectHolder> ApplyTo(const ObjectHolder& lhs, const ObjectHolder& rhs, Operation operation) {
+            const auto* left = lhs.TryAs<T>();
+            const auto* right = rhs.TryAs<T>();
+            if (left && right) {
+                return ObjectHolder::Own(T(operation(left->GetValue(), right->GetValue())));
+            }
+            return nullopt;
+        }
+
+        struct AddOperation {
+            static ObjectHolder Apply(const ObjectHolder& lhs, const ObjectHolder& rhs, Frame& frame) {
+                if (auto result = ApplyTo<runtime::Number>(lhs, rhs, plus<int>()); result) {
+                    return move(*result);
+                }
+                if (auto result = ApplyTo<runtime::String>(lhs, rhs, plus<string>()); result) {
+                    return move(*result);
+                }
+                if (auto ptr = lhs.TryAs<runtime::ClassInstance>(); ptr) {
+                    return frame.module.Call(*ptr, ADD_METHOD, {rhs}, frame.context);
+                }
+                throw runtime_error("The operator is not overloaded +"s);
+            }
+        };
+
+        struct SubOperation {
+            static ObjectHolder Apply(const ObjectHolder& lhs, const ObjectHolder& rhs, Frame& /*frame*/) {
+                if (auto result = ApplyTo<runtime::Number>(lhs, rhs, minus<int>()); result) {
+                    return move(*result);
+                }
+                throw runtime_error("The operator is not overloaded -"s);
+            }
+        };
+
+        struct MultOperation {
+            static ObjectHolder Apply(const ObjectHolder& lhs, const ObjectHolder& rhs, Frame& /*frame*/) {
+                if (auto result = ApplyTo<runtime::Number>(lhs, rhs, multiplies<int>()); result) {
+                    return move(*result);
+                }
+                throw runtime_error("The operator is not overloaded *"s);
+            }
+        };
+
+        struct DivOperation {
+            static ObjectHolder Apply(const ObjectHolder& lhs, const ObjectHolder& rhs, Frame& /*frame*/) {
+                const auto ptr_left = lhs.TryAs<runtime::Number>();
+                const auto ptr_right = rhs.TryAs<runtime::Number>();
+                if (ptr_left && ptr_right) {
+                    if (ptr_right->GetValue() != 0) {
+                        return ObjectHolder::Own(runtime::Number(ptr_left->GetValue() / ptr_right->GetValue()));
+                    }
+                    throw runtime_error("The denominator is zero"s);
+                }
+                throw runtime_error("The operator is not overloaded /"s);
+            }
+        };
+
+        template <Comparator comparator>
+        struct CompareOperation {
+            static ObjectHolder Apply(const ObjectHolder& lhs, const ObjectHolder& rhs, Frame& frame) {
+                return ObjectHolder::Own(runtime::Bool(comparator(lhs, rhs, frame.context)));
+            }
+        };
+
+        template <typename Operation, typename Lhs, typename Rhs>
+        Node MakeBinary(Lhs lhs, Rhs rhs) {
+            return [lhs = move(lhs), rhs = move(rhs)](Frame& frame) -> ObjectHolder {
+                const ObjectHolder& left = lhs(frame);
+                const ObjectHolder& right = rhs(frame);
+                return Operation::Apply(left, right, frame);
+            };
+        }
+
+        ObjectHolder LoadFields(ObjectHolder object, const vector<string>& ids) {
+            for (size_t i = 1; i < ids.size(); ++i) {
+                auto ptr_obj = object.TryAs<runtime::ClassInstance>();
+                if (!ptr_obj) {
+                    throw runtime_error("This isn't object"s);
+                }
+                const Closure& fields = ptr_obj->Fields();
+                auto it = fields.find(ids[i]);
+                if (it == fields.end()) {
+                    throw runtime_error("Not field"s + ids[i]);
+                }
+                object = it->second;
+            }
+            return object;
+        }
+
+        ObjectHolder LoadGlobal(const Closure& globals, const string& name) {
+            auto it = globals.find(name);
+            if (it == globals.end()) {
+                throw runtime_error("Not field"s + name);
+            }
+            return it->second;
+        }
+
+    }  // namespace
+
+    // ----------------------Compiler-----------------------
+
+    class Compiler {
+    public:
+        // Compiles the main program; method locals are not used.
+        explicit Compiler(Module& module)
+            : module_(module) {}
+
+        // Compiles a method body against the slots of function.
+        Compiler(Module& module, Function& function)
+            : module_(module)
+            , function_(&function) {}
+
+        Node CompileMain(runtime::Executable& program) {
+            return CompileNode(program);
+        }
+
+        static void CompileClass(Module& module, const runtime::Class& cls) {
+            for (const auto& method : cls.GetMethods()) {
+                if (module.methods_.count(&method)) {
+                    continue;
+                }
+                auto* body = dynamic_cast<ast::MethodBody*>(method.body.get());
+                if (!body) {
+                    module.methods_.emplace(&method, nullptr);
+                    continue;
+                }
+                auto& function = module.methods_[&method];
+                function = make_unique<Function>();
+                function->slot_names = method.formal_params;
+                function->param_count = method.formal_params.size();
+                try {
+                    Compiler compiler(module, *function);
+                    function->self_slot = compiler.SlotFor(SELF);
+                    function->body = compiler.CompileNode(*body->GetBody());
+                }
+                catch (const Unsupported&) {
+                    module.methods_[&method] = nullptr;
+                }
+            }
+            if (cls.GetParent()) {
+                CompileClass(module, *cls.GetParent());
+            }
+        }
+
+    private:
+        size_t SlotFor(const string& name) {
+            auto& names = function_->slot_names;
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (names[i] == name) {
+                    return i;
+                }
+            }
+            names.push_back(name);
+            return names.size() - 1;
+        }
+
+        optional<size_t> FindSlot(const string& name) const {
+            const auto& names = function_->slot_names;
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (names[i] == name) {
+                    return i;
+                }
+            }
+            return nullopt;
+        }
+
+        void DeclareLocals(const runtime::Executable& statement) {
+            if (auto node = dynamic_cast<const ast::Assignment*>(&statement); node) {
+                SlotFor(node->GetName());
+            }
+            else if (auto node = dynamic_cast<const ast::Compound*>(&statement); node) {
+                for (const auto& child : node->GetStatements()) {
+                    DeclareLocals(*child);
+                }
+            }
+            else if (auto node = dynamic_cast<const ast::IfElse*>(&statement); node) {
+                DeclareLocals(*node->GetIfBody());
+                if (node->GetElseBody()) {
+                    DeclareLocals(*node->GetElseBody());
+                }
+            }
+        }
+
+        Node CompileVariable(const ast::VariableValue& node) {
+            const auto& ids = node.GetDottedIds();
+            if (!function_) {
+                if (ids.size() == 1) {
+                    return [name = ids.front()](Frame& frame) {
+                        return LoadGlobal(*frame.globals, name);
+                    };
+                }
+                return [ids](Frame& frame) {
+                    return LoadFields(LoadGlobal(*frame.globals, ids.front()), ids);
+                };
+            }
+            if (auto slot = FindSlot(ids.front()); slot) {
+                SlotOperand local{*slot, ids.front()};
+                if (ids.size() == 1) {
+                    return [local = move(local)](Frame& frame) {
+                        return local(frame);
+                    };
+                }
+                return [local = move(local), ids](Frame& frame) {
+                    return LoadFields(local(frame), ids);
+                };
+            }
+            return [name = ids.front()](Frame& /*frame*/) -> ObjectHolder {
+                throw runtime_error("Not field"s + name);
+            };
+        }
+
+        Node CompileArgsCall(Node object, string method, vector<Node> args) {
+            return [object = move(object), method = move(method), args = move(args)](Frame& frame) -> ObjectHolder {
+                ObjectHolder target = object(frame);
+                if (auto ptr_obj = target.TryAs<runtime::ClassInstance>(); ptr_obj) {
+                    vector<ObjectHolder> params;
+                    params.reserve(args.size());
+                    for (const Node& arg : args) {
+                        params.push_back(arg(frame));
+                    }
+                    return frame.module.Call(*ptr_obj, method, params, frame.context);
+                }
+                return {};
+            };
+        }
+
+        vector<Node> CompileArgs(const vector<unique_ptr<ast::Statement>>& args) {
+            vector<Node> result;
+            for (const auto& arg : args) {
+                result.push_back(CompileNode(*arg));
+            }
+            return result;
+        }
+
+        // Operands that are constants or locals are folded into the operation itself.
+        template <typename Operation, typename Lhs>
+        Node BindRhs(Lhs lhs, runtime::Executable& rhs) {
+            if (auto constant = Constant(rhs); constant) {
+                return MakeBinary<Operation>(move(lhs), ConstOperand{*constant});
+            }
+            if (auto local = Local(rhs); local) {
+                return MakeBinary<Operation>(move(lhs), move(*local));
+            }
+            return MakeBinary<Operation>(move(lhs), NodeOperand{CompileNode(rhs)});
+        }
+
+        template <typename Operation>
+        Node CompileBinary(const ast::BinaryOperation& node) {
+            if (auto constant = Constant(*node.GetLhs()); constant) {
+                return BindRhs<Operation>(ConstOperand{*constant}, *node.GetRhs());
+            }
+            if (auto local = Local(*node.GetLhs()); local) {
+                return BindRhs<Operation>(move(*local), *node.GetRhs());
+            }
+            return BindRhs<Operation>(NodeOperand{CompileNode(*node.GetLhs())}, *node.GetRhs());
+        }
+
+        Node CompileComparison(const ast::Comparison& node) {
+            const Comparator* comparator = node.GetComparator().target<Comparator>();
+            if (comparator && *comparator == &runtime::Equal) {
+                return CompileBinary<CompareOperation<&runtime::Equal>>(node);
+            }
+            if (comparator && *comparator == &runtime::NotEqual) {
+                return CompileBinary<CompareOperation<&runtime::NotEqual>>(node);
+            }
+            if (comparator && *comparator == &runtime::Less) {
+                return CompileBinary<CompareOperation<&runtime::Less>>(node);
+            }
+            if (comparator && *comparator == &runtime::Greater) {
+                return CompileBinary<CompareOperation<&runtime::Greater>>(node);
+            }
+            if (comparator && *comparator == &runtime::LessOrEqual) {
+                return CompileBinary<CompareOperation<&runtime::LessOrEqual>>(node);
+            }
+            if (comparator && *comparator == &runtime::GreaterOrEqual) {
+                return CompileBinary<CompareOperation<&runtime::GreaterOrEqual>>(node);
+            }
+            Node lhs = CompileNode(*node.GetLhs());
+            Node rhs = CompileNode(*node.GetRhs());
+            return [lhs = move(lhs), rhs = move(rhs), &node](Frame& frame) {
+                ObjectHolder left = lhs(frame);
+                ObjectHolder right = rhs(frame);
+                return ObjectHolder::Own(runtime::Bool(node.GetComparator()(left, right, frame.context)));
+            };
+        }
+
+        static optional<ObjectHolder> Constant(const runtime::Executable& statement) {
+            if (auto node = dynamic_cast<const ast::NumericConst*>(&statement); node) {
+                return node->GetValue();
+            }
+            if (auto node = dynamic_cast<const ast::StringConst*>(&statement); node) {
+                return node->GetValue();
+            }
+            if (auto node = dynamic_cast<const ast::BoolConst*>(&statement); node) {
+                return node->GetValue();
+            }
+            return nullopt;
+        }
+
+        optional<SlotOperand> Local(const runtime::Executable& statement) const {
+            auto node = dynamic_cast<const ast::VariableValue*>(&statement);
+            if (!function_ || !node || node->GetDottedIds().size() != 1) {
+                return nullopt;
+            }
+            const string& name = node->GetDottedIds().front();
+            if (auto slot = FindSlot(name); slot) {
+                return SlotOperand{*slot, name};
+            }
+            return nullopt;
+        }
+
+        Node CompileNode(runtime::Executable& statement) {
+            if (auto constant = Constant(statement); constant) {
+                return [value = move(*constant)](Frame& /*frame*/) {
+                    return value;
+                };
+            }
+            if (dynamic_cast<ast::None*>(&statement)) {
+                return [](Frame& /*frame*/) {
+                    return ObjectHolder();
+                };
+            }
+            if (auto node = dynamic_cast<ast::VariableValue*>(&statement); node) {
+                return CompileVariable(*node);
+            }
+            if (auto node = dynamic_cast<ast::Assignment*>(&statement); node) {
+                Node value = CompileNode(*node->GetValue());
+                if (function_) {
+                    return [value = move(value), slot = SlotFor(node->GetName())](Frame& frame) {
+                        Slot& local = frame.slots[slot];
+                        local.value = value(frame);
+                        local.defined = true;
+                        return local.value;
+                    };
+                }
+                return [value = move(value), name = node->GetName()](Frame& frame) {
+                    return (*frame.globals)[name] = value(frame);
+                };
+            }
+            if (auto node = dynamic_cast<ast::FieldAssignment*>(&statement); node) {
+                Node object = CompileVariable(node->GetObject());
+                Node value = CompileNode(*node->GetValue());
+                return [object = move(object), value = move(value), field = node->GetFieldName()](Frame& frame) -> ObjectHolder {
+                    ObjectHolder target = object(frame);
+                    if (auto ptr_obj = target.TryAs<runtime::ClassInstance>(); ptr_obj) {
+                        ObjectHolder result = value(frame);
+                        ptr_obj->SetField(field, result);
+                        return result;
+                    }
+                    return {};
+                };
+            }
+            if (auto node = dynamic_cast<ast::Print*>(&statement); node) {
+                return [args = CompileArgs(node->GetArgs())](Frame& frame) {
+                    for (size_t i = 0; i < args.size(); ++i) {
+                        runtime::PrintArgument(args[i](frame), i + 1 == args.size(), frame.context);
+                    }
+                    if (args.empty()) {
+                        frame.context.Write("\n"sv);
+                    }
+                    return ObjectHolder();
+                };
+            }
+            if (auto node = dynamic_cast<ast::MethodCall*>(&statement); node) {
+                Node object = CompileNode(*node->GetObject());
+                return CompileArgsCall(move(object), node->GetMethod(), CompileArgs(node->GetArgs()));
+            }
+            if (auto node = dynamic_cast<ast::NewInstance*>(&statement); node) {
+                const runtime::Class& cls = node->GetClass();
+                CompileClass(module_, cls);
+                const runtime::Method* init = cls.GetMethod(INIT_METHOD);
+                if (!init || init->formal_params.size() != node->GetArgs().size()) {
+                    return [&cls](Frame& /*frame*/) {
+                        return ObjectHolder::Own(runtime::ClassInstance(cls));
+                    };
+                }
+                return [&cls, args = CompileArgs(node->GetArgs())](Frame& frame) {
+                    ObjectHolder instance = ObjectHolder::Own(runtime::ClassInstance(cls));
+                    vector<ObjectHolder> params;
+                    params.reserve(args.size());
+                    for (const Node& arg : args) {
+                        params.push_back(arg(frame));
+                    }
+                    frame.module.Call(*instance.TryAs<runtime::ClassInstance>(), INIT_METHOD, params, frame.context);
+                    return instance;
+                };
+            }
+            if (auto node = dynamic_cast<ast::Stringify*>(&statement); node) {
+                return [argument = CompileNode(*node->GetArgument())](Frame& frame) {
+                    ObjectHolder obj = argument(frame);
+                    if (obj) {
+                        string buffer;
+                        obj->FormatTo(buffer, frame.context);
+                        return ObjectHolder::Own(runtime::String(move(buffer)));
+                    }
+                    return ObjectHolder::Own(runtime::String("None"s));
+                };
+            }
+            if (auto node = dynamic_cast<ast::Not*>(&statement); node) {
+                return [argument = CompileNode(*node->GetArgument())](Frame& frame) {
+                    return ObjectHolder::Own(runtime::Bool(!runtime::IsTrue(argument(frame))));
+                };
+            }
+            if (auto node = dynamic_cast<ast::Add*>(&statement); node) {
+                return CompileBinary<AddOperation>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Sub*>(&statement); node) {
+                return CompileBinary<SubOperation>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Mult*>(&statement); node) {
+                return CompileBinary<MultOperation>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Div*>(&statement); node) {
+                return CompileBinary<DivOperation>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Or*>(&statement); node) {
+                return [lhs = CompileNode(*node->GetLhs()), rhs = CompileNode(*node->GetRhs())](Frame& frame) {
+                    if (!runtime::IsTrue(lhs(frame))) {
+                        return ObjectHolder::Own(runtime::Bool(runtime::IsTrue(rhs(frame))));
+                    }
+                    return ObjectHolder::Own(runtime::Bool(true));
+                };
+            }
+            if (auto node = dynamic_cast<ast::And*>(&statement); node) {
+                return [lhs = CompileNode(*node->GetLhs()), rhs = CompileNode(*node->GetRhs())](Frame& frame) {
+                    if (runtime::IsTrue(lhs(frame))) {
+                        return ObjectHolder::Own(runtime::Bool(runtime::IsTrue(rhs(frame))));
+                    }
+                    return ObjectHolder::Own(runtime::Bool(false));
+                };
+            }
+            if (auto node = dynamic_cast<ast::Comparison*>(&statement); node) {
+                return CompileComparison(*node);
+            }
+            if (auto node = dynamic_cast<ast::Compound*>(&statement); node) {
+                if (function_) {
+                    DeclareLocals(*node);
+                }
+                return [statements = CompileArgs(node->GetStatements())](Frame& frame) {
+                    for (const Node& child : statements) {
+                        frame.context.ChargeStep();
+                        runtime::CycleCollector::AtSafePoint();
+                        child(frame);
+                        if (frame.returning) {
+                            break;
+                        }
+                    }
+                    return ObjectHolder();
+                };
+            }
+            if (auto node = dynamic_cast<ast::Return*>(&statement); node) {
+                Node value = CompileNode(*node->GetStatement());
+                if (!function_) {
+                    return [value = move(value)](Frame& frame) -> ObjectHolder {
+                        throw value(frame);
+                    };
+                }
+                return [value = move(value)](Frame& frame) {
+                    frame.result = value(frame);
+                    frame.returning = true;
+                    return ObjectHolder();
+                };
+            }
+            if (auto node = dynamic_cast<ast::ClassDefinition*>(&statement); node) {
+                if (function_) {
+                    throw Unsupported();
+                }
+                CompileClass(module_, *node->GetClass().TryAs<runtime::Class>());
+                return [cls = node->GetClass()](Frame& frame) {
+                    return (*frame.globals)[cls.TryAs<runtime::Class>()->GetName()] = cls;
+                };
+            }
+            if (auto node = dynamic_cast<ast::IfElse*>(&statement); node) {
+                Node condition = CompileNode(*node->GetCondition());
+                Node if_body = CompileNode(*node->GetIfBody());
+                Node else_body = node->GetElseBody() ? CompileNode(*node->GetElseBody()) : Node();
+                return [condition = move(condition), if_body = move(if_body), else_body = move(else_body)](Frame& frame) {
+                    if (runtime::IsTrue(condition(frame))) {
+                        return if_body(frame);
+                    }
+                    if (else_body) {
+                        return else_body(frame);
+                    }
+                    return ObjectHolder();
+                };
+            }
+            if (function_) {
+                throw Unsupported();
+            }
+            return [&statement](Frame& frame) {
+                return statement.Execute(*frame.globals, frame.context);
+            };
+        }
+
+        Module& module_;
+        Function* function_ = nullptr;
+    };
+
+    // ----------------------Module-----------------------
+
+    Module::Module(runtime::Executable& program) {
+        main_.body = Compiler(*this).CompileMain(program);
+    }
+
+    Module::~Module() = default;
+
+    ObjectHolder Module::Execute(Closure& closure, Context& context) const {
+        runtime::MemoryAccount::Scope memory_scope(context.GetMemoryAccount());
+        Frame frame(*this, context);
+        frame.globals = &closure;
+        return main_.body(frame);
+    }
+
+    ObjectHolder Module::Call(runtime::ClassInstance& self, const std::string& method,
+        const std::vector<ObjectHolder>& args, Context& context) const {
+        const runtime::Method* target = self.GetClass().GetMethod(method);
+        const Function* function = nullptr;
+        if (target && target->formal_params.size() == args.size()) {
+            if (auto it = methods_.find(target); it != methods_.end()) {
+                function = it->second.get();
+            }
+        }
+        if (!function) {
+            return self.Call(method, args, context);
+        }
+
+        context.ChargeStep();
+        if (jit::Jit* jit = jit::Jit::Current(); jit) {
+            if (auto result = jit->TryCall(self, *target, args, context); result) {
+                return *result;
+            }
+        }
+        vector<Slot> slots(function->slot_names.size());
+        for (size_t i = 0; i < args.size(); ++i) {
+            slots[i] = {args[i], true};
+        }
+        if (function->self_slot >= function->param_count) {
+            slots[function->self_slot] = {ObjectHolder::Share(self), true};
+        }
+        Frame frame(*this, context);
+        frame.slots = slots.data();
+        function->body(frame);
+        return frame.returning ? move(frame.result) : ObjectHolder();
+    }
+
+    bool Module::IsCompiled(const runtime::Method& method) const {
+        auto it = methods_.find(&method);
+        return it != methods_.end() && it->second;
+    }
+
+}  // namespace compiled
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace compiled {
+
+    struct Frame;
+
+    // A compiled node: evaluates one statement of the tree against a frame.
+    using Node = std::function<runtime::ObjectHolder(Frame& frame)>;
+
+    // ----------------------Function-----------------------
+
+    // The compiled form of the main program or of one method. Method locals - self, the parameters
+    // and every assigned name - live in slots whose indices are fixed when the method is compiled;
+    // the main program works on the caller's closure.
+    struct Function {
+        Node                                           body;
+        std::vector<std::string>                       slot_names;
+        size_t                                         param_count = 0;
+        size_t                                         self_slot = 0;
+    };
+
+    // ----------------------Module-----------------------
+
+    // A program compiled into a tree of closures. Every node is turned into a lambda with its
+    // constants, slot indices, operator and comparison baked in; operands that are constants or
+    // local variables are folded into the lambda of the operation that uses them, so such nodes
+    // run without any indirect call. Calls from compiled code to methods of the program's classes
+    // go straight to their compiled bodies. Methods invoked by the runtime itself (__str__, __eq__
+    // and __lt__ from formatting and comparisons) run on the tree-walking interpreter, as do
+    // methods containing statements this backend does not know. Like the statement tree, a Module
+    // is immutable once built and may be executed from several threads at once.
+    class Module {
+    public:
+        explicit                                       Module(runtime::Executable& program);
+
+        Module(const Module&) = delete;
+        Module& operator=(const Module&) = delete;
+
+        ~Module();
+
+        runtime::ObjectHolder                          Execute(runtime::Closure& closure, runtime::Context& context) const;
+
+        runtime::ObjectHolder                          Call(runtime::ClassInstance& self, const std::string& method,
+                                                            const std::vector<runtime::ObjectHolder>& args,
+                                                            runtime::Context& context) const;
+
+        [[nodiscard]] bool                             IsCompiled(const runtime::Method& method) const;
+
+    private:
+        friend class Compiler;
+
+        Function                                       main_;
+        std::unordered_map<const runtime::Method*, std::unique_ptr<Function>> methods_;
+    };
+
+}  // namespace compiled
@@ -0,0 +1,50 @@
+#include "compiled.h"
+#include "lexer.h"
+#include "parse.h"
+#include "program.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace compiled {
+
+namespace {
+
+void TestMatchesTreeWalking() {
+    AssertSampleMatchesTreeWalking(ExecutionMode::CLOSURE_COMPILED);
+}
+
+void TestPrintOrderMatchesTreeWalking() {
+    AssertPrintOrderMatchesTreeWalking(ExecutionMode::CLOSURE_COMPILED);
+}
+
+void TestCompilesMethods() {
+    istringstream input(SAMPLE_PROGRAM);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+    Module module(*tree);
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    module.Execute(closure, context);
+    const auto& cls = *closure.at("Named"s).TryAs<runtime::Class>();
+    ASSERT(module.IsCompiled(*cls.GetMethod("__init__"s)));
+    ASSERT(module.IsCompiled(*cls.GetMethod("scaled"s)));
+    ASSERT(module.IsCompiled(*cls.GetParent()->GetMethod("__add__"s)));
+}
+
+void TestErrorsMatchTreeWalking() {
+    AssertErrorsMatchTreeWalking(ExecutionMode::CLOSURE_COMPILED);
+}
+
+}  // namespace
+
+void RunCompiledTests(TestRunner& tr) {
+    RUN_TEST(tr, TestMatchesTreeWalking);
+    RUN_TEST(tr, TestPrintOrderMatchesTreeWalking);
+    RUN_TEST(tr, TestCompilesMethods);
+    RUN_TEST(tr, TestErrorsMatchTreeWalking);
+}
+
+}  // namespace compiled
@@ -0,0 +1,243 @@
+#include "counters.h"
+
+#include "runtime.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <tuple>
+
+using namespace std;
+
+namespace profile {
+
+    namespace {
+
+        int OpenEvent(const CounterEvent& event, int group_fd) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = event.type;
+            attr.config = event.config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+        }
+
+        uint64_t Difference(uint64_t end, uint64_t start) {
+            return end > start ? end - start : 0;
+        }
+
+        void WriteJsonValues(ostream& out, const CounterValues& values, const vector<CounterEvent>& events) {
+            out << '{';
+            for (size_t i = 0; i < events.size(); ++i) {
+                out << (i ? ", \"" : "\"") << events[i].name << "\": " << values[i];
+            }
+            out << '}';
+        }
+
+    }  // namespace
+
+    // ----------------------CounterEvent-----------------------
+
+    vector<CounterEvent> HardwareCounterEvents() {
+        return {
+            {"cycles"s, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {"instructions"s, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {"cache-misses"s, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {"branch-misses"s, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        };
+    }
+
+    vector<CounterEvent> SoftwareCounterEvents() {
+        return {
+            {"task-clock"s, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {"page-faults"s, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+            {"context-switches"s, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        };
+    }
+
+    // ----------------------CounterGroup-----------------------
+
+    CounterGroup::CounterGroup(const vector<CounterEvent>& events) {
+        for (const CounterEvent& event : events) {
+            if (fds_.size() == MAX_COUNTER_EVENTS) {
+                error_ += (error_.empty() ? ""s : "; "s) + event.name + ": too many events"s;
+                continue;
+            }
+            const int fd = OpenEvent(event, fds_.empty() ? -1 : fds_.front());
+            if (fd < 0) {
+                error_ += (error_.empty() ? ""s : "; "s) + event.name + ": "s + strerror(errno);
+                continue;
+            }
+            fds_.push_back(fd);
+            events_.push_back(event);
+        }
+    }
+
+    CounterGroup::~CounterGroup() {
+        // The members of a group go before its leader.
+        for (auto it = fds_.rbegin(); it != fds_.rend(); ++it) {
+            close(*it);
+        }
+    }
+
+    bool CounterGroup::IsOpen() const {
+        return !fds_.empty();
+    }
+
+    const vector<CounterEvent>& CounterGroup::GetEvents() const {
+        return events_;
+    }
+
+    const string& CounterGroup::GetError() const {
+        return error_;
+    }
+
+    CounterValues CounterGroup::Read() const {
+        CounterValues values{};
+        if (fds_.empty()) {
+            return values;
+        }
+        // nr, time enabled, time running, then a value per event.
+        array<uint64_t, 3 + MAX_COUNTER_EVENTS> buffer{};
+        const ssize_t size = read(fds_.front(), buffer.data(), sizeof(buffer));
+        if (size < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+            return values;
+        }
+        const size_t count = min<uint64_t>(buffer[0], events_.size());
+        const uint64_t enabled = buffer[1];
+        const uint64_t running = buffer[2];
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = running && running < enabled
+                ? static_cast<uint64_t>(static_cast<long double>(buffer[3 + i]) * enabled / running)
+                : buffer[3 + i];
+        }
+        return values;
+    }
+
+    // ----------------------Scope-----------------------
+
+    CounterProfiler::Scope::Scope(CounterProfiler& profiler)
+        : previous_(current_)
+        , start_(profiler.group_.Read()) {
+        current_ = &profiler;
+    }
+
+    CounterProfiler::Scope::~Scope() {
+        const CounterValues end = current_->group_.Read();
+        for (size_t i = 0; i < MAX_COUNTER_EVENTS; ++i) {
+            current_->run_[i] += Difference(end[i], start_[i]);
+        }
+        current_ = previous_;
+    }
+
+    // ----------------------CounterProfiler-----------------------
+
+    CounterProfiler::CounterProfiler(const vector<CounterEvent>& events)
+        : group_(events) {}
+
+    bool CounterProfiler::IsAvailable() const {
+        return group_.IsOpen();
+    }
+
+    const string& CounterProfiler::GetError() const {
+        return group_.GetError();
+    }
+
+    const vector<CounterEvent>& CounterProfiler::GetEvents() const {
+        return group_.GetEvents();
+    }
+
+    const CounterValues& CounterProfiler::GetRunCounters() const {
+        return run_;
+    }
+
+    void CounterProfiler::Enter(const runtime::Class& cls, const runtime::Method& method) {
+        Entry& entry = methods_[&method];
+        if (entry.name.empty()) {
+            entry.name = cls.GetDeclaringClass(method).GetName() + '.' + method.name;
+        }
+        ++entry.calls;
+        ++entry.active;
+        stack_.push_back(Activation{&entry, group_.Read(), {}});
+    }
+
+    void CounterProfiler::Leave() {
+        const CounterValues end = group_.Read();
+        const Activation& activation = stack_.back();
+        Entry& entry = *activation.entry;
+        --entry.active;
+        for (size_t i = 0; i < MAX_COUNTER_EVENTS; ++i) {
+            const uint64_t elapsed = Difference(end[i], activation.start[i]);
+            entry.self[i] += Difference(elapsed, activation.children[i]);
+            if (entry.active == 0) {
+                entry.total[i] += elapsed;
+            }
+            if (stack_.size() > 1) {
+                stack_[stack_.size() - 2].children[i] += elapsed;
+            }
+        }
+        stack_.pop_back();
+    }
+
+    vector<MethodCounters> CounterProfiler::GetMethodCounters() const {
+        vector<MethodCounters> result;
+        for (const auto& [method, entry] : methods_) {
+            result.push_back(MethodCounters{entry.name, entry.calls, entry.self, entry.total});
+        }
+        sort(result.begin(), result.end(), [](const MethodCounters& lhs, const MethodCounters& rhs) {
+            return tie(rhs.total[0], rhs.calls, lhs.name) < tie(lhs.total[0], lhs.calls, rhs.name);
+        });
+        return result;
+    }
+
+    void CounterProfiler::WriteTable(ostream& out) const {
+        const vector<CounterEvent>& events = GetEvents();
+        out << "events:";
+        for (const CounterEvent& event : events) {
+            out << ' ' << event.name;
+        }
+        if (!GetError().empty()) {
+            out << " (unavailable: " << GetError() << ')';
+        }
+        out << '\n';
+        vector<MethodCounters> methods = GetMethodCounters();
+        for (size_t i = 0; i < events.size(); ++i) {
+            stable_sort(methods.begin(), methods.end(), [i](const MethodCounters& lhs, const MethodCounters& rhs) {
+                return lhs.total[i] > rhs.total[i];
+            });
+            out << '\n' << events[i].name << ": " << run_[i] << " in the run\n";
+            out << "   calls          self         total  method\n";
+            for (const MethodCounters& method : methods) {
+                out << setw(8) << method.calls << setw(14) << method.self[i] << setw(14) << method.total[i]
+                    << "  " << method.name << '\n';
+            }
+        }
+    }
+
+    void CounterProfiler::WriteJson(ostream& out) const {
+        const vector<CounterEvent>& events = GetEvents();
+        out << "{\"run\": ";
+        WriteJsonValues(out, run_, events);
+        out << ", \"methods\": [";
+        bool first = true;
+        for (const MethodCounters& method : GetMethodCounters()) {
+            out << (first ? "" : ", ") << "{\"name\": \"" << method.name << "\", \"calls\": " << method.calls
+                << ", \"self\": ";
+            WriteJsonValues(out, method.self, events);
+            out << ", \"total\": ";
+            WriteJsonValues(out, method.total, events);
+            out << '}';
+            first = false;
+        }
+        out << "]}\n";
+    }
+
+}  // namespace profile
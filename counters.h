@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace runtime {
+
+    class Class;
+    struct Method;
+
+}  // namespace runtime
+
+namespace profile {
+
+    // ----------------------CounterEvent-----------------------
+
+    // A perf_event_open event, by the type and config of perf_event_attr.
+    struct CounterEvent {
+        std::string                                    name;
+        uint32_t                                       type = 0;
+        uint64_t                                       config = 0;
+    };
+
+    // Cycles, instructions, cache misses and branch misses.
+    [[nodiscard]] std::vector<CounterEvent> HardwareCounterEvents();
+
+    // Task clock in nanoseconds, page faults and context switches, for machines without a PMU
+    // such as most virtual machines.
+    [[nodiscard]] std::vector<CounterEvent> SoftwareCounterEvents();
+
+    inline constexpr size_t MAX_COUNTER_EVENTS = 8;
+
+    using CounterValues = std::array<uint64_t, MAX_COUNTER_EVENTS>;
+
+    // ----------------------CounterGroup-----------------------
+
+    // The events that could be opened, as one perf_event group counting the user space of the
+    // thread that creates it. Values are scaled up when the kernel multiplexed the group.
+    class CounterGroup {
+    public:
+        explicit                                       CounterGroup(const std::vector<CounterEvent>& events);
+
+        CounterGroup(const CounterGroup&) = delete;
+        CounterGroup& operator=(const CounterGroup&) = delete;
+
+        ~CounterGroup();
+
+        [[nodiscard]] bool                             IsOpen() const;
+
+        [[nodiscard]] const std::vector<CounterEvent>& GetEvents() const;
+
+        // Why events are missing, empty when all of them were opened.
+        [[nodiscard]] const std::string&               GetError() const;
+
+        [[nodiscard]] CounterValues                    Read() const;
+
+    private:
+        std::vector<CounterEvent>                      events_;
+        std::vector<int>                               fds_;
+        std::string                                    error_;
+    };
+
+    // ----------------------MethodCounters-----------------------
+
+    // Counts of the activations of one method. Self excludes the methods it called; total
+    // includes them and counts recursive activations once.
+    struct MethodCounters {
+        std::string                                    name;
+        size_t                                         calls = 0;
+        CounterValues                                  self{};
+        CounterValues                                  total{};
+    };
+
+    // ----------------------CounterProfiler-----------------------
+
+    // Reads a CounterGroup when a run starts and ends, and around every method call on the
+    // thread of the innermost open Scope, at the cost of two reads per call. It must be created
+    // on the thread that executes the program. Calls are counted even when no event is open, and
+    // methods are named on their first call, so reports outlive the program.
+    class CounterProfiler {
+    public:
+        class Scope {
+        public:
+            explicit                                   Scope(CounterProfiler& profiler);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            CounterProfiler*                           previous_;
+            CounterValues                              start_;
+        };
+
+        // Attributes what happens while alive to a method, if counters are being collected.
+        class MethodScope {
+        public:
+                                                       MethodScope(const runtime::Class& cls, const runtime::Method& method);
+
+            MethodScope(const MethodScope&) = delete;
+            MethodScope& operator=(const MethodScope&) = delete;
+
+            ~MethodScope();
+
+        private:
+            CounterProfiler*                           profiler_;
+        };
+
+        explicit                                       CounterProfiler(const std::vector<CounterEvent>& events = HardwareCounterEvents());
+
+        [[nodiscard]] static CounterProfiler*          Current();
+
+        [[nodiscard]] bool                             IsAvailable() const;
+
+        [[nodiscard]] const std::string&               GetError() const;
+
+        [[nodiscard]] const std::vector<CounterEvent>& GetEvents() const;
+
+        // Totals of the runs of closed scopes.
+        [[nodiscard]] const CounterValues&             GetRunCounters() const;
+
+        // Most expensive first, by the total of the first event.
+        [[nodiscard]] std::vector<MethodCounters>      GetMethodCounters() const;
+
+        // The run total and a table of methods, most expensive first, for each event.
+        void                                           WriteTable(std::ostream& out) const;
+
+        void                                           WriteJson(std::ostream& out) const;
+
+    private:
+        struct Entry {
+            std::string                                name;
+            size_t                                     calls = 0;
+            size_t                                     active = 0;
+            CounterValues                              self{};
+            CounterValues                              total{};
+        };
+
+        struct Activation {
+            Entry*                                     entry = nullptr;
+            CounterValues                              start{};
+            CounterValues                              children{};
+        };
+
+        void                                           Enter(const runtime::Class& cls, const runtime::Method& method);
+
+        void                                           Leave();
+
+        CounterGroup                                   group_;
+        CounterValues                                  run_{};
+        std::unordered_map<const runtime::Method*, Entry> methods_;
+        std::vector<Activation>                        stack_;
+
+        static inline thread_local CounterProfiler*    current_ = nullptr;
+    };
+
+    inline CounterProfiler* CounterProfiler::Current() {
+        return current_;
+    }
+
+    inline CounterProfiler::MethodScope::MethodScope(const runtime::Class& cls, const runtime::Method& method)
+        : profiler_(current_) {
+        if (profiler_) {
+            profiler_->Enter(cls, method);
+        }
+    }
+
+    inline CounterProfiler::MethodScope::~MethodScope() {
+        if (profiler_) {
+            profiler_->Leave();
+        }
+    }
+
+}  // namespace profile
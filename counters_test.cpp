@@ -0,0 +1,116 @@
+#include "counters.h"
+#include "lexer.h"
+#include "program.h"
+#include "runtime.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace profile {
+
+namespace {
+
+const string NESTED_PROGRAM = R"(
+class Fib:
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+class Loud(Fib):
+  def shout():
+    return self.fib(16)
+
+f = Loud()
+x = f.shout()
+)"s;
+
+void Run(const string& source, CounterProfiler& profiler) {
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    auto program = CompileProgram(lexer);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    CounterProfiler::Scope scope(profiler);
+    program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+}
+
+const MethodCounters& FindMethod(const vector<MethodCounters>& methods, const string& name) {
+    for (const MethodCounters& method : methods) {
+        if (method.name == name) {
+            return method;
+        }
+    }
+    throw runtime_error("No method "s + name);
+}
+
+void TestCountsCallsWithoutEvents() {
+    CounterProfiler profiler(vector<CounterEvent>{});
+    ASSERT(!profiler.IsAvailable());
+    ASSERT(profiler.GetError().empty());
+    Run(NESTED_PROGRAM, profiler);
+    ASSERT(CounterProfiler::Current() == nullptr);
+
+    const vector<MethodCounters> methods = profiler.GetMethodCounters();
+    ASSERT_EQUAL(methods.size(), 2u);
+    ASSERT_EQUAL(methods[0].name, "Fib.fib"s);
+    ASSERT_EQUAL(methods[0].calls, 3193u);
+    ASSERT_EQUAL(methods[1].name, "Loud.shout"s);
+    ASSERT_EQUAL(methods[1].calls, 1u);
+    ASSERT_EQUAL(methods[1].total[0], 0u);
+}
+
+void TestReportsEventsThatCannotBeOpened() {
+    CounterProfiler profiler({{"bogus"s, 1000, 0}});
+    ASSERT(!profiler.IsAvailable());
+    ASSERT(profiler.GetEvents().empty());
+    ASSERT_EQUAL(profiler.GetError().rfind("bogus: "s, 0), 0u);
+
+    ostringstream table;
+    profiler.WriteTable(table);
+    ASSERT_EQUAL(table.str().rfind("events: (unavailable: bogus: "s, 0), 0u);
+}
+
+void TestAttributesSelfAndTotal() {
+    // Software events, since virtual machines often have no PMU; skipped where perf_event_open
+    // is not permitted at all.
+    CounterProfiler profiler(SoftwareCounterEvents());
+    if (!profiler.IsAvailable()) {
+        return;
+    }
+    ASSERT_EQUAL(profiler.GetEvents()[0].name, "task-clock"s);
+    Run(NESTED_PROGRAM, profiler);
+
+    const vector<MethodCounters> methods = profiler.GetMethodCounters();
+    const MethodCounters& fib = FindMethod(methods, "Fib.fib"s);
+    const MethodCounters& shout = FindMethod(methods, "Loud.shout"s);
+    const uint64_t run = profiler.GetRunCounters()[0];
+    ASSERT(fib.total[0] > 0);
+    ASSERT(fib.self[0] <= fib.total[0]);
+    ASSERT(shout.self[0] <= shout.total[0]);
+    ASSERT(fib.total[0] <= shout.total[0]);
+    ASSERT(shout.total[0] <= run);
+
+    ostringstream table;
+    profiler.WriteTable(table);
+    ASSERT_EQUAL(table.str().rfind("events: task-clock page-faults context-switches\n"s, 0), 0u);
+    ASSERT(table.str().find("\ntask-clock: "s + to_string(run) + " in the run\n"s) != string::npos);
+    ASSERT(table.str().find("  Fib.fib\n"s) != string::npos);
+
+    ostringstream json;
+    profiler.WriteJson(json);
+    ASSERT_EQUAL(json.str().rfind("{\"run\": {\"task-clock\": "s + to_string(run) + ", \"page-faults\": "s, 0), 0u);
+    ASSERT(json.str().find("{\"name\": \"Fib.fib\", \"calls\": 3193, \"self\": {\"task-clock\": "s) != string::npos);
+}
+
+}  // namespace
+
+void RunCounterTests(TestRunner& tr) {
+    RUN_TEST(tr, TestCountsCallsWithoutEvents);
+    RUN_TEST(tr, TestReportsEventsThatCannotBeOpened);
+    RUN_TEST(tr, TestAttributesSelfAndTotal);
+}
+
+}  // namespace profile
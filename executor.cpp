@@ -0,0 +1,141 @@
+#include "executor.h"
+
+#include <algorithm>
+#include <exception>
+#include <sstream>
+
+using namespace std;
+
+namespace runtime {
+
+    // ----------------------Executor-----------------------
+
+    Executor::Executor(size_t thread_count) {
+        thread_count = max<size_t>(thread_count, 1);
+        for (size_t i = 0; i < thread_count; ++i) {
+            queues_.push_back(make_unique<WorkQueue>());
+        }
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers_.emplace_back([this, i] {
+                WorkerLoop(i);
+            });
+        }
+    }
+
+    Executor::~Executor() {
+        {
+            lock_guard guard(idle_lock_);
+            stopping_ = true;
+        }
+        idle_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    future<JobResult> Executor::Submit(Job job) {
+        auto pending = make_unique<PendingJob>();
+        pending->job = move(job);
+        pending->enqueued = chrono::steady_clock::now();
+        future<JobResult> result = pending->promise.get_future();
+
+        // Counted before it is published: a worker may take the job as soon as it is queued,
+        // and its decrement must not run ahead of this increment.
+        {
+            lock_guard guard(idle_lock_);
+            pending_.fetch_add(1, memory_order_release);
+        }
+        WorkQueue& queue = *queues_[next_queue_.fetch_add(1, memory_order_relaxed) % queues_.size()];
+        {
+            lock_guard guard(queue.lock);
+            queue.jobs.push_back(move(pending));
+        }
+        submitted_.fetch_add(1, memory_order_relaxed);
+        idle_cv_.notify_one();
+        return result;
+    }
+
+    size_t Executor::GetThreadCount() const {
+        return workers_.size();
+    }
+
+    ExecutorStats Executor::GetStats() const {
+        return {submitted_.load(memory_order_relaxed), completed_.load(memory_order_relaxed),
+                steals_.load(memory_order_relaxed)};
+    }
+
+    void Executor::WorkerLoop(size_t index) {
+        while (true) {
+            if (auto pending = TakeJob(index); pending) {
+                const auto started = chrono::steady_clock::now();
+                JobResult result = Run(pending->job, index);
+                result.queue_time = chrono::duration_cast<chrono::nanoseconds>(started - pending->enqueued);
+                completed_.fetch_add(1, memory_order_relaxed);
+                pending->promise.set_value(move(result));
+                continue;
+            }
+            unique_lock guard(idle_lock_);
+            idle_cv_.wait(guard, [this] {
+                return stopping_ || pending_.load(memory_order_acquire) > 0;
+            });
+            if (stopping_ && pending_.load(memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+
+    unique_ptr<Executor::PendingJob> Executor::TakeJob(size_t index) {
+        {
+            WorkQueue& own = *queues_[index];
+            lock_guard guard(own.lock);
+            if (!own.jobs.empty()) {
+                auto job = move(own.jobs.back());
+                own.jobs.pop_back();
+                pending_.fetch_sub(1, memory_order_acq_rel);
+                return job;
+            }
+        }
+        for (size_t offset = 1; offset < queues_.size(); ++offset) {
+            WorkQueue& victim = *queues_[(index + offset) % queues_.size()];
+            lock_guard guard(victim.lock);
+            if (!victim.jobs.empty()) {
+                auto job = move(victim.jobs.front());
+                victim.jobs.pop_front();
+                pending_.fetch_sub(1, memory_order_acq_rel);
+                steals_.fetch_add(1, memory_order_relaxed);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    JobResult Executor::Run(Job& job, size_t worker) {
+        JobResult result;
+        result.worker = worker;
+        result.globals = move(job.inputs);
+
+        ostringstream captured;
+        SimpleContext context(job.output ? *job.output : captured);
+        context.SetBudget(&job.budget);
+        MemoryAccount memory(job.memory_quota);
+        context.SetMemoryAccount(&memory);
+        const auto started = chrono::steady_clock::now();
+        try {
+            job.program->Execute(result.globals, context);
+            result.ok = true;
+        }
+        catch (const exception& e) {
+            result.error = e.what();
+        }
+        catch (...) {
+            result.error = "Unknown exception"s;
+        }
+        result.run_time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started);
+        result.peak_memory_bytes = memory.GetPeakBytes();
+        if (!job.output) {
+            result.output = captured.str();
+        }
+        return result;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "program.h"
+#include "runtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+    // ----------------------Job-----------------------
+
+    struct Job {
+        std::shared_ptr<const Program>                 program;
+        Closure                                        inputs;
+        std::ostream* output = nullptr;
+        ExecutionBudget                                budget{};
+        size_t                                         memory_quota = MemoryAccount::UNLIMITED;
+    };
+
+    // ----------------------JobResult-----------------------
+
+    struct JobResult {
+        bool                                           ok = false;
+        std::string                                    error;
+        std::string                                    output;
+        Closure                                        globals;
+        size_t                                         worker = 0;
+        std::chrono::nanoseconds                       queue_time{0};
+        std::chrono::nanoseconds                       run_time{0};
+        size_t                                         peak_memory_bytes = 0;
+    };
+
+    // ----------------------ExecutorStats-----------------------
+
+    struct ExecutorStats {
+        size_t                                         submitted = 0;
+        size_t                                         completed = 0;
+        size_t                                         steals = 0;
+    };
+
+    // ----------------------Executor-----------------------
+
+    class Executor {
+    public:
+        explicit                                       Executor(size_t thread_count = std::thread::hardware_concurrency());
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        ~Executor();
+
+        [[nodiscard]] std::future<JobResult>           Submit(Job job);
+
+        [[nodiscard]] size_t                           GetThreadCount() const;
+
+        [[nodiscard]] ExecutorStats                    GetStats() const;
+
+    private:
+        struct PendingJob {
+            Job                                        job;
+            std::promise<JobResult>                    promise;
+            std::chrono::steady_clock::time_point      enqueued;
+        };
+
+        struct WorkQueue {
+            std::mutex                                 lock;
+            std::deque<std::unique_ptr<PendingJob>>    jobs;
+        };
+
+        void                                           WorkerLoop(size_t index);
+
+        std::unique_ptr<PendingJob>                    TakeJob(size_t index);
+
+        static JobResult                               Run(Job& job, size_t worker);
+
+        std::vector<std::unique_ptr<WorkQueue>>        queues_;
+        std::vector<std::thread>                       workers_;
+        std::mutex                                     idle_lock_;
+        std::condition_variable                        idle_cv_;
+        std::atomic<size_t>                            pending_ = 0;
+        std::atomic<size_t>                            next_queue_ = 0;
+        std::atomic<size_t>                            submitted_ = 0;
+        std::atomic<size_t>                            completed_ = 0;
+        std::atomic<size_t>                            steals_ = 0;
+        bool                                           stopping_ = false;
+    };
+
+}  // namespace runtime
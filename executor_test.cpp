@@ -0,0 +1,74 @@
+#include "executor.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestExecutorRunsJobsInIsolation() {
+    auto program = CompileFromString(R"(
+class Square:
+  def calc(n):
+    return n * n
+
+sq = Square()
+result = sq.calc(n)
+print name, result
+)"s);
+
+    Executor executor(4);
+    vector<future<JobResult>> results;
+    for (int i = 0; i < 200; ++i) {
+        Job job{program, {}, nullptr};
+        job.inputs["n"s] = ObjectHolder::Own(Number(i));
+        job.inputs["name"s] = ObjectHolder::Own(String("job"s + to_string(i)));
+        results.push_back(executor.Submit(move(job)));
+    }
+    for (int i = 0; i < 200; ++i) {
+        JobResult result = results[i].get();
+        ASSERT(result.ok);
+        ASSERT_EQUAL(result.output, "job"s + to_string(i) + " "s + to_string(i * i) + "\n"s);
+        ASSERT_EQUAL(result.globals.at("result"s).TryAs<Number>()->GetValue(), i * i);
+        ASSERT(result.worker < executor.GetThreadCount());
+        ASSERT(result.run_time.count() >= 0);
+        ASSERT(result.queue_time.count() >= 0);
+    }
+    const auto stats = executor.GetStats();
+    ASSERT_EQUAL(stats.submitted, 200U);
+    ASSERT_EQUAL(stats.completed, 200U);
+}
+
+void TestExecutorReportsErrors() {
+    Executor executor(2);
+    auto failing = executor.Submit({CompileFromString("print 1 / 0\n"s), {}, nullptr});
+    auto missing = executor.Submit({CompileFromString("print undefined\n"s), {}, nullptr});
+
+    JobResult result = failing.get();
+    ASSERT(!result.ok);
+    ASSERT_EQUAL(result.error, "The denominator is zero"s);
+    ASSERT(!missing.get().ok);
+}
+
+void TestExecutorWritesToSink() {
+    ostringstream sink;
+    {
+        Executor executor(1);
+        executor.Submit({CompileFromString("print 'to sink'\n"s), {}, &sink}).get();
+    }
+    ASSERT_EQUAL(sink.str(), "to sink\n"s);
+}
+
+}  // namespace
+
+void RunExecutorTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestExecutorRunsJobsInIsolation);
+    RUN_TEST(tr, runtime::TestExecutorReportsErrors);
+    RUN_TEST(tr, runtime::TestExecutorWritesToSink);
+}
+
+}  // namespace runtime
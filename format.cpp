@@ -0,0 +1,33 @@
+#include "format.h"
+
+#include <charconv>
+#include <cstdint>
+
+using namespace std;
+
+namespace runtime {
+
+    // ----------------------Format-----------------------
+
+    void FormatInt(std::string& buffer, int value) {
+        char digits[16];
+        const char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+        buffer.append(digits, static_cast<size_t>(end - digits));
+    }
+
+    void FormatBool(std::string& buffer, bool value) {
+        buffer.append(value ? "True"sv : "False"sv);
+    }
+
+    void FormatPointer(std::string& buffer, const void* ptr) {
+        char digits[2 + 2 * sizeof(uintptr_t)] = {'0', 'x'};
+        const char* end = to_chars(digits + 2, digits + sizeof(digits),
+                                   reinterpret_cast<uintptr_t>(ptr), 16).ptr;
+        buffer.append(digits, static_cast<size_t>(end - digits));
+    }
+
+    void FormatString(std::string& buffer, std::string_view value) {
+        buffer.append(value);
+    }
+
+}  // namespace runtime
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace runtime {
+
+    // ----------------------Format-----------------------
+
+    void                                              FormatInt(std::string& buffer, int value);
+
+    void                                              FormatBool(std::string& buffer, bool value);
+
+    void                                              FormatPointer(std::string& buffer, const void* ptr);
+
+    void                                              FormatString(std::string& buffer, std::string_view value);
+
+}  // namespace runtime
@@ -0,0 +1,139 @@
+#include "gc.h"
+
+#include "runtime.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+
+        constexpr size_t MIN_COMPACT_SIZE = 1024;
+
+    }  // namespace
+
+    // ----------------------Scope-----------------------
+
+    CycleCollector::Scope::Scope(CycleCollector& collector)
+        : previous_(current_) {
+        current_ = &collector;
+    }
+
+    CycleCollector::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    // ----------------------CycleCollector-----------------------
+
+    CycleCollector::CycleCollector(size_t threshold)
+        : threshold_(threshold)
+        , compact_at_(MIN_COMPACT_SIZE) {}
+
+    void CycleCollector::Track(const ObjectHolder& instance) {
+        if (candidates_.size() >= compact_at_) {
+            candidates_.erase(remove_if(candidates_.begin(), candidates_.end(), [](const weak_ptr<Object>& candidate) {
+                return candidate.expired();
+            }), candidates_.end());
+            compact_at_ = max(MIN_COMPACT_SIZE, 2 * candidates_.size());
+        }
+        candidates_.push_back(instance.data_);
+        ++allocations_since_collect_;
+        stats_.tracked = candidates_.size();
+    }
+
+    size_t CycleCollector::Collect() {
+        const auto start = chrono::steady_clock::now();
+
+        vector<shared_ptr<Object>> live;
+        live.reserve(candidates_.size());
+        for (const auto& candidate : candidates_) {
+            if (auto instance = candidate.lock(); instance) {
+                live.push_back(move(instance));
+            }
+        }
+        candidates_.clear();
+
+        unordered_map<const Object*, size_t> index;
+        vector<long> gc_refs(live.size());
+        for (size_t i = 0; i < live.size(); ++i) {
+            index.emplace(live[i].get(), i);
+            gc_refs[i] = live[i].use_count() - 1;
+        }
+
+        const size_t npos = live.size();
+        auto find_tracked = [&](const ObjectHolder& holder) {
+            if (auto it = index.find(holder.Get()); it != index.end()) {
+                const auto& owner = live[it->second];
+                if (!holder.data_.owner_before(owner) && !owner.owner_before(holder.data_)) {
+                    return it->second;
+                }
+            }
+            return npos;
+        };
+        auto fields = [&live](size_t i) -> Closure& {
+            return static_cast<ClassInstance*>(live[i].get())->Fields();
+        };
+
+        // Trial deletion: remove the references the candidates hold to each other; whatever is
+        // still referenced is reachable from outside, and so is everything it points to.
+        for (size_t i = 0; i < live.size(); ++i) {
+            for (const auto& [name, value] : fields(i)) {
+                if (size_t j = find_tracked(value); j != npos) {
+                    --gc_refs[j];
+                }
+            }
+        }
+
+        vector<bool> reachable(live.size(), false);
+        vector<size_t> pending;
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (gc_refs[i] > 0) {
+                reachable[i] = true;
+                pending.push_back(i);
+            }
+        }
+        while (!pending.empty()) {
+            const size_t i = pending.back();
+            pending.pop_back();
+            for (const auto& [name, value] : fields(i)) {
+                if (size_t j = find_tracked(value); j != npos && !reachable[j]) {
+                    reachable[j] = true;
+                    pending.push_back(j);
+                }
+            }
+        }
+
+        vector<Closure> garbage_fields;
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (reachable[i]) {
+                candidates_.push_back(live[i]);
+            }
+            else {
+                garbage_fields.push_back(move(fields(i)));
+                fields(i).clear();
+            }
+        }
+        const size_t collected = garbage_fields.size();
+        live.clear();
+        garbage_fields.clear();
+
+        const auto pause = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        allocations_since_collect_ = 0;
+        compact_at_ = max(MIN_COMPACT_SIZE, 2 * candidates_.size());
+        ++stats_.collections;
+        stats_.collected += collected;
+        stats_.tracked = candidates_.size();
+        stats_.last_pause = pause;
+        stats_.max_pause = max(stats_.max_pause, pause);
+        stats_.total_pause += pause;
+        return collected;
+    }
+
+    const CollectorStats& CycleCollector::GetStats() const {
+        return stats_;
+    }
+
+}  // namespace runtime
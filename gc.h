@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace runtime {
+
+    class Object;
+    class ObjectHolder;
+
+    // ----------------------CollectorStats-----------------------
+
+    struct CollectorStats {
+        size_t                                         collections = 0;
+        size_t                                         collected = 0;
+        size_t                                         tracked = 0;
+        std::chrono::nanoseconds                       last_pause{0};
+        std::chrono::nanoseconds                       max_pause{0};
+        std::chrono::nanoseconds                       total_pause{0};
+    };
+
+    // ----------------------CycleCollector-----------------------
+
+    class CycleCollector {
+    public:
+        static constexpr size_t                        DEFAULT_THRESHOLD = 10000;
+
+        class Scope {
+        public:
+            explicit                                   Scope(CycleCollector& collector);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            CycleCollector* previous_;
+        };
+
+        explicit                                       CycleCollector(size_t threshold = DEFAULT_THRESHOLD);
+
+        [[nodiscard]] static CycleCollector* Current();
+
+        static void                                    AtSafePoint();
+
+        void                                           Track(const ObjectHolder& instance);
+
+        [[nodiscard]] bool                             IsCollectionPending() const;
+
+        size_t                                         Collect();
+
+        [[nodiscard]] const CollectorStats& GetStats() const;
+
+    private:
+        size_t                                         threshold_;
+        size_t                                         allocations_since_collect_ = 0;
+        // An expired weak_ptr still pins the storage of an object made by allocate_shared, so
+        // Track drops expired candidates whenever their number has doubled.
+        std::vector<std::weak_ptr<Object>>             candidates_;
+        size_t                                         compact_at_;
+        CollectorStats                                 stats_;
+
+        static inline thread_local CycleCollector* current_ = nullptr;
+    };
+
+    inline CycleCollector* CycleCollector::Current() {
+        return current_;
+    }
+
+    inline void CycleCollector::AtSafePoint() {
+        if (current_ && current_->IsCollectionPending()) {
+            current_->Collect();
+        }
+    }
+
+    inline bool CycleCollector::IsCollectionPending() const {
+        return allocations_since_collect_ >= threshold_;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,148 @@
+#include "gc.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+void TestCollectsTwoInstanceCycle() {
+    Class cls("Node"s, {}, nullptr);
+    CycleCollector collector;
+    CycleCollector::Scope scope(collector);
+    {
+        ObjectHolder parent = ObjectHolder::Own(ClassInstance(cls));
+        ObjectHolder child = ObjectHolder::Own(ClassInstance(cls));
+        parent.TryAs<ClassInstance>()->Fields()["child"s] = child;
+        child.TryAs<ClassInstance>()->Fields()["parent"s] = parent;
+        child.TryAs<ClassInstance>()->Fields()["value"s] = ObjectHolder::Own(Number(1));
+    }
+    ASSERT_EQUAL(collector.GetStats().tracked, 2U);
+    ASSERT_EQUAL(collector.Collect(), 2U);
+    ASSERT_EQUAL(collector.GetStats().tracked, 0U);
+    ASSERT_EQUAL(collector.GetStats().collections, 1U);
+    ASSERT_EQUAL(collector.GetStats().collected, 2U);
+    ASSERT(collector.GetStats().max_pause >= collector.GetStats().last_pause);
+}
+
+void TestKeepsReachableCycle() {
+    Class cls("Node"s, {}, nullptr);
+    CycleCollector collector;
+    CycleCollector::Scope scope(collector);
+
+    ObjectHolder root = ObjectHolder::Own(ClassInstance(cls));
+    {
+        ObjectHolder a = ObjectHolder::Own(ClassInstance(cls));
+        ObjectHolder b = ObjectHolder::Own(ClassInstance(cls));
+        a.TryAs<ClassInstance>()->Fields()["next"s] = b;
+        b.TryAs<ClassInstance>()->Fields()["next"s] = a;
+        root.TryAs<ClassInstance>()->Fields()["cycle"s] = a;
+    }
+    ASSERT_EQUAL(collector.Collect(), 0U);
+    ASSERT_EQUAL(collector.GetStats().tracked, 3U);
+
+    root.TryAs<ClassInstance>()->Fields().clear();
+    ASSERT_EQUAL(collector.Collect(), 2U);
+    ASSERT_EQUAL(collector.GetStats().tracked, 1U);
+}
+
+void TestCollectsSelfReference() {
+    istringstream input(R"(
+class Node:
+  def link():
+    self.me = self
+)");
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+    DummyContext context;
+    Closure closure;
+    program->Execute(closure, context);
+    const auto& cls = *closure.at("Node"s).TryAs<Class>();
+
+    CycleCollector collector;
+    CycleCollector::Scope scope(collector);
+    {
+        ObjectHolder node = ObjectHolder::Own(ClassInstance(cls));
+        node.TryAs<ClassInstance>()->Call("link"s, {}, context);
+        ASSERT_EQUAL(node.TryAs<ClassInstance>()->Fields().at("me"s).Get(), node.Get());
+    }
+    ASSERT_EQUAL(collector.Collect(), 1U);
+}
+
+void TestSelfReferenceFreedWithoutCollector() {
+    const auto program = CompileFromString(R"(
+class Node:
+  def __init__():
+    self.me = self
+
+x = Node()
+)");
+    for (auto mode : {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS, ExecutionMode::CLOSURE_COMPILED,
+                      ExecutionMode::SEALED_TREE}) {
+        DummyContext context;
+        weak_ptr<Object> node;
+        {
+            Closure closure;
+            program->Execute(closure, context, mode);
+            node = closure.at("x"s).Get()->weak_from_this();
+            ASSERT(!node.expired());
+        }
+        ASSERT(node.expired());
+    }
+}
+
+void TestCollectionThreshold() {
+    Class cls("Node"s, {}, nullptr);
+    CycleCollector collector(3);
+    CycleCollector::Scope scope(collector);
+
+    ObjectHolder first = ObjectHolder::Own(ClassInstance(cls));
+    first.TryAs<ClassInstance>()->Fields()["self"s] = first;
+    first = ObjectHolder::None();
+    ASSERT(!collector.IsCollectionPending());
+
+    ObjectHolder second = ObjectHolder::Own(ClassInstance(cls));
+    ObjectHolder third = ObjectHolder::Own(ClassInstance(cls));
+    ASSERT(collector.IsCollectionPending());
+
+    CycleCollector::AtSafePoint();
+    ASSERT(!collector.IsCollectionPending());
+    ASSERT_EQUAL(collector.GetStats().collected, 1U);
+    ASSERT_EQUAL(collector.GetStats().tracked, 2U);
+}
+
+void TestPrunesExpiredCandidates() {
+    Class cls("Node"s, {}, nullptr);
+    CycleCollector collector(100000);
+    CycleCollector::Scope scope(collector);
+
+    ObjectHolder kept = ObjectHolder::Own(ClassInstance(cls));
+    for (int i = 0; i < 10000; ++i) {
+        ObjectHolder temporary = ObjectHolder::Own(ClassInstance(cls));
+    }
+    ASSERT(collector.GetStats().tracked <= 1024U);
+    ASSERT(!collector.IsCollectionPending());
+
+    kept.TryAs<ClassInstance>()->Fields()["self"s] = kept;
+    kept = ObjectHolder::None();
+    ASSERT_EQUAL(collector.Collect(), 1U);
+    ASSERT_EQUAL(collector.GetStats().tracked, 0U);
+}
+
+}  // namespace
+
+void RunCycleCollectorTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestCollectsTwoInstanceCycle);
+    RUN_TEST(tr, runtime::TestKeepsReachableCycle);
+    RUN_TEST(tr, runtime::TestCollectsSelfReference);
+    RUN_TEST(tr, runtime::TestSelfReferenceFreedWithoutCollector);
+    RUN_TEST(tr, runtime::TestCollectionThreshold);
+    RUN_TEST(tr, runtime::TestPrunesExpiredCandidates);
+}
+
+}  // namespace runtime
@@ -0,0 +1,333 @@
+#include "heap.h"
+
+#include "runtime.h"
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <tuple>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+
+        constexpr size_t MIN_COMPACT_SIZE = 1024;
+
+        string GroupName(const Object& object, ObjectKind kind) {
+            switch (kind) {
+            case ObjectKind::NUMBER:
+                return "Number"s;
+            case ObjectKind::STRING:
+                return "String"s;
+            case ObjectKind::BOOL:
+                return "Bool"s;
+            case ObjectKind::INSTANCE:
+                return static_cast<const ClassInstance&>(object).GetClass().GetName();
+            case ObjectKind::CLASS:
+                return "Class"s;
+            case ObjectKind::OTHER:
+                break;
+            }
+            return "Object"s;
+        }
+
+        size_t ShallowBytes(const Object& object, ObjectKind kind) {
+            switch (kind) {
+            case ObjectKind::NUMBER:
+                return sizeof(Number);
+            case ObjectKind::STRING:
+                return sizeof(String) + ExternalBytes(static_cast<const String&>(object));
+            case ObjectKind::BOOL:
+                return sizeof(Bool);
+            case ObjectKind::INSTANCE:
+                return sizeof(ClassInstance) + static_cast<const ClassInstance&>(object).GetFieldBytes();
+            case ObjectKind::CLASS:
+                return sizeof(Class);
+            case ObjectKind::OTHER:
+                break;
+            }
+            return sizeof(Object);
+        }
+
+        // ----------------------DominatorTree-----------------------
+
+        // Immediate dominators by the iterative algorithm of Cooper, Harvey and Kennedy. Node
+        // count - 1 is the root, and every node is reachable from it.
+        vector<size_t> ImmediateDominators(const vector<vector<size_t>>& successors, vector<size_t>& postorder) {
+            const size_t count = successors.size();
+            const size_t root = count - 1;
+            const size_t none = count;
+
+            vector<size_t> number(count, none);
+            vector<pair<size_t, size_t>> stack = {{root, 0}};
+            vector<bool> visited(count, false);
+            visited[root] = true;
+            while (!stack.empty()) {
+                auto& [node, next] = stack.back();
+                if (next < successors[node].size()) {
+                    const size_t successor = successors[node][next++];
+                    if (!visited[successor]) {
+                        visited[successor] = true;
+                        stack.emplace_back(successor, 0);
+                    }
+                    continue;
+                }
+                number[node] = postorder.size();
+                postorder.push_back(node);
+                stack.pop_back();
+            }
+
+            vector<vector<size_t>> predecessors(count);
+            for (size_t node = 0; node < count; ++node) {
+                for (size_t successor : successors[node]) {
+                    predecessors[successor].push_back(node);
+                }
+            }
+
+            vector<size_t> idom(count, none);
+            idom[root] = root;
+            auto intersect = [&](size_t lhs, size_t rhs) {
+                while (lhs != rhs) {
+                    while (number[lhs] < number[rhs]) {
+                        lhs = idom[lhs];
+                    }
+                    while (number[rhs] < number[lhs]) {
+                        rhs = idom[rhs];
+                    }
+                }
+                return lhs;
+            };
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+                    const size_t node = *it;
+                    if (node == root) {
+                        continue;
+                    }
+                    size_t dominator = none;
+                    for (size_t predecessor : predecessors[node]) {
+                        if (idom[predecessor] != none) {
+                            dominator = dominator == none ? predecessor : intersect(predecessor, dominator);
+                        }
+                    }
+                    if (idom[node] != dominator) {
+                        idom[node] = dominator;
+                        changed = true;
+                    }
+                }
+            }
+            return idom;
+        }
+
+    }  // namespace
+
+    // ----------------------Scope-----------------------
+
+    HeapProfiler::Scope::Scope(HeapProfiler& profiler)
+        : previous_(current_) {
+        current_ = &profiler;
+    }
+
+    HeapProfiler::Scope::~Scope() {
+        current_ = previous_;
+        if (!current_) {
+            site_ = nullptr;
+        }
+    }
+
+    // ----------------------HeapProfiler-----------------------
+
+    HeapProfiler::HeapProfiler(bool record_sites)
+        : record_sites_(record_sites)
+        , compact_at_(MIN_COMPACT_SIZE) {}
+
+    void HeapProfiler::Track(const ObjectHolder& object, ObjectKind kind) {
+        if (entries_.size() >= compact_at_) {
+            entries_.erase(remove_if(entries_.begin(), entries_.end(), [](const Entry& entry) {
+                return entry.object.expired();
+            }), entries_.end());
+            compact_at_ = max(MIN_COMPACT_SIZE, 2 * entries_.size());
+        }
+        const uint32_t line = record_sites_ && site_ ? site_->GetPosition().line : 0;
+        entries_.push_back(Entry{object.data_, kind, line});
+    }
+
+    HeapSnapshot HeapProfiler::TakeSnapshot() const {
+        vector<shared_ptr<Object>> live;
+        vector<const Entry*> entries;
+        for (const Entry& entry : entries_) {
+            if (auto object = entry.object.lock(); object) {
+                live.push_back(move(object));
+                entries.push_back(&entry);
+            }
+        }
+        const size_t count = live.size();
+
+        unordered_map<const Object*, size_t> index;
+        vector<long> external_refs(count);
+        for (size_t i = 0; i < count; ++i) {
+            index.emplace(live[i].get(), i);
+            external_refs[i] = live[i].use_count() - 1;
+        }
+
+        // The graph of owning field references between tracked objects, plus a root above the
+        // objects still referenced once those are discounted, as in CycleCollector::Collect.
+        vector<vector<size_t>> successors(count + 1);
+        for (size_t i = 0; i < count; ++i) {
+            if (entries[i]->kind != ObjectKind::INSTANCE) {
+                continue;
+            }
+            for (const auto& [name, value] : static_cast<const ClassInstance&>(*live[i]).Fields()) {
+                if (auto it = index.find(value.Get()); it != index.end()) {
+                    const auto& owner = live[it->second];
+                    if (!value.data_.owner_before(owner) && !owner.owner_before(value.data_)) {
+                        successors[i].push_back(it->second);
+                        --external_refs[it->second];
+                    }
+                }
+            }
+        }
+        const size_t root = count;
+        for (size_t i = 0; i < count; ++i) {
+            if (external_refs[i] > 0) {
+                successors[root].push_back(i);
+            }
+        }
+        // Unreferenced cycles are only reachable from themselves; hang them off the root too.
+        vector<bool> reached(count + 1, false);
+        vector<size_t> pending;
+        for (size_t start = count + 1; start-- > 0;) {
+            if (reached[start]) {
+                continue;
+            }
+            if (start != root) {
+                successors[root].push_back(start);
+            }
+            reached[start] = true;
+            pending.push_back(start);
+            while (!pending.empty()) {
+                const size_t node = pending.back();
+                pending.pop_back();
+                for (size_t successor : successors[node]) {
+                    if (!reached[successor]) {
+                        reached[successor] = true;
+                        pending.push_back(successor);
+                    }
+                }
+            }
+        }
+        vector<size_t> postorder;
+        const vector<size_t> idom = ImmediateDominators(successors, postorder);
+
+        HeapSnapshot snapshot;
+        snapshot.objects = count;
+        vector<size_t> retained(count + 1, 0);
+        vector<size_t> group_of(count);
+        map<string, size_t> group_index;
+        map<pair<uint32_t, string>, HeapSite> sites;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t shallow = ShallowBytes(*live[i], entries[i]->kind);
+            string name = GroupName(*live[i], entries[i]->kind);
+            auto [it, inserted] = group_index.emplace(name, snapshot.groups.size());
+            if (inserted) {
+                snapshot.groups.push_back(HeapGroup{name, 0, 0, 0});
+            }
+            group_of[i] = it->second;
+            HeapGroup& group = snapshot.groups[it->second];
+            ++group.count;
+            group.shallow_bytes += shallow;
+            snapshot.shallow_bytes += shallow;
+            retained[i] = shallow;
+            if (record_sites_) {
+                HeapSite& site = sites[{entries[i]->line, name}];
+                site.line = entries[i]->line;
+                site.name = move(name);
+                ++site.count;
+                site.shallow_bytes += shallow;
+            }
+        }
+        // A dominator comes after the nodes it dominates in postorder.
+        for (size_t node : postorder) {
+            if (node != root) {
+                retained[idom[node]] += retained[node];
+            }
+        }
+
+        // An object adds its retained bytes to its group unless a dominator of the same group
+        // already has.
+        vector<vector<size_t>> children(count + 1);
+        for (size_t node = 0; node < count; ++node) {
+            children[idom[node]].push_back(node);
+        }
+        vector<size_t> active(snapshot.groups.size(), 0);
+        vector<pair<size_t, bool>> stack = {{root, false}};
+        while (!stack.empty()) {
+            const auto [node, leaving] = stack.back();
+            stack.pop_back();
+            if (node == root) {
+                for (size_t child : children[node]) {
+                    stack.emplace_back(child, false);
+                }
+                continue;
+            }
+            const size_t group = group_of[node];
+            if (leaving) {
+                --active[group];
+                continue;
+            }
+            if (active[group]++ == 0) {
+                snapshot.groups[group].retained_bytes += retained[node];
+            }
+            stack.emplace_back(node, true);
+            for (size_t child : children[node]) {
+                stack.emplace_back(child, false);
+            }
+        }
+
+        sort(snapshot.groups.begin(), snapshot.groups.end(), [](const HeapGroup& lhs, const HeapGroup& rhs) {
+            return tie(rhs.retained_bytes, lhs.name) < tie(lhs.retained_bytes, rhs.name);
+        });
+        for (auto& [key, site] : sites) {
+            snapshot.sites.push_back(move(site));
+        }
+        stable_sort(snapshot.sites.begin(), snapshot.sites.end(), [](const HeapSite& lhs, const HeapSite& rhs) {
+            return lhs.shallow_bytes > rhs.shallow_bytes;
+        });
+        return snapshot;
+    }
+
+    // ----------------------HeapSnapshot-----------------------
+
+    void HeapSnapshot::WriteText(ostream& out) const {
+        out << "objects " << objects << ", shallow bytes " << shallow_bytes << '\n';
+        out << "count shallow retained group\n";
+        for (const HeapGroup& group : groups) {
+            out << group.count << ' ' << group.shallow_bytes << ' ' << group.retained_bytes << ' ' << group.name << '\n';
+        }
+        if (!sites.empty()) {
+            out << "count shallow line group\n";
+            for (const HeapSite& site : sites) {
+                out << site.count << ' ' << site.shallow_bytes << ' ' << site.line << ' ' << site.name << '\n';
+            }
+        }
+    }
+
+    void HeapSnapshot::WriteJson(ostream& out) const {
+        out << "{\"objects\": " << objects << ", \"shallow_bytes\": " << shallow_bytes << ", \"groups\": [";
+        for (size_t i = 0; i < groups.size(); ++i) {
+            out << (i ? ", " : "") << "{\"name\": \"" << groups[i].name << "\", \"count\": " << groups[i].count
+                << ", \"shallow_bytes\": " << groups[i].shallow_bytes
+                << ", \"retained_bytes\": " << groups[i].retained_bytes << '}';
+        }
+        out << "], \"sites\": [";
+        for (size_t i = 0; i < sites.size(); ++i) {
+            out << (i ? ", " : "") << "{\"line\": " << sites[i].line << ", \"name\": \"" << sites[i].name
+                << "\", \"count\": " << sites[i].count << ", \"shallow_bytes\": " << sites[i].shallow_bytes << '}';
+        }
+        out << "]}\n";
+    }
+
+}  // namespace runtime
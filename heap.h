@@ -0,0 +1,126 @@
+#pragma once
+
+#include "stats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+    class Executable;
+    class Object;
+    class ObjectHolder;
+
+    // ----------------------HeapSnapshot-----------------------
+
+    // Live objects of one class, or of one built-in kind ("Number", "String", "Bool", "Class").
+    // The retained bytes of a group are those that would be freed if all of its objects were.
+    struct HeapGroup {
+        std::string                                    name;
+        size_t                                         count = 0;
+        size_t                                         shallow_bytes = 0;
+        size_t                                         retained_bytes = 0;
+    };
+
+    // Live objects allocated while the statement at line was executing; line 0 for objects
+    // allocated outside of any statement.
+    struct HeapSite {
+        uint32_t                                       line = 0;
+        std::string                                    name;
+        size_t                                         count = 0;
+        size_t                                         shallow_bytes = 0;
+    };
+
+    struct HeapSnapshot {
+        size_t                                         objects = 0;
+        size_t                                         shallow_bytes = 0;
+        std::vector<HeapGroup>                         groups;
+        std::vector<HeapSite>                          sites;
+
+        void                                           WriteText(std::ostream& out) const;
+
+        void                                           WriteJson(std::ostream& out) const;
+    };
+
+    // ----------------------HeapProfiler-----------------------
+
+    // Keeps track of the objects ObjectHolder::Own creates on a thread while a Scope is open,
+    // without keeping them alive, so that a snapshot of those still alive can be taken at any
+    // time. Retained sizes come from the dominator tree of the graph of instance fields: objects
+    // referenced from outside the graph, by variables, constants or the C++ stack, are its roots.
+    class HeapProfiler {
+    public:
+        class Scope {
+        public:
+            explicit                                   Scope(HeapProfiler& profiler);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            HeapProfiler* previous_;
+        };
+
+        // Restores the allocation site of the caller when a method returns.
+        class CallSite {
+        public:
+                                                       CallSite();
+
+            CallSite(const CallSite&) = delete;
+            CallSite& operator=(const CallSite&) = delete;
+
+            ~CallSite();
+
+        private:
+            const Executable* saved_;
+        };
+
+        explicit                                       HeapProfiler(bool record_sites = false);
+
+        [[nodiscard]] static HeapProfiler* Current();
+
+        static void                                    AtStatement(const Executable& statement);
+
+        void                                           Track(const ObjectHolder& object, ObjectKind kind);
+
+        [[nodiscard]] HeapSnapshot                     TakeSnapshot() const;
+
+    private:
+        struct Entry {
+            std::weak_ptr<Object>                      object;
+            ObjectKind                                 kind;
+            uint32_t                                   line;
+        };
+
+        bool                                           record_sites_;
+        std::vector<Entry>                             entries_;
+        size_t                                         compact_at_;
+
+        static inline thread_local HeapProfiler* current_ = nullptr;
+        static inline thread_local const Executable* site_ = nullptr;
+    };
+
+    inline HeapProfiler* HeapProfiler::Current() {
+        return current_;
+    }
+
+    inline void HeapProfiler::AtStatement(const Executable& statement) {
+        if (current_ && current_->record_sites_) {
+            site_ = &statement;
+        }
+    }
+
+    inline HeapProfiler::CallSite::CallSite()
+        : saved_(site_) {}
+
+    inline HeapProfiler::CallSite::~CallSite() {
+        site_ = saved_;
+    }
+
+}  // namespace runtime
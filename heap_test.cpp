@@ -0,0 +1,178 @@
+#include "heap.h"
+#include "lexer.h"
+#include "program.h"
+#include "runtime.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string CHAIN_PROGRAM = R"(
+class Node:
+  def __init__(next):
+    self.next = next
+
+class Leaf:
+  def __init__():
+    self.name = 'leaf'
+
+head = Node(Node(Node(Leaf())))
+other = Leaf()
+)"s;
+
+void Run(const string& source, Closure& closure) {
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    auto program = CompileProgram(lexer);
+    DummyContext context;
+    program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+}
+
+const HeapGroup& FindGroup(const HeapSnapshot& snapshot, const string& name) {
+    for (const HeapGroup& group : snapshot.groups) {
+        if (group.name == name) {
+            return group;
+        }
+    }
+    throw runtime_error("No group "s + name);
+}
+
+void TestCountsLiveObjectsByGroup() {
+    HeapProfiler profiler;
+    HeapProfiler::Scope scope(profiler);
+    ObjectHolder kept = ObjectHolder::Own(Number(1));
+    ObjectHolder text = ObjectHolder::Own(String("text"s));
+    {
+        ObjectHolder number = ObjectHolder::Own(Number(2));
+        ObjectHolder flag = ObjectHolder::Own(Bool(true));
+    }
+
+    const HeapSnapshot snapshot = profiler.TakeSnapshot();
+    ASSERT_EQUAL(snapshot.objects, 2u);
+    ASSERT_EQUAL(snapshot.groups.size(), 2u);
+    ASSERT_EQUAL(FindGroup(snapshot, "Number"s).count, 1u);
+    ASSERT_EQUAL(FindGroup(snapshot, "Number"s).shallow_bytes, sizeof(Number));
+    ASSERT_EQUAL(FindGroup(snapshot, "String"s).count, 1u);
+    ASSERT(FindGroup(snapshot, "String"s).shallow_bytes >= sizeof(String));
+    ASSERT_EQUAL(snapshot.shallow_bytes,
+                 FindGroup(snapshot, "Number"s).shallow_bytes + FindGroup(snapshot, "String"s).shallow_bytes);
+    ASSERT(snapshot.sites.empty());
+    ASSERT(HeapProfiler::Current() == &profiler);
+}
+
+void TestRetainedSizesFollowFields() {
+    HeapProfiler profiler;
+    Closure closure;
+    {
+        HeapProfiler::Scope scope(profiler);
+        Run(CHAIN_PROGRAM, closure);
+    }
+    ASSERT(HeapProfiler::Current() == nullptr);
+
+    const HeapSnapshot snapshot = profiler.TakeSnapshot();
+    const HeapGroup& node = FindGroup(snapshot, "Node"s);
+    const HeapGroup& leaf = FindGroup(snapshot, "Leaf"s);
+    const HeapGroup& name = FindGroup(snapshot, "String"s);
+    ASSERT_EQUAL(node.count, 3u);
+    ASSERT_EQUAL(leaf.count, 2u);
+    ASSERT_EQUAL(name.count, 1u);
+    ASSERT_EQUAL(FindGroup(snapshot, "Class"s).count, 2u);
+    ASSERT_EQUAL(snapshot.objects, 8u);
+
+    // The head retains the whole chain but not the constant 'leaf', which the body of
+    // Leaf.__init__ holds as well.
+    const size_t leaf_bytes = leaf.shallow_bytes / 2;
+    ASSERT_EQUAL(node.retained_bytes, node.shallow_bytes + leaf_bytes);
+    ASSERT_EQUAL(leaf.retained_bytes, leaf.shallow_bytes);
+    ASSERT_EQUAL(name.retained_bytes, name.shallow_bytes);
+    ASSERT_EQUAL(snapshot.groups.front().name, "Node"s);
+
+    closure.erase("head"s);
+    const HeapSnapshot released = profiler.TakeSnapshot();
+    ASSERT_EQUAL(released.objects, 4u);
+    ASSERT_EQUAL(FindGroup(released, "Leaf"s).retained_bytes, leaf_bytes);
+}
+
+void TestGarbageCyclesAreRetainedByThemselves() {
+    HeapProfiler profiler;
+    HeapProfiler::Scope scope(profiler);
+    Class cls("Pair"s, {}, nullptr);
+    ObjectHolder first = ObjectHolder::Own(ClassInstance(cls));
+    ObjectHolder second = ObjectHolder::Own(ClassInstance(cls));
+    first.TryAs<ClassInstance>()->Fields()["other"s] = second;
+    second.TryAs<ClassInstance>()->Fields()["other"s] = first;
+    first = ObjectHolder::None();
+    second = ObjectHolder::None();
+
+    const HeapSnapshot snapshot = profiler.TakeSnapshot();
+    ASSERT_EQUAL(snapshot.objects, 2u);
+    const HeapGroup& pair = FindGroup(snapshot, "Pair"s);
+    ASSERT_EQUAL(pair.count, 2u);
+    ASSERT_EQUAL(pair.retained_bytes, pair.shallow_bytes);
+}
+
+void TestRecordsAllocationSites() {
+    HeapProfiler profiler(true);
+    Closure closure;
+    {
+        HeapProfiler::Scope scope(profiler);
+        Run(CHAIN_PROGRAM, closure);
+    }
+    const HeapSnapshot snapshot = profiler.TakeSnapshot();
+    ASSERT_EQUAL(snapshot.sites.size(), 5u);
+    size_t leaves = 0;
+    for (const HeapSite& site : snapshot.sites) {
+        if (site.name == "Node"s) {
+            ASSERT_EQUAL(site.line, 10u);
+            ASSERT_EQUAL(site.count, 3u);
+        } else if (site.name == "String"s || site.name == "Class"s) {
+            // Constants and classes are created by the parser.
+            ASSERT_EQUAL(site.line, 0u);
+        } else {
+            ASSERT_EQUAL(site.name, "Leaf"s);
+            ASSERT(site.line == 10u || site.line == 11u);
+            leaves += site.count;
+        }
+    }
+    ASSERT_EQUAL(leaves, 2u);
+
+    ostringstream text;
+    snapshot.WriteText(text);
+    ASSERT(text.str().rfind("objects 8, shallow bytes "s, 0) == 0);
+    ASSERT(text.str().find("\n3 "s + to_string(FindGroup(snapshot, "Node"s).shallow_bytes) + " 10 Node\n"s) != string::npos);
+
+    ostringstream json;
+    snapshot.WriteJson(json);
+    ASSERT(json.str().rfind("{\"objects\": 8, \"shallow_bytes\": "s, 0) == 0);
+    ASSERT(json.str().find("{\"name\": \"Node\", \"count\": 3, "s) != string::npos);
+    ASSERT(json.str().find("{\"line\": 11, \"name\": \"Leaf\", \"count\": 1, "s) != string::npos);
+}
+
+void TestCompactsExpiredEntries() {
+    HeapProfiler profiler;
+    HeapProfiler::Scope scope(profiler);
+    ObjectHolder kept = ObjectHolder::Own(Number(0));
+    for (int i = 0; i < 10000; ++i) {
+        ObjectHolder dropped = ObjectHolder::Own(Number(i));
+    }
+    const HeapSnapshot snapshot = profiler.TakeSnapshot();
+    ASSERT_EQUAL(snapshot.objects, 1u);
+    ASSERT_EQUAL(snapshot.shallow_bytes, sizeof(Number));
+}
+
+}  // namespace
+
+void RunHeapTests(TestRunner& tr) {
+    RUN_TEST(tr, TestCountsLiveObjectsByGroup);
+    RUN_TEST(tr, TestRetainedSizesFollowFields);
+    RUN_TEST(tr, TestGarbageCyclesAreRetainedByThemselves);
+    RUN_TEST(tr, TestRecordsAllocationSites);
+    RUN_TEST(tr, TestCompactsExpiredEntries);
+}
+
+}  // namespace runtime
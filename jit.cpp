@@ -0,0 +1,632 @@
+#include "jit.h"
+
+#include "statement.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define MYTHON_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+namespace jit {
+
+    namespace {
+        const string SELF = "self"s;
+
+        // What compiled code receives besides its arguments. The layout is fixed: the code reads
+        // bailed at BAILED_OFFSET.
+        struct NativeFrame {
+            runtime::ClassInstance* self;
+            bool                                       bailed;
+        };
+
+        constexpr uint32_t BAILED_OFFSET = offsetof(NativeFrame, bailed);
+
+        using NativeFunction = int32_t (*)(const int64_t* args, NativeFrame* frame);
+
+        using Comparator = bool (*)(const runtime::ObjectHolder&, const runtime::ObjectHolder&, runtime::Context&);
+
+        int32_t LoadField(NativeFrame* frame, const string* name) noexcept {
+            const runtime::Closure& fields = frame->self->Fields();
+            if (auto it = fields.find(*name); it != fields.end()) {
+                if (auto number = it->second.TryAs<runtime::Number>(); number) {
+                    return number->GetValue();
+                }
+            }
+            frame->bailed = true;
+            return 0;
+        }
+
+        // ----------------------Assembler-----------------------
+
+        class Assembler {
+        public:
+            struct Label {
+                ptrdiff_t                              position = -1;
+                vector<size_t>                         fixups;
+            };
+
+            void Bytes(initializer_list<uint8_t> bytes) {
+                code_.insert(code_.end(), bytes);
+            }
+
+            void Imm32(uint32_t value) {
+                for (int i = 0; i < 4; ++i) {
+                    code_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+                }
+            }
+
+            void Imm64(uint64_t value) {
+                for (int i = 0; i < 8; ++i) {
+                    code_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+                }
+            }
+
+            void Jump(Label& label) {
+                Bytes({0xE9});
+                Target(label);
+            }
+
+            void JumpIfEqual(Label& label) {
+                Bytes({0x0F, 0x84});
+                Target(label);
+            }
+
+            void JumpIfNotEqual(Label& label) {
+                Bytes({0x0F, 0x85});
+                Target(label);
+            }
+
+            void Bind(Label& label) {
+                label.position = static_cast<ptrdiff_t>(code_.size());
+                for (size_t fixup : label.fixups) {
+                    Patch(fixup, label.position);
+                }
+                label.fixups.clear();
+            }
+
+            vector<uint8_t> Take() {
+                return move(code_);
+            }
+
+        private:
+            void Target(Label& label) {
+                const size_t fixup = code_.size();
+                Imm32(0);
+                if (label.position >= 0) {
+                    Patch(fixup, label.position);
+                }
+                else {
+                    label.fixups.push_back(fixup);
+                }
+            }
+
+            void Patch(size_t fixup, ptrdiff_t target) {
+                const auto relative = static_cast<uint32_t>(static_cast<int32_t>(target - static_cast<ptrdiff_t>(fixup + 4)));
+                for (int i = 0; i < 4; ++i) {
+                    code_[fixup + i] = static_cast<uint8_t>(relative >> (8 * i));
+                }
+            }
+
+            vector<uint8_t> code_;
+        };
+
+        // ----------------------CodeGen-----------------------
+
+        // Emits a method as a stack machine over eax: every expression leaves its value in eax and
+        // intermediate values are pushed on the native stack. rbx holds the arguments, r12 the frame.
+        class CodeGen {
+        public:
+            // Returns the address of the entry slot of another method of the class, or null if it
+            // cannot be compiled.
+            using Resolver = function<void* const*(const runtime::Method&)>;
+
+            CodeGen(const runtime::Class& cls, const runtime::Method& method, Resolver resolve)
+                : cls_(cls)
+                , method_(method)
+                , resolve_(move(resolve)) {}
+
+            bool Generate(vector<uint8_t>& code) {
+                asm_.Bytes({0x55});                    // push rbp
+                asm_.Bytes({0x48, 0x89, 0xE5});        // mov rbp, rsp
+                asm_.Bytes({0x53});                    // push rbx
+                asm_.Bytes({0x41, 0x54});              // push r12
+                asm_.Bytes({0x48, 0x89, 0xFB});        // mov rbx, rdi
+                asm_.Bytes({0x49, 0x89, 0xF4});        // mov r12, rsi
+
+                if (!CompileStatement(*method_.body)) {
+                    return false;
+                }
+                // Falling off the end returns None, which only the interpreter can produce.
+                asm_.Bind(bail_);
+                asm_.Bytes({0x41, 0xC6, 0x84, 0x24});  // mov byte [r12 + bailed], 1
+                asm_.Imm32(BAILED_OFFSET);
+                asm_.Bytes({0x01});
+                asm_.Bind(epilogue_);
+                asm_.Bytes({0x48, 0x8D, 0x65, 0xF0});  // lea rsp, [rbp - 16]
+                asm_.Bytes({0x41, 0x5C});              // pop r12
+                asm_.Bytes({0x5B});                    // pop rbx
+                asm_.Bytes({0x5D});                    // pop rbp
+                asm_.Bytes({0xC3});                    // ret
+                code = asm_.Take();
+                return true;
+            }
+
+        private:
+            enum class Type {
+                INT,
+                BOOL
+            };
+
+            bool CompileStatement(runtime::Executable& statement) {
+                if (auto node = dynamic_cast<ast::MethodBody*>(&statement); node) {
+                    return CompileStatement(*node->GetBody());
+                }
+                if (auto node = dynamic_cast<ast::Compound*>(&statement); node) {
+                    for (const auto& child : node->GetStatements()) {
+                        if (!CompileStatement(*child)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                if (auto node = dynamic_cast<ast::Return*>(&statement); node) {
+                    if (!CompileInt(*node->GetStatement())) {
+                        return false;
+                    }
+                    asm_.Jump(epilogue_);
+                    return true;
+                }
+                if (auto node = dynamic_cast<ast::IfElse*>(&statement); node) {
+                    Assembler::Label otherwise;
+                    Assembler::Label end;
+                    if (!CompileExpression(*node->GetCondition())) {
+                        return false;
+                    }
+                    TestEax();
+                    asm_.JumpIfEqual(otherwise);
+                    if (!CompileStatement(*node->GetIfBody())) {
+                        return false;
+                    }
+                    asm_.Jump(end);
+                    asm_.Bind(otherwise);
+                    if (node->GetElseBody() && !CompileStatement(*node->GetElseBody())) {
+                        return false;
+                    }
+                    asm_.Bind(end);
+                    return true;
+                }
+                return false;
+            }
+
+            bool CompileInt(runtime::Executable& expression) {
+                auto type = CompileExpression(expression);
+                return type && *type == Type::INT;
+            }
+
+            optional<Type> CompileExpression(runtime::Executable& expression) {
+                if (auto node = dynamic_cast<ast::NumericConst*>(&expression); node) {
+                    asm_.Bytes({0xB8});                // mov eax, imm32
+                    asm_.Imm32(static_cast<uint32_t>(node->GetValue().TryAs<runtime::Number>()->GetValue()));
+                    return Type::INT;
+                }
+                if (auto node = dynamic_cast<ast::BoolConst*>(&expression); node) {
+                    asm_.Bytes({0xB8});
+                    asm_.Imm32(node->GetValue().TryAs<runtime::Bool>()->GetValue() ? 1 : 0);
+                    return Type::BOOL;
+                }
+                if (auto node = dynamic_cast<ast::VariableValue*>(&expression); node) {
+                    return CompileVariable(*node);
+                }
+                if (auto node = dynamic_cast<ast::Add*>(&expression); node) {
+                    return CompileArithmetic(*node, {0x01, 0xC8});          // add eax, ecx
+                }
+                if (auto node = dynamic_cast<ast::Sub*>(&expression); node) {
+                    return CompileArithmetic(*node, {0x29, 0xC8});          // sub eax, ecx
+                }
+                if (auto node = dynamic_cast<ast::Mult*>(&expression); node) {
+                    return CompileArithmetic(*node, {0x0F, 0xAF, 0xC1});    // imul eax, ecx
+                }
+                if (auto node = dynamic_cast<ast::Div*>(&expression); node) {
+                    return CompileDivision(*node);
+                }
+                if (auto node = dynamic_cast<ast::Comparison*>(&expression); node) {
+                    return CompileComparison(*node);
+                }
+                if (auto node = dynamic_cast<ast::And*>(&expression); node) {
+                    return CompileLogical(*node, true);
+                }
+                if (auto node = dynamic_cast<ast::Or*>(&expression); node) {
+                    return CompileLogical(*node, false);
+                }
+                if (auto node = dynamic_cast<ast::Not*>(&expression); node) {
+                    if (!CompileExpression(*node->GetArgument())) {
+                        return nullopt;
+                    }
+                    TestEax();
+                    SetEax(0x94);                      // sete
+                    return Type::BOOL;
+                }
+                if (auto node = dynamic_cast<ast::MethodCall*>(&expression); node) {
+                    return CompileCall(*node);
+                }
+                return nullopt;
+            }
+
+            optional<Type> CompileVariable(const ast::VariableValue& node) {
+                const auto& ids = node.GetDottedIds();
+                if (ids.size() == 1) {
+                    const auto& params = method_.formal_params;
+                    for (size_t i = 0; i < params.size(); ++i) {
+                        if (params[i] == ids[0]) {
+                            asm_.Bytes({0x8B, 0x83});  // mov eax, [rbx + 8 * i]
+                            asm_.Imm32(static_cast<uint32_t>(8 * i));
+                            return Type::INT;
+                        }
+                    }
+                    return nullopt;
+                }
+                if (ids.size() != 2 || ids[0] != SELF) {
+                    return nullopt;
+                }
+                const bool pad = depth_ % 2 != 0;
+                if (pad) {
+                    asm_.Bytes({0x48, 0x83, 0xEC, 0x08});                   // sub rsp, 8
+                }
+                asm_.Bytes({0x4C, 0x89, 0xE7});        // mov rdi, r12
+                asm_.Bytes({0x48, 0xBE});              // mov rsi, imm64
+                asm_.Imm64(reinterpret_cast<uint64_t>(&ids[1]));
+                asm_.Bytes({0x48, 0xB8});              // mov rax, imm64
+                asm_.Imm64(reinterpret_cast<uint64_t>(&LoadField));
+                asm_.Bytes({0xFF, 0xD0});              // call rax
+                if (pad) {
+                    asm_.Bytes({0x48, 0x83, 0xC4, 0x08});                   // add rsp, 8
+                }
+                CheckBailed();
+                return Type::INT;
+            }
+
+            bool CompileOperands(const ast::BinaryOperation& node) {
+                if (!CompileInt(*node.GetLhs())) {
+                    return false;
+                }
+                Push();
+                if (!CompileInt(*node.GetRhs())) {
+                    return false;
+                }
+                asm_.Bytes({0x89, 0xC1});              // mov ecx, eax
+                asm_.Bytes({0x58});                    // pop rax
+                --depth_;
+                return true;
+            }
+
+            optional<Type> CompileArithmetic(const ast::BinaryOperation& node, initializer_list<uint8_t> operation) {
+                if (!CompileOperands(node)) {
+                    return nullopt;
+                }
+                asm_.Bytes(operation);
+                return Type::INT;
+            }
+
+            optional<Type> CompileDivision(const ast::BinaryOperation& node) {
+                if (!CompileOperands(node)) {
+                    return nullopt;
+                }
+                Assembler::Label divide;
+                asm_.Bytes({0x85, 0xC9});              // test ecx, ecx
+                asm_.JumpIfEqual(bail_);
+                asm_.Bytes({0x83, 0xF9, 0xFF});        // cmp ecx, -1
+                asm_.JumpIfNotEqual(divide);
+                asm_.Bytes({0x3D});                    // cmp eax, INT_MIN
+                asm_.Imm32(0x80000000U);
+                asm_.JumpIfEqual(bail_);
+                asm_.Bind(divide);
+                asm_.Bytes({0x99});                    // cdq
+                asm_.Bytes({0xF7, 0xF9});              // idiv ecx
+                return Type::INT;
+            }
+
+            optional<Type> CompileComparison(const ast::Comparison& node) {
+                const Comparator* comparator = node.GetComparator().target<Comparator>();
+                if (!comparator) {
+                    return nullopt;
+                }
+                uint8_t condition = 0;
+                if (*comparator == &runtime::Equal) {
+                    condition = 0x94;                  // sete
+                }
+                else if (*comparator == &runtime::NotEqual) {
+                    condition = 0x95;                  // setne
+                }
+                else if (*comparator == &runtime::Less) {
+                    condition = 0x9C;                  // setl
+                }
+                else if (*comparator == &runtime::GreaterOrEqual) {
+                    condition = 0x9D;                  // setge
+                }
+                else if (*comparator == &runtime::LessOrEqual) {
+                    condition = 0x9E;                  // setle
+                }
+                else if (*comparator == &runtime::Greater) {
+                    condition = 0x9F;                  // setg
+                }
+                else {
+                    return nullopt;
+                }
+                if (!CompileOperands(node)) {
+                    return nullopt;
+                }
+                asm_.Bytes({0x39, 0xC8});              // cmp eax, ecx
+                SetEax(condition);
+                return Type::BOOL;
+            }
+
+            optional<Type> CompileLogical(const ast::BinaryOperation& node, bool is_and) {
+                Assembler::Label short_circuit;
+                Assembler::Label end;
+                if (!CompileExpression(*node.GetLhs())) {
+                    return nullopt;
+                }
+                TestEax();
+                if (is_and) {
+                    asm_.JumpIfEqual(short_circuit);
+                }
+                else {
+                    asm_.JumpIfNotEqual(short_circuit);
+                }
+                if (!CompileExpression(*node.GetRhs())) {
+                    return nullopt;
+                }
+                TestEax();
+                SetEax(0x95);                          // setne
+                asm_.Jump(end);
+                asm_.Bind(short_circuit);
+                asm_.Bytes({0xB8});                    // mov eax, is_and ? 0 : 1
+                asm_.Imm32(is_and ? 0 : 1);
+                asm_.Bind(end);
+                return Type::BOOL;
+            }
+
+            optional<Type> CompileCall(const ast::MethodCall& node) {
+                const auto* object = dynamic_cast<const ast::VariableValue*>(node.GetObject());
+                if (!object || object->GetDottedIds() != vector<string>{SELF}) {
+                    return nullopt;
+                }
+                const auto& args = node.GetArgs();
+                const runtime::Method* callee = cls_.GetMethod(node.GetMethod());
+                if (!callee || callee->formal_params.size() != args.size()) {
+                    return nullopt;
+                }
+                void* const* slot = resolve_(*callee);
+                if (!slot) {
+                    return nullopt;
+                }
+
+                const size_t pad = (depth_ + args.size()) % 2;
+                if (pad) {
+                    asm_.Bytes({0x48, 0x83, 0xEC, 0x08});                   // sub rsp, 8
+                    ++depth_;
+                }
+                // Pushed last to first, so the arguments lie in order from rsp upwards.
+                for (size_t i = args.size(); i > 0; --i) {
+                    if (!CompileInt(*args[i - 1])) {
+                        return nullopt;
+                    }
+                    Push();
+                }
+                asm_.Bytes({0x48, 0x89, 0xE7});        // mov rdi, rsp
+                asm_.Bytes({0x4C, 0x89, 0xE6});        // mov rsi, r12
+                asm_.Bytes({0x48, 0xB8});              // mov rax, imm64
+                asm_.Imm64(reinterpret_cast<uint64_t>(slot));
+                asm_.Bytes({0xFF, 0x10});              // call [rax]
+                const size_t popped = args.size() + pad;
+                asm_.Bytes({0x48, 0x81, 0xC4});        // add rsp, imm32
+                asm_.Imm32(static_cast<uint32_t>(8 * popped));
+                depth_ -= popped;
+                CheckBailed();
+                return Type::INT;
+            }
+
+            void Push() {
+                asm_.Bytes({0x50});                    // push rax
+                ++depth_;
+            }
+
+            void TestEax() {
+                asm_.Bytes({0x85, 0xC0});              // test eax, eax
+            }
+
+            void SetEax(uint8_t condition) {
+                asm_.Bytes({0x0F, condition, 0xC0});   // setcc al
+                asm_.Bytes({0x0F, 0xB6, 0xC0});        // movzx eax, al
+            }
+
+            void CheckBailed() {
+                asm_.Bytes({0x41, 0x80, 0xBC, 0x24});  // cmp byte [r12 + bailed], 0
+                asm_.Imm32(BAILED_OFFSET);
+                asm_.Bytes({0x00});
+                asm_.JumpIfNotEqual(epilogue_);
+            }
+
+            const runtime::Class& cls_;
+            const runtime::Method& method_;
+            Resolver                                   resolve_;
+            Assembler                                  asm_;
+            Assembler::Label                           bail_;
+            Assembler::Label                           epilogue_;
+            size_t                                     depth_ = 0;
+        };
+    }  // namespace
+
+    // ----------------------CompiledMethod-----------------------
+
+    struct Jit::CompiledMethod {
+        void* entry = nullptr;
+        Key                                            key;
+        vector<uint8_t>                                code;
+    };
+
+    // ----------------------Scope-----------------------
+
+    Jit::Scope::Scope(Jit& jit)
+        : previous_(current_) {
+        current_ = &jit;
+    }
+
+    Jit::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    // ----------------------Jit-----------------------
+
+    size_t Jit::KeyHash::operator()(const Key& key) const {
+        return hash<const void*>()(key.first) * 31 + hash<const void*>()(key.second);
+    }
+
+    Jit::Jit(Options options)
+        : options_(options) {}
+
+    Jit::~Jit() {
+#ifdef MYTHON_JIT_SUPPORTED
+        for (const auto& [address, size] : mappings_) {
+            munmap(address, size);
+        }
+#endif
+    }
+
+    bool Jit::IsSupported() {
+#ifdef MYTHON_JIT_SUPPORTED
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    optional<runtime::ObjectHolder> Jit::TryCall(runtime::ClassInstance& self, const runtime::Method& method,
+        const vector<runtime::ObjectHolder>& args, runtime::Context& context) {
+        if (!options_.enabled || !IsSupported() || context.GetBudget()) {
+            return nullopt;
+        }
+        const runtime::Class& cls = self.GetClass();
+        Entry& entry = entries_[{&cls, &method}];
+        if (!entry.code) {
+            if (entry.rejected || ++entry.calls < options_.threshold) {
+                return nullopt;
+            }
+            if (!Compile(cls, method)) {
+                return nullopt;
+            }
+        }
+
+        vector<int64_t> native_args(args.size());
+        for (size_t i = 0; i < args.size(); ++i) {
+            auto number = args[i].TryAs<runtime::Number>();
+            if (!number) {
+                return nullopt;
+            }
+            native_args[i] = number->GetValue();
+        }
+        NativeFrame frame{&self, false};
+        const int32_t result = reinterpret_cast<NativeFunction>(entry.code->entry)(native_args.data(), &frame);
+        if (frame.bailed) {
+            ++stats_.bailouts;
+            return nullopt;
+        }
+        ++stats_.native_calls;
+        return runtime::ObjectHolder::Own(runtime::Number(result));
+    }
+
+    void Jit::Prime(const runtime::Class& cls, const runtime::Method& method, size_t profiled_calls) {
+        if (profiled_calls < options_.threshold) {
+            return;
+        }
+        Entry& entry = entries_[{&cls, &method}];
+        if (!entry.code && !entry.rejected) {
+            entry.calls = max(entry.calls, options_.threshold ? options_.threshold - 1 : 0);
+        }
+    }
+
+    bool Jit::IsCompiled(const runtime::Class& cls, const runtime::Method& method) const {
+        auto it = entries_.find({&cls, &method});
+        return it != entries_.end() && it->second.code;
+    }
+
+    const JitStats& Jit::GetStats() const {
+        return stats_;
+    }
+
+    Jit::CompiledMethod* Jit::Compile(const runtime::Class& cls, const runtime::Method& method) {
+#ifdef MYTHON_JIT_SUPPORTED
+        // Methods called from the root are compiled with it; they are linked through their entry
+        // slots, which stay in place, so mutual recursion needs no patching.
+        vector<unique_ptr<CompiledMethod>> batch;
+        unordered_map<Key, CompiledMethod*, KeyHash> in_batch;
+        auto request = [&](const runtime::Method& target) -> CompiledMethod* {
+            const Key key{&cls, &target};
+            if (auto it = entries_.find(key); it != entries_.end()) {
+                if (it->second.code || it->second.rejected) {
+                    return it->second.code;
+                }
+            }
+            if (auto it = in_batch.find(key); it != in_batch.end()) {
+                return it->second;
+            }
+            batch.push_back(make_unique<CompiledMethod>());
+            batch.back()->key = key;
+            return in_batch[key] = batch.back().get();
+        };
+
+        request(method);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            CompiledMethod& compiled = *batch[i];
+            CodeGen generator(cls, *compiled.key.second, [&request](const runtime::Method& target) -> void* const* {
+                CompiledMethod* callee = request(target);
+                return callee ? &callee->entry : nullptr;
+            });
+            if (!generator.Generate(compiled.code)) {
+                entries_[compiled.key].rejected = true;
+                entries_[{&cls, &method}].rejected = true;
+                ++stats_.rejected;
+                return nullptr;
+            }
+        }
+
+        size_t size = 0;
+        for (const auto& compiled : batch) {
+            size += compiled->code.size();
+        }
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            entries_[{&cls, &method}].rejected = true;
+            ++stats_.rejected;
+            return nullptr;
+        }
+        auto* cursor = static_cast<uint8_t*>(memory);
+        for (const auto& compiled : batch) {
+            memcpy(cursor, compiled->code.data(), compiled->code.size());
+            compiled->entry = cursor;
+            cursor += compiled->code.size();
+            compiled->code.clear();
+        }
+        mprotect(memory, size, PROT_READ | PROT_EXEC);
+        mappings_.emplace_back(memory, size);
+
+        for (auto& compiled : batch) {
+            entries_[compiled->key].code = compiled.get();
+            methods_.push_back(move(compiled));
+        }
+        stats_.compiled += batch.size();
+        return entries_[{&cls, &method}].code;
+#else
+        entries_[{&cls, &method}].rejected = true;
+        return nullptr;
+#endif
+    }
+
+}  // namespace jit
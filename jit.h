@@ -0,0 +1,118 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jit {
+
+    // ----------------------Options-----------------------
+
+    struct Options {
+        static constexpr size_t                        DEFAULT_THRESHOLD = 100;
+
+        bool                                           enabled = true;
+        size_t                                         threshold = DEFAULT_THRESHOLD;
+    };
+
+    // ----------------------JitStats-----------------------
+
+    struct JitStats {
+        size_t                                         compiled = 0;
+        size_t                                         rejected = 0;
+        size_t                                         native_calls = 0;
+        size_t                                         bailouts = 0;
+    };
+
+    // ----------------------Jit-----------------------
+
+    // A baseline compiler from method bodies to x86-64 machine code, built from fixed instruction
+    // templates. Once a method has been called threshold times on instances of one class, it is
+    // compiled if it is pure integer code: it may read its parameters and the fields of self,
+    // compute with int arithmetic and comparisons, branch with if/else, return, and call other
+    // such methods of self. Anything else leaves the method to the interpreter.
+    //
+    // Compiled code bails out when a field is missing or is not a number, on division by zero, and
+    // when the end of the body is reached without a return. Since compiled methods have no side
+    // effects, the call is then simply executed again by the interpreter, which produces the same
+    // result or error it always would. Executions with an ExecutionBudget are never run natively,
+    // and neither are calls made by the stackless interpreter, whose frames stay off the native stack.
+    // Code is cached by class and method address, so a Jit must not outlive the programs it ran.
+    class Jit {
+    public:
+        class Scope {
+        public:
+            explicit                                   Scope(Jit& jit);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            Jit* previous_;
+        };
+
+        explicit                                       Jit(Options options = {});
+
+        Jit(const Jit&) = delete;
+        Jit& operator=(const Jit&) = delete;
+
+        ~Jit();
+
+        [[nodiscard]] static Jit* Current();
+
+        // False on targets other than x86-64, where every call is left to the interpreter.
+        [[nodiscard]] static bool                      IsSupported();
+
+        // Runs the method natively when it is compiled (compiling it once it gets hot) and returns
+        // its result; returns nothing when the interpreter has to run it.
+        std::optional<runtime::ObjectHolder>           TryCall(runtime::ClassInstance& self, const runtime::Method& method,
+                                                               const std::vector<runtime::ObjectHolder>& args,
+                                                               runtime::Context& context);
+
+        // Counts the calls a profile saw towards the threshold, so that a method the profile found
+        // hot is compiled on its first call.
+        void                                           Prime(const runtime::Class& cls, const runtime::Method& method,
+                                                             size_t profiled_calls);
+
+        [[nodiscard]] bool                             IsCompiled(const runtime::Class& cls, const runtime::Method& method) const;
+
+        [[nodiscard]] const JitStats& GetStats() const;
+
+    private:
+        struct CompiledMethod;
+
+        using Key = std::pair<const runtime::Class*, const runtime::Method*>;
+
+        struct KeyHash {
+            size_t                                     operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            size_t                                     calls = 0;
+            bool                                       rejected = false;
+            CompiledMethod* code = nullptr;
+        };
+
+        CompiledMethod* Compile(const runtime::Class& cls, const runtime::Method& method);
+
+        Options                                        options_;
+        std::unordered_map<Key, Entry, KeyHash>        entries_;
+        std::vector<std::unique_ptr<CompiledMethod>>   methods_;
+        std::vector<std::pair<void*, size_t>>          mappings_;
+        JitStats                                       stats_;
+
+        static inline thread_local Jit* current_ = nullptr;
+    };
+
+    inline Jit* Jit::Current() {
+        return current_;
+    }
+
+}  // namespace jit
@@ -0,0 +1,162 @@
+#include "jit.h"
+#include "program.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace jit {
+
+namespace {
+
+const string MATH_PROGRAM = R"(
+class Math:
+  def __init__():
+    self.base = 7
+
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+  def classify(x, y):
+    if x == y or not (x != y):
+      return 0
+    if x > 100 and y <= 0 - 3:
+      return 1
+    if x >= y:
+      return self.base * 2 - x / 3
+    return self.base + y * 2
+
+  def ratio(x, y):
+    return x / y + self.base
+
+  def shout(x):
+    print 'called', x
+    return x
+
+m = Math()
+)"s;
+
+string Call(runtime::Closure& closure, runtime::Context& context, const string& method, vector<int> args) {
+    vector<runtime::ObjectHolder> actual_args;
+    for (int arg : args) {
+        actual_args.push_back(runtime::ObjectHolder::Own(runtime::Number(arg)));
+    }
+    try {
+        auto instance = closure.at("m"s).TryAs<runtime::ClassInstance>();
+        runtime::ObjectHolder result = instance->Call(method, actual_args, context);
+        string buffer;
+        result->FormatTo(buffer, context);
+        return buffer;
+    }
+    catch (const runtime_error& error) {
+        return "error: "s + error.what();
+    }
+}
+
+void TestCompiledMatchesInterpreter() {
+    if (!Jit::IsSupported()) {
+        return;
+    }
+    auto program = CompileFromString(MATH_PROGRAM);
+    const vector<vector<int>> inputs = {{1, 1}, {200, -5}, {200, 5}, {9, 4}, {-9, 4}, {3, 30}, {-7, -1}, {5, 0}};
+
+    runtime::DummyContext plain_context;
+    runtime::Closure plain;
+    program->Execute(plain, plain_context);
+
+    Jit jit(Options{true, 0});
+    Jit::Scope scope(jit);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    program->Execute(closure, context);
+    for (int round = 0; round < 3; ++round) {
+        for (const auto& input : inputs) {
+            ASSERT_EQUAL(Call(closure, context, "classify"s, input), Call(plain, plain_context, "classify"s, input));
+            ASSERT_EQUAL(Call(closure, context, "ratio"s, input), Call(plain, plain_context, "ratio"s, input));
+        }
+    }
+    const auto& cls = closure.at("m"s).TryAs<runtime::ClassInstance>()->GetClass();
+    ASSERT(jit.IsCompiled(cls, *cls.GetMethod("classify"s)));
+    ASSERT(jit.IsCompiled(cls, *cls.GetMethod("ratio"s)));
+    ASSERT(jit.GetStats().native_calls > 0);
+    ASSERT(jit.GetStats().bailouts > 0);
+}
+
+void TestHotRecursiveMethod() {
+    if (!Jit::IsSupported()) {
+        return;
+    }
+    auto program = CompileFromString(MATH_PROGRAM + "print m.fib(5), m.fib(20)\n"s);
+    for (auto mode : {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS, ExecutionMode::CLOSURE_COMPILED,
+                      ExecutionMode::SEALED_TREE}) {
+        Jit jit(Options{true, 3});
+        Jit::Scope scope(jit);
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        program->Execute(closure, context, mode);
+        ASSERT_EQUAL(context.output.str(), "5 6765\n"s);
+        // The stackless interpreter keeps its calls off the native stack, so it never enters compiled code.
+        const bool jitted = mode != ExecutionMode::STACKLESS;
+        ASSERT_EQUAL(jit.GetStats().compiled, jitted ? 1U : 0U);
+        ASSERT_EQUAL(jit.GetStats().native_calls > 0, jitted);
+    }
+}
+
+void TestFieldGuards() {
+    if (!Jit::IsSupported()) {
+        return;
+    }
+    auto program = CompileFromString(MATH_PROGRAM);
+    Jit jit(Options{true, 0});
+    Jit::Scope scope(jit);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    program->Execute(closure, context);
+    ASSERT_EQUAL(Call(closure, context, "ratio"s, {9, 3}), "10"s);
+
+    auto& fields = closure.at("m"s).TryAs<runtime::ClassInstance>()->Fields();
+    fields["base"s] = runtime::ObjectHolder::Own(runtime::String("x"s));
+    ASSERT_EQUAL(Call(closure, context, "ratio"s, {9, 3}), "error: The operator is not overloaded +"s);
+    fields.erase("base"s);
+    ASSERT_EQUAL(Call(closure, context, "ratio"s, {9, 3}), "error: Not fieldbase"s);
+    fields["base"s] = runtime::ObjectHolder::Own(runtime::Number(1));
+    ASSERT_EQUAL(Call(closure, context, "ratio"s, {9, 3}), "4"s);
+}
+
+void TestImpureAndDisabled() {
+    auto program = CompileFromString(MATH_PROGRAM);
+    {
+        Jit jit(Options{true, 0});
+        Jit::Scope scope(jit);
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        program->Execute(closure, context);
+        ASSERT_EQUAL(Call(closure, context, "shout"s, {4}), "4"s);
+        ASSERT_EQUAL(Call(closure, context, "shout"s, {5}), "5"s);
+        ASSERT_EQUAL(context.output.str(), "called 4\ncalled 5\n"s);
+        ASSERT_EQUAL(jit.GetStats().compiled, 0U);
+    }
+    {
+        Jit jit(Options{false, 0});
+        Jit::Scope scope(jit);
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        program->Execute(closure, context);
+        ASSERT_EQUAL(Call(closure, context, "fib"s, {10}), "55"s);
+        ASSERT_EQUAL(jit.GetStats().compiled, 0U);
+        ASSERT_EQUAL(jit.GetStats().native_calls, 0U);
+    }
+}
+
+}  // namespace
+
+void RunJitTests(TestRunner& tr) {
+    RUN_TEST(tr, TestCompiledMatchesInterpreter);
+    RUN_TEST(tr, TestHotRecursiveMethod);
+    RUN_TEST(tr, TestFieldGuards);
+    RUN_TEST(tr, TestImpureAndDisabled);
+}
+
+}  // namespace jit
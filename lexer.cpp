@@ -71,6 +71,13 @@ namespace parse {
         return os << "Unknown token :("sv;
     }
 
+    uint64_t HashSource(string_view text, uint64_t hash) {
+        for (const char c : text) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
     Lexer::Lexer(istream& input) {
         ParseTextOnTokens(input);
     }
@@ -79,6 +86,14 @@ namespace parse {
         return current_token_;
     }
 
+    Position Lexer::CurrentPosition() const {
+        return positions_.at(current_index_ - 1);
+    }
+
+    uint64_t Lexer::GetSourceHash() const {
+        return source_hash_;
+    }
+
     Token Lexer::NextToken() {
         if (current_index_ < tokens_.size()) {
             current_token_ = tokens_.at(current_index_++);
@@ -89,19 +104,25 @@ namespace parse {
     void Lexer::ParseTextOnTokens(istream& input) {
         string line;
         while (getline(input, line)) {
+            ++line_;
+            source_hash_ = HashSource("\n"sv, HashSource(line, source_hash_));
             if (!StringIsEmpty(line)) {
                 stringstream stream(line);
                 ParseString(stream);
                 LoadEndl();
+                MarkPositions(line.size() + 1);
             }
         }
+        ++line_;
         LoadDedent();
         LoadEof();
+        MarkPositions(1);
         NextToken();
     }
     
     void Lexer::ParseString(istream& input) {
         LoadTab(input);
+        MarkPositions(1);
         LoadTokens(input);
     }
     
@@ -131,20 +152,28 @@ namespace parse {
                 break;
             }
             if (isdigit(input.peek())) {
+                const size_t column = ColumnOf(input);
                 LoadNumber(input);
+                MarkPositions(column);
             }
             if (input.peek() == '\"' || input.peek() == '\'') {
+                const size_t column = ColumnOf(input);
                 LoadString(input);
+                MarkPositions(column);
             }
             if (input.peek() == '_' || isalpha(input.peek())) {
+                const size_t column = ColumnOf(input);
                 LoadWord(input);
+                MarkPositions(column);
             }
             if (IsChar(input.peek())) {
+                const size_t column = ColumnOf(input);
                 if (special_operators_.count(input.peek()) != 0) {
                     LoadSign(input);
                 } else {
                     LoadChar(input.get());
                 }
+                MarkPositions(column);
             }
         }
      }
@@ -214,6 +243,14 @@ namespace parse {
         tokens_.push_back(Token(token_type::Eof{}));
     }
     
+    void Lexer::MarkPositions(size_t column) {
+        positions_.resize(tokens_.size(), Position{line_, column});
+    }
+
+    size_t Lexer::ColumnOf(istream& input) {
+        return static_cast<size_t>(input.tellg()) + 1;
+    }
+
     bool Lexer::IsChar(char c) {
         return c == '.' || c == ',' || c == '(' || c == '+' || c == ')' || c == '-' || c == '*' || c == '/' || c == ':'
             || c == '@' || c == '%' || c == '$' || c == '^' || c == '&' || c == ';' || c == '?' || c == '=' || c == '<'
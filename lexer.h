@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
 #include <sstream>
 #include <stdexcept>
@@ -109,6 +110,22 @@ namespace parse {
 
     std::ostream& operator<<(std::ostream& os, const Token& rhs);
 
+    // ------------------------HashSource-----------------------
+
+    inline constexpr uint64_t                          SOURCE_HASH_SEED = 14695981039346656037ull;
+
+    // FNV-1a of text, continuing from hash; the hash of a whole source is taken from the seed.
+    [[nodiscard]] uint64_t HashSource(std::string_view text, uint64_t hash = SOURCE_HASH_SEED);
+
+    // ------------------------Position-----------------------
+
+    // Where a token starts in the source: both counted from 1. Indents, dedents and newlines are
+    // placed at the line they close or open.
+    struct Position {
+        size_t                                         line = 0;
+        size_t                                         column = 0;
+    };
+
     // ------------------------LexerError-----------------------
 
     class LexerError : public std::runtime_error {
@@ -124,6 +141,11 @@ namespace parse {
 
         [[nodiscard]] const Token&                        CurrentToken() const;
 
+        [[nodiscard]] Position                            CurrentPosition() const;
+
+        // FNV-1a of the source text, which identifies it for profiles recorded from it.
+        [[nodiscard]] uint64_t                            GetSourceHash() const;
+
         Token                                             NextToken();
 
         template <typename T>
@@ -141,6 +163,9 @@ namespace parse {
     private:
         Token                                             current_token_;
         std::vector<Token>                                tokens_;
+        std::vector<Position>                             positions_;
+        size_t                                            line_ = 0;
+        uint64_t                                          source_hash_ = SOURCE_HASH_SEED;
         size_t                                            current_index_ = 0;
         const std::unordered_map<std::string, Token>      key_words_token_ = {
             {"class"s, token_type::Class{}}, {"return"s, token_type::Return{}}, {"if"s, token_type::If{}},
@@ -183,6 +208,10 @@ namespace parse {
         void                                              LoadChar(char c);
     
         void                                              LoadEof();
+
+        void                                              MarkPositions(size_t column);
+
+        size_t                                            ColumnOf(std::istream& input);
     
         bool                                              IsChar(char c);
     
@@ -351,22 +351,51 @@ abc#
         ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
     }
 }
+
+void TestPositions() {
+    istringstream input("x = 'a b'\n\n# note\nif x >= 42:\n  print x\n"s);
+    Lexer lexer(input);
+
+    const auto expect_at = [&lexer](size_t line, size_t column) {
+        ASSERT_EQUAL(lexer.CurrentPosition().line, line);
+        ASSERT_EQUAL(lexer.CurrentPosition().column, column);
+        lexer.NextToken();
+    };
+    expect_at(1, 1);   // x
+    expect_at(1, 3);   // =
+    expect_at(1, 5);   // 'a b'
+    expect_at(1, 10);  // Newline
+    expect_at(4, 1);   // if
+    expect_at(4, 4);   // x
+    expect_at(4, 6);   // >=
+    expect_at(4, 9);   // 42
+    expect_at(4, 11);  // :
+    expect_at(4, 12);  // Newline
+    expect_at(5, 1);   // Indent
+    expect_at(5, 3);   // print
+    expect_at(5, 9);   // x
+    expect_at(5, 10);  // Newline
+    expect_at(6, 1);   // Dedent
+    ASSERT(lexer.CurrentToken().Is<token_type::Eof>());
+    ASSERT_EQUAL(lexer.CurrentPosition().line, 6u);
+}
 }  // namespace
 
 void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestSimpleAssignment);
     RUN_TEST(tr, parse::TestKeywords);
-    RUN_TEST(tr, parse::TestNumbers);
-    RUN_TEST(tr, parse::TestIds);
-    RUN_TEST(tr, parse::TestStrings);
-    RUN_TEST(tr, parse::TestOperations);
+    RUN_BENCH(tr, parse::TestNumbers);
+    RUN_BENCH(tr, parse::TestIds);
+    RUN_BENCH(tr, parse::TestStrings);
+    RUN_BENCH(tr, parse::TestOperations);
     RUN_TEST(tr, parse::TestIndentsAndNewlines);
     RUN_TEST(tr, parse::TestEmptyLinesAreIgnored);
     RUN_TEST(tr, parse::TestExpect);
     RUN_TEST(tr, parse::TestExpectNext);
-    RUN_TEST(tr, parse::TestMythonProgram);
+    RUN_BENCH(tr, parse::TestMythonProgram);
     RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
     RUN_TEST(tr, parse::TestCommentsAreIgnored);
+    RUN_TEST(tr, parse::TestPositions);
 }
 
 }  // namespace parse
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "lexer.h"
 #include "parse.h"
 #include "runtime.h"
+#include "server.h"
 #include "statement.h"
 #include "test_runner_p.h"
 
 #include <iostream>
+#include <string_view>
 
 using namespace std;
 
@@ -18,9 +20,58 @@ void RunUnitTests(TestRunner& tr);
 namespace runtime {
 void RunObjectHolderTests(TestRunner& tr);
 void RunObjectsTests(TestRunner& tr);
+void RunBufferedContextTests(TestRunner& tr);
+void RunArenaTests(TestRunner& tr);
+void RunSlabTests(TestRunner& tr);
+void RunCycleCollectorTests(TestRunner& tr);
+void RunExecutorTests(TestRunner& tr);
+void RunSchedulerTests(TestRunner& tr);
+void RunBudgetTests(TestRunner& tr);
+void RunQuotaTests(TestRunner& tr);
+void RunStatsTests(TestRunner& tr);
+void RunHeapTests(TestRunner& tr);
 }  // namespace runtime
 
 void TestParseProgram(TestRunner& tr);
+void RunBenchTests(TestRunner& tr);
+void RunProgramTests(TestRunner& tr);
+
+namespace vm {
+void RunVmTests(TestRunner& tr);
+}  // namespace vm
+
+namespace jit {
+void RunJitTests(TestRunner& tr);
+}  // namespace jit
+
+namespace aot {
+void RunTranspileTests(TestRunner& tr);
+}  // namespace aot
+
+namespace compiled {
+void RunCompiledTests(TestRunner& tr);
+}  // namespace compiled
+
+namespace sealed {
+void RunSealedAstTests(TestRunner& tr);
+}  // namespace sealed
+
+namespace profile {
+void RunProfilerTests(TestRunner& tr);
+void RunCounterTests(TestRunner& tr);
+}  // namespace profile
+
+namespace trace {
+void RunTraceTests(TestRunner& tr);
+}  // namespace trace
+
+namespace pgo {
+void RunPgoTests(TestRunner& tr);
+}  // namespace pgo
+
+namespace server {
+void RunServerTests(TestRunner& tr);
+}  // namespace server
 
 namespace {
 
@@ -113,11 +164,34 @@ print y.value
 
 void TestAll() {
     TestRunner tr;
+    tr.SetBenchOptions(BenchOptions::FromEnvironment());
+    RunBenchTests(tr);
     parse::RunOpenLexerTests(tr);
     runtime::RunObjectHolderTests(tr);
     runtime::RunObjectsTests(tr);
+    runtime::RunBufferedContextTests(tr);
+    runtime::RunArenaTests(tr);
+    runtime::RunSlabTests(tr);
+    runtime::RunCycleCollectorTests(tr);
     ast::RunUnitTests(tr);
     TestParseProgram(tr);
+    RunProgramTests(tr);
+    runtime::RunExecutorTests(tr);
+    vm::RunVmTests(tr);
+    runtime::RunSchedulerTests(tr);
+    runtime::RunBudgetTests(tr);
+    runtime::RunQuotaTests(tr);
+    jit::RunJitTests(tr);
+    aot::RunTranspileTests(tr);
+    compiled::RunCompiledTests(tr);
+    sealed::RunSealedAstTests(tr);
+    profile::RunProfilerTests(tr);
+    profile::RunCounterTests(tr);
+    trace::RunTraceTests(tr);
+    runtime::RunStatsTests(tr);
+    runtime::RunHeapTests(tr);
+    pgo::RunPgoTests(tr);
+    server::RunServerTests(tr);
 
     RUN_TEST(tr, TestSimplePrints);
     RUN_TEST(tr, TestAssignments);
@@ -127,8 +201,14 @@ void TestAll() {
 
 }  // namespace
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        // mython --serve <socket path> runs the interpreter daemon of server.h until killed.
+        if (argc == 3 && argv[1] == "--serve"sv) {
+            server::Server interpreter({argv[2]});
+            interpreter.Run();
+            return 0;
+        }
         TestAll();
 
         //RunMythonProgram(cin, cout);
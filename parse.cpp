@@ -61,6 +61,7 @@ private:
 
         while (lexer_.CurrentToken().Is<TokenType::Def>()) {
             runtime::Method m;
+            const parse::Position position = lexer_.CurrentPosition();
 
             m.name = lexer_.ExpectNext<TokenType::Id>().value;
             lexer_.ExpectNext<TokenType::Char>('(');
@@ -76,7 +77,7 @@ private:
             lexer_.ExpectNext<TokenType::Char>(':');
             lexer_.NextToken();
 
-            m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            m.body = Positioned(std::make_unique<ast::MethodBody>(ParseSuite()), position);  // NOLINT
 
             result.push_back(std::move(m));
         }
@@ -176,12 +177,13 @@ private:
         unique_ptr<ast::Statement> result = ParseAdder();
         while (lexer_.CurrentToken() == '+' || lexer_.CurrentToken() == '-') {
             char op = lexer_.CurrentToken().As<TokenType::Char>().value;
+            const parse::Position position = lexer_.CurrentPosition();
             lexer_.NextToken();
 
             if (op == '+') {
-                result = make_unique<ast::Add>(std::move(result), ParseAdder());
+                result = Positioned(make_unique<ast::Add>(std::move(result), ParseAdder()), position);
             } else {
-                result = make_unique<ast::Sub>(std::move(result), ParseAdder());
+                result = Positioned(make_unique<ast::Sub>(std::move(result), ParseAdder()), position);
             }
         }
         return result;
@@ -193,12 +195,13 @@ private:
         unique_ptr<ast::Statement> result = ParseMult();
         while (lexer_.CurrentToken() == '*' || lexer_.CurrentToken() == '/') {
             char op = lexer_.CurrentToken().As<TokenType::Char>().value;
+            const parse::Position position = lexer_.CurrentPosition();
             lexer_.NextToken();
 
             if (op == '*') {
-                result = make_unique<ast::Mult>(std::move(result), ParseMult());
+                result = Positioned(make_unique<ast::Mult>(std::move(result), ParseMult()), position);
             } else {
-                result = make_unique<ast::Div>(std::move(result), ParseMult());
+                result = Positioned(make_unique<ast::Div>(std::move(result), ParseMult()), position);
             }
         }
         return result;
@@ -223,8 +226,9 @@ private:
             return result;
         }
         if (lexer_.CurrentToken() == '-') {
+            const parse::Position position = lexer_.CurrentPosition();
             lexer_.NextToken();
-            return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
+            return Positioned(make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1)), position);
         }
         if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
             int result = num->value;
@@ -253,6 +257,7 @@ private:
     }
 
     std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
+        const parse::Position position = lexer_.CurrentPosition();
         vector<string> names = ParseDottedIds();
 
         if (lexer_.CurrentToken() == '(') {
@@ -268,9 +273,9 @@ private:
             names.pop_back();
 
             if (!names.empty()) {
-                return make_unique<ast::MethodCall>(
+                return Positioned(make_unique<ast::MethodCall>(
                     make_unique<ast::VariableValue>(std::move(names)), std::move(method_name),
-                    std::move(args));
+                    std::move(args)), position);
             }
             if (auto it = declared_classes_.find(method_name); it != declared_classes_.end()) {
                 return make_unique<ast::NewInstance>(
@@ -362,36 +367,37 @@ private:
         auto result = ParseExpression();
 
         const auto tok = lexer_.CurrentToken();
+        const parse::Position position = lexer_.CurrentPosition();
 
         if (tok == '<') {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Less, std::move(result),
-                                                ParseExpression());
+            return Positioned(make_unique<ast::Comparison>(runtime::Less, std::move(result),
+                                                           ParseExpression()), position);
         }
         if (tok == '>') {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Greater, std::move(result),
-                                                ParseExpression());
+            return Positioned(make_unique<ast::Comparison>(runtime::Greater, std::move(result),
+                                                           ParseExpression()), position);
         }
         if (tok.Is<TokenType::Eq>()) {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Equal, std::move(result),
-                                                ParseExpression());
+            return Positioned(make_unique<ast::Comparison>(runtime::Equal, std::move(result),
+                                                           ParseExpression()), position);
         }
         if (tok.Is<TokenType::NotEq>()) {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
-                                                ParseExpression());
+            return Positioned(make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
+                                                           ParseExpression()), position);
         }
         if (tok.Is<TokenType::LessOrEq>()) {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
-                                                ParseExpression());
+            return Positioned(make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
+                                                           ParseExpression()), position);
         }
         if (tok.Is<TokenType::GreaterOrEq>()) {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
-                                                ParseExpression());
+            return Positioned(make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
+                                                           ParseExpression()), position);
         }
         return result;
     }
@@ -402,18 +408,24 @@ private:
     unique_ptr<ast::Statement> ParseStatement()  // NOLINT
     {
         const auto& tok = lexer_.CurrentToken();
+        const parse::Position position = lexer_.CurrentPosition();
 
         if (tok.Is<TokenType::Class>()) {
             lexer_.NextToken();
-            return ParseClassDefinition();  // NOLINT
+            return Positioned(ParseClassDefinition(), position);  // NOLINT
         }
         if (tok.Is<TokenType::If>()) {
-            return ParseCondition();
+            return Positioned(ParseCondition(), position);
         }
         auto result = ParseSimpleStatement();
         lexer_.Expect<TokenType::Newline>();
         lexer_.NextToken();
-        return result;
+        return Positioned(std::move(result), position);
+    }
+
+    static unique_ptr<ast::Statement> Positioned(unique_ptr<ast::Statement> statement, parse::Position position) {
+        statement->SetPosition({static_cast<uint32_t>(position.line), static_cast<uint32_t>(position.column)});
+        return statement;
     }
 
     // StatementBody -> return Expression
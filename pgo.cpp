@@ -0,0 +1,309 @@
+#include "pgo.h"
+
+#include "statement.h"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace pgo {
+
+    namespace {
+
+        const string HEADER = "mython-profile"s;
+        constexpr int VERSION = 1;
+
+        runtime::ObjectKind ParseKind(const string& name) {
+            for (size_t i = 0; i < runtime::OBJECT_KIND_COUNT; ++i) {
+                const auto kind = static_cast<runtime::ObjectKind>(i);
+                if (runtime::GetObjectKindName(kind) == name) {
+                    return kind;
+                }
+            }
+            throw runtime_error("Unknown object kind in profile: "s + name);
+        }
+
+        // ----------------------Walker-----------------------
+
+        // Visits every node of a tree and of the methods of the classes it defines.
+        class Walker {
+        public:
+            explicit Walker(const function<void(runtime::Executable&)>& visit)
+                : visit_(visit) {}
+
+            void Walk(runtime::Executable& node) {
+                visit_(node);
+                if (auto statement = dynamic_cast<ast::Assignment*>(&node); statement) {
+                    Walk(*statement->GetValue());
+                } else if (auto statement = dynamic_cast<ast::FieldAssignment*>(&node); statement) {
+                    Walk(*statement->GetValue());
+                } else if (auto statement = dynamic_cast<ast::Print*>(&node); statement) {
+                    WalkAll(statement->GetArgs());
+                } else if (auto statement = dynamic_cast<ast::MethodCall*>(&node); statement) {
+                    Walk(*statement->GetObject());
+                    WalkAll(statement->GetArgs());
+                } else if (auto statement = dynamic_cast<ast::NewInstance*>(&node); statement) {
+                    WalkAll(statement->GetArgs());
+                } else if (auto statement = dynamic_cast<ast::UnaryOperation*>(&node); statement) {
+                    Walk(*statement->GetArgument());
+                } else if (auto statement = dynamic_cast<ast::BinaryOperation*>(&node); statement) {
+                    Walk(*statement->GetLhs());
+                    Walk(*statement->GetRhs());
+                } else if (auto statement = dynamic_cast<ast::Compound*>(&node); statement) {
+                    WalkAll(statement->GetStatements());
+                } else if (auto statement = dynamic_cast<ast::MethodBody*>(&node); statement) {
+                    Walk(*statement->GetBody());
+                } else if (auto statement = dynamic_cast<ast::Return*>(&node); statement) {
+                    Walk(*statement->GetStatement());
+                } else if (auto statement = dynamic_cast<ast::IfElse*>(&node); statement) {
+                    Walk(*statement->GetCondition());
+                    Walk(*statement->GetIfBody());
+                    if (statement->GetElseBody()) {
+                        Walk(*statement->GetElseBody());
+                    }
+                } else if (auto statement = dynamic_cast<ast::ClassDefinition*>(&node); statement) {
+                    if (auto cls = statement->GetClass().TryAs<runtime::Class>(); cls && classes_.insert(cls).second) {
+                        for (const runtime::Method& method : cls->GetMethods()) {
+                            Walk(*method.body);
+                        }
+                    }
+                }
+            }
+
+        private:
+            void WalkAll(const vector<unique_ptr<ast::Statement>>& statements) {
+                for (const auto& statement : statements) {
+                    Walk(*statement);
+                }
+            }
+
+            const function<void(runtime::Executable&)>& visit_;
+            unordered_set<const runtime::Class*> classes_;
+        };
+
+    }  // namespace
+
+    // ----------------------Site-----------------------
+
+    bool Site::operator<(const Site& other) const {
+        return tie(line, column) < tie(other.line, other.column);
+    }
+
+    runtime::ObjectKind KindOf(const runtime::ObjectHolder& object) {
+        if (object.TryAs<runtime::Number>()) {
+            return runtime::ObjectKind::NUMBER;
+        }
+        if (object.TryAs<runtime::String>()) {
+            return runtime::ObjectKind::STRING;
+        }
+        if (object.TryAs<runtime::Bool>()) {
+            return runtime::ObjectKind::BOOL;
+        }
+        if (object.TryAs<runtime::ClassInstance>()) {
+            return runtime::ObjectKind::INSTANCE;
+        }
+        if (object.TryAs<runtime::Class>()) {
+            return runtime::ObjectKind::CLASS;
+        }
+        return runtime::ObjectKind::OTHER;
+    }
+
+    // ----------------------Profile-----------------------
+
+    void Profile::Merge(const Profile& other) {
+        for (const auto& [site, counts] : other.branches) {
+            branches[site].taken += counts.taken;
+            branches[site].not_taken += counts.not_taken;
+        }
+        for (const auto& [site, kinds] : other.operands) {
+            for (const auto& [pair, count] : kinds) {
+                operands[site][pair] += count;
+            }
+        }
+        for (const auto& [site, classes] : other.receivers) {
+            for (const auto& [name, count] : classes) {
+                receivers[site][name] += count;
+            }
+        }
+        for (const auto& [key, count] : other.calls) {
+            calls[key] += count;
+        }
+    }
+
+    void Profile::Write(ostream& out) const {
+        out << HEADER << ' ' << VERSION << ' ' << source_hash << '\n';
+        for (const auto& [site, counts] : branches) {
+            out << "branch " << site.line << ' ' << site.column << ' ' << counts.taken << ' ' << counts.not_taken << '\n';
+        }
+        for (const auto& [site, kinds] : operands) {
+            for (const auto& [pair, count] : kinds) {
+                out << "operands " << site.line << ' ' << site.column << ' ' << runtime::GetObjectKindName(pair.first)
+                    << ' ' << runtime::GetObjectKindName(pair.second) << ' ' << count << '\n';
+            }
+        }
+        for (const auto& [site, classes] : receivers) {
+            for (const auto& [name, count] : classes) {
+                out << "receiver " << site.line << ' ' << site.column << ' ' << name << ' ' << count << '\n';
+            }
+        }
+        for (const auto& [key, count] : calls) {
+            out << "calls " << key.first << ' ' << key.second << ' ' << count << '\n';
+        }
+    }
+
+    Profile Profile::Read(istream& in) {
+        Profile profile;
+        string header;
+        int version = 0;
+        if (!(in >> header >> version >> profile.source_hash) || header != HEADER || version != VERSION) {
+            throw runtime_error("Not a Mython profile"s);
+        }
+        string line;
+        getline(in, line);
+        while (getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            istringstream record(line);
+            string type;
+            record >> type;
+            Site site;
+            bool valid = false;
+            if (type == "branch"s) {
+                BranchCounts counts;
+                valid = static_cast<bool>(record >> site.line >> site.column >> counts.taken >> counts.not_taken);
+                profile.branches[site] = counts;
+            } else if (type == "operands"s) {
+                string lhs;
+                string rhs;
+                uint64_t count = 0;
+                valid = static_cast<bool>(record >> site.line >> site.column >> lhs >> rhs >> count);
+                if (valid) {
+                    profile.operands[site][{ParseKind(lhs), ParseKind(rhs)}] = count;
+                }
+            } else if (type == "receiver"s) {
+                string name;
+                uint64_t count = 0;
+                valid = static_cast<bool>(record >> site.line >> site.column >> name >> count);
+                profile.receivers[site][name] = count;
+            } else if (type == "calls"s) {
+                string cls;
+                string method;
+                uint64_t count = 0;
+                valid = static_cast<bool>(record >> cls >> method >> count);
+                profile.calls[{cls, method}] = count;
+            }
+            if (!valid) {
+                throw runtime_error("Malformed profile record: "s + line);
+            }
+        }
+        return profile;
+    }
+
+    // ----------------------Recorder-----------------------
+
+    Recorder::Scope::Scope(Recorder& recorder)
+        : previous_(current_) {
+        current_ = &recorder;
+    }
+
+    Recorder::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    Recorder::Recorder(uint64_t source_hash) {
+        profile_.source_hash = source_hash;
+    }
+
+    const Profile& Recorder::GetProfile() const {
+        return profile_;
+    }
+
+    // ----------------------Apply-----------------------
+
+    Feedback Apply(const Profile& profile, uint64_t source_hash, runtime::Executable& tree) {
+        Feedback feedback;
+        if (profile.source_hash != source_hash) {
+            return feedback;
+        }
+        feedback.applied = true;
+
+        unordered_map<string, runtime::Class*> classes;
+        const function<void(runtime::Executable&)> collect = [&](runtime::Executable& node) {
+            if (auto definition = dynamic_cast<ast::ClassDefinition*>(&node); definition) {
+                if (auto cls = definition->GetClass().TryAs<runtime::Class>(); cls) {
+                    classes.emplace(cls->GetName(), cls);
+                }
+            }
+        };
+        Walker(collect).Walk(tree);
+
+        // Calls are counted by receiver class; the weight of a method is that of every class
+        // that inherits it. Method pointers change here, so nothing may resolve them before.
+        unordered_map<runtime::Class*, unordered_map<string, uint64_t>> weights;
+        for (const auto& [key, count] : profile.calls) {
+            if (auto it = classes.find(key.first); it != classes.end()) {
+                if (const runtime::Method* method = it->second->GetMethod(key.second); method) {
+                    const string& owner = it->second->GetDeclaringClass(*method).GetName();
+                    if (classes.count(owner)) {
+                        weights[classes.at(owner)][key.second] += count;
+                    }
+                }
+            }
+        }
+        for (auto& [cls, by_name] : weights) {
+            cls->OrderMethods([&by_name = by_name](const runtime::Method& method) {
+                auto it = by_name.find(method.name);
+                return it != by_name.end() ? it->second : uint64_t{0};
+            });
+            ++feedback.ordered_classes;
+        }
+
+        const function<void(runtime::Executable&)> specialize = [&](runtime::Executable& node) {
+            const Site site = SiteOf(node);
+            if (auto call = dynamic_cast<ast::MethodCall*>(&node); call) {
+                auto it = profile.receivers.find(site);
+                if (it == profile.receivers.end() || it->second.empty()) {
+                    return;
+                }
+                const auto hottest = max_element(it->second.begin(), it->second.end(), [](const auto& lhs, const auto& rhs) {
+                    return lhs.second < rhs.second;
+                });
+                if (auto cls = classes.find(hottest->first); cls != classes.end()) {
+                    call->Prime(*cls->second);
+                    ++feedback.primed_call_sites;
+                }
+            } else if (auto add = dynamic_cast<ast::Add*>(&node); add) {
+                auto it = profile.operands.find(site);
+                if (it == profile.operands.end()) {
+                    return;
+                }
+                auto count = [&kinds = it->second](runtime::ObjectKind kind) {
+                    auto found = kinds.find({kind, kind});
+                    return found != kinds.end() ? found->second : uint64_t{0};
+                };
+                if (count(runtime::ObjectKind::STRING) > count(runtime::ObjectKind::NUMBER)) {
+                    add->PreferStrings();
+                    ++feedback.specialized_nodes;
+                }
+            }
+        };
+        Walker(specialize).Walk(tree);
+
+        for (const auto& [key, count] : profile.calls) {
+            if (auto it = classes.find(key.first); it != classes.end()) {
+                if (const runtime::Method* method = it->second->GetMethod(key.second); method) {
+                    feedback.jit_candidates.push_back({it->second, method, count});
+                }
+            }
+        }
+        return feedback;
+    }
+
+}  // namespace pgo
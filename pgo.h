@@ -0,0 +1,159 @@
+#pragma once
+
+#include "runtime.h"
+#include "stats.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Profile-guided compilation. A Recorder observes tree-walking executions and produces a Profile,
+// which is saved to a text file, merged over many short runs and given to CompileProgram for later
+// compiles of the same source. Nodes are identified by their source position: statements by
+// their first token, operators by the operator token and method calls in expressions by the
+// first name of the receiver.
+namespace pgo {
+
+    // ----------------------Site-----------------------
+
+    struct Site {
+        uint32_t                                       line = 0;
+        uint32_t                                       column = 0;
+
+        bool                                           operator<(const Site& other) const;
+    };
+
+    [[nodiscard]] runtime::ObjectKind KindOf(const runtime::ObjectHolder& object);
+
+    inline Site SiteOf(const runtime::Executable& node) {
+        return {node.GetPosition().line, node.GetPosition().column};
+    }
+
+    // ----------------------Profile-----------------------
+
+    struct BranchCounts {
+        uint64_t                                       taken = 0;
+        uint64_t                                       not_taken = 0;
+    };
+
+    using OperandKinds = std::pair<runtime::ObjectKind, runtime::ObjectKind>;
+
+    // The file format is one record per line, after a "mython-profile 1 <source hash>" header:
+    //     branch <line> <column> <taken> <not taken>
+    //     operands <line> <column> <lhs kind> <rhs kind> <count>
+    //     receiver <line> <column> <class> <count>
+    //     calls <class> <method> <count>
+    // where kinds are those of Stats dumps, such as "number" or "instance".
+    struct Profile {
+        uint64_t                                       source_hash = 0;
+        std::map<Site, BranchCounts>                   branches;
+        std::map<Site, std::map<OperandKinds, uint64_t>> operands;
+        std::map<Site, std::map<std::string, uint64_t>> receivers;
+        // By receiver class and method name.
+        std::map<std::pair<std::string, std::string>, uint64_t> calls;
+
+        // Adds the counts of a profile of the same source.
+        void                                           Merge(const Profile& other);
+
+        void                                           Write(std::ostream& out) const;
+
+        // Throws std::runtime_error on malformed input.
+        [[nodiscard]] static Profile                   Read(std::istream& in);
+    };
+
+    // ----------------------Recorder-----------------------
+
+    // Collects a Profile on the thread of the innermost open Scope.
+    class Recorder {
+    public:
+        class Scope {
+        public:
+            explicit                                   Scope(Recorder& recorder);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            Recorder* previous_;
+        };
+
+        // The hash of the recorded source, Lexer::GetSourceHash.
+        explicit                                       Recorder(uint64_t source_hash);
+
+        static void                                    Branch(const runtime::Executable& node, bool taken);
+
+        static void                                    Operands(const runtime::Executable& node,
+                                                                const runtime::ObjectHolder& lhs,
+                                                                const runtime::ObjectHolder& rhs);
+
+        static void                                    Receiver(const runtime::Executable& node, const runtime::Class& cls);
+
+        static void                                    Invoked(const runtime::Class& cls, const runtime::Method& method);
+
+        [[nodiscard]] const Profile&                   GetProfile() const;
+
+    private:
+        Profile                                        profile_;
+
+        static inline thread_local Recorder* current_ = nullptr;
+    };
+
+    inline void Recorder::Branch(const runtime::Executable& node, bool taken) {
+        if (current_) {
+            BranchCounts& counts = current_->profile_.branches[SiteOf(node)];
+            ++(taken ? counts.taken : counts.not_taken);
+        }
+    }
+
+    inline void Recorder::Operands(const runtime::Executable& node, const runtime::ObjectHolder& lhs,
+                                   const runtime::ObjectHolder& rhs) {
+        if (current_) {
+            ++current_->profile_.operands[SiteOf(node)][{KindOf(lhs), KindOf(rhs)}];
+        }
+    }
+
+    inline void Recorder::Receiver(const runtime::Executable& node, const runtime::Class& cls) {
+        if (current_) {
+            ++current_->profile_.receivers[SiteOf(node)][cls.GetName()];
+        }
+    }
+
+    inline void Recorder::Invoked(const runtime::Class& cls, const runtime::Method& method) {
+        if (current_) {
+            ++current_->profile_.calls[{cls.GetName(), method.name}];
+        }
+    }
+
+    // ----------------------Feedback-----------------------
+
+    // A method of a receiver class and how often the profile saw it called.
+    struct JitCandidate {
+        const runtime::Class*                          cls = nullptr;
+        const runtime::Method*                         method = nullptr;
+        uint64_t                                       calls = 0;
+    };
+
+    // What a profile changed in a tree. Program::Execute hands the JIT candidates to the Jit of
+    // the execution, which compiles those called at least its threshold times on their first call.
+    struct Feedback {
+        bool                                           applied = false;
+        size_t                                         ordered_classes = 0;
+        size_t                                         primed_call_sites = 0;
+        size_t                                         specialized_nodes = 0;
+        std::vector<JitCandidate>                      jit_candidates;
+    };
+
+    // Applies a profile to the tree parsed from source_hash, before the tree is executed or
+    // converted; a profile of another source is ignored. Orders the method tables of its classes
+    // by calls, hottest first, fills the inline caches of call sites with their most frequent
+    // receiver class, makes additions that mostly saw strings try strings first, and picks JIT
+    // candidates. Branch counts are kept in the profile for inspection: the tree has no branch
+    // layout they could change.
+    [[nodiscard]] Feedback Apply(const Profile& profile, uint64_t source_hash, runtime::Executable& tree);
+
+}  // namespace pgo
@@ -0,0 +1,195 @@
+#include "jit.h"
+#include "lexer.h"
+#include "pgo.h"
+#include "program.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace pgo {
+
+namespace {
+
+const string SHAPES_PROGRAM = R"(
+class Shape:
+  def area():
+    return 0
+
+  def describe():
+    return 'shape'
+
+class Square(Shape):
+  def __init__(side):
+    self.side = side
+
+  def area():
+    return self.side * self.side
+
+class Greeter:
+  def greet(s):
+    if s.area() > 3:
+      return 'big ' + s.describe()
+    return 'small'
+
+g = Greeter()
+a = Square(1)
+b = Square(2)
+c = Square(3)
+print g.greet(a), g.greet(b), g.greet(c)
+)"s;
+
+Profile Record(const string& source) {
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    auto program = CompileProgram(lexer);
+    Recorder recorder(lexer.GetSourceHash());
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    {
+        Recorder::Scope scope(recorder);
+        program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+    }
+    ASSERT_EQUAL(context.output.str(), "small big shape big shape\n"s);
+    return recorder.GetProfile();
+}
+
+shared_ptr<const Program> Compile(const string& source, const Profile& profile) {
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    return CompileProgram(lexer, profile);
+}
+
+void TestRecordsProfile() {
+    const Profile profile = Record(SHAPES_PROGRAM);
+    ASSERT(profile.source_hash != 0);
+
+    ASSERT_EQUAL(profile.branches.size(), 1u);
+    const BranchCounts& branch = profile.branches.at({18, 5});
+    ASSERT_EQUAL(branch.taken, 2u);
+    ASSERT_EQUAL(branch.not_taken, 1u);
+
+    const OperandKinds numbers{runtime::ObjectKind::NUMBER, runtime::ObjectKind::NUMBER};
+    const OperandKinds strings{runtime::ObjectKind::STRING, runtime::ObjectKind::STRING};
+    ASSERT_EQUAL(profile.operands.at({14, 22}).at(numbers), 3u);
+    ASSERT_EQUAL(profile.operands.at({18, 17}).at(numbers), 3u);
+    ASSERT_EQUAL(profile.operands.at({19, 21}).at(strings), 2u);
+
+    ASSERT_EQUAL(profile.receivers.at({18, 8}).at("Square"s), 3u);
+    ASSERT_EQUAL(profile.receivers.at({19, 23}).at("Square"s), 2u);
+    ASSERT_EQUAL(profile.receivers.at({26, 7}).at("Greeter"s), 1u);
+    ASSERT_EQUAL(profile.receivers.at({26, 31}).at("Greeter"s), 1u);
+
+    ASSERT_EQUAL(profile.calls.size(), 4u);
+    ASSERT_EQUAL(profile.calls.at({"Square"s, "__init__"s}), 3u);
+    ASSERT_EQUAL(profile.calls.at({"Square"s, "area"s}), 3u);
+    ASSERT_EQUAL(profile.calls.at({"Square"s, "describe"s}), 2u);
+    ASSERT_EQUAL(profile.calls.at({"Greeter"s, "greet"s}), 3u);
+    ASSERT(Record(SHAPES_PROGRAM + "\n"s).source_hash != profile.source_hash);
+}
+
+void TestWriteReadMerge() {
+    const Profile profile = Record(SHAPES_PROGRAM);
+    ostringstream output;
+    profile.Write(output);
+    ASSERT_EQUAL(output.str().rfind("mython-profile 1 "s + to_string(profile.source_hash) + "\nbranch 18 5 2 1\n"s, 0), 0u);
+    ASSERT(output.str().find("\noperands 19 21 string string 2\n"s) != string::npos);
+    ASSERT(output.str().find("\nreceiver 18 8 Square 3\n"s) != string::npos);
+    ASSERT(output.str().find("\ncalls Greeter greet 3\n"s) != string::npos);
+
+    istringstream input(output.str());
+    Profile merged = Profile::Read(input);
+    ostringstream rewritten;
+    merged.Write(rewritten);
+    ASSERT_EQUAL(rewritten.str(), output.str());
+
+    merged.Merge(profile);
+    ASSERT_EQUAL(merged.branches.at({18, 5}).taken, 4u);
+    ASSERT_EQUAL(merged.receivers.at({19, 23}).at("Square"s), 4u);
+    ASSERT_EQUAL(merged.calls.at({"Square"s, "area"s}), 6u);
+
+    for (const string& malformed : {"profile 1 0\n"s, "mython-profile 2 0\n"s, "mython-profile 1 0\nbranch 1 2\n"s,
+                                    "mython-profile 1 0\noperands 1 2 number float 3\n"s,
+                                    "mython-profile 1 0\nloops 1 2 3\n"s}) {
+        istringstream bad(malformed);
+        ASSERT_THROWS((void)Profile::Read(bad), runtime_error);
+    }
+}
+
+void TestApplyProfile() {
+    const Profile profile = Record(SHAPES_PROGRAM);
+    auto program = Compile(SHAPES_PROGRAM, profile);
+    const Feedback& feedback = program->GetFeedback();
+    ASSERT(feedback.applied);
+    // Shape by its inherited describe, Square and Greeter by their own methods.
+    ASSERT_EQUAL(feedback.ordered_classes, 3u);
+    ASSERT_EQUAL(feedback.primed_call_sites, 5u);
+    ASSERT_EQUAL(feedback.specialized_nodes, 1u);
+    ASSERT_EQUAL(feedback.jit_candidates.size(), 4u);
+
+    runtime::Stats stats;
+    runtime::DummyContext context;
+    context.SetStats(&stats);
+    runtime::Closure closure;
+    program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+    ASSERT_EQUAL(context.output.str(), "small big shape big shape\n"s);
+
+    const auto* shape = closure.at("Shape"s).TryAs<runtime::Class>();
+    ASSERT_EQUAL(shape->GetMethods().front().name, "describe"s);
+    ASSERT_EQUAL(shape->GetMethods().back().name, "area"s);
+    if (runtime::DefaultStatsPolicy::ENABLED) {
+        ASSERT_EQUAL(stats.GetCounters().inline_cache_misses, 0u);
+        ASSERT_EQUAL(stats.GetCounters().inline_cache_hits, 8u);
+    }
+}
+
+void TestIgnoresProfileOfOtherSource() {
+    Profile profile = Record(SHAPES_PROGRAM);
+    ++profile.source_hash;
+    auto program = Compile(SHAPES_PROGRAM, profile);
+    ASSERT(!program->GetFeedback().applied);
+    ASSERT_EQUAL(program->GetFeedback().primed_call_sites, 0u);
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+    const auto* shape = closure.at("Shape"s).TryAs<runtime::Class>();
+    ASSERT_EQUAL(shape->GetMethods().front().name, "area"s);
+}
+
+void TestPrimesJit() {
+    if (!jit::Jit::IsSupported()) {
+        return;
+    }
+    // Four short runs make Square.area hot, although no single run reaches the threshold.
+    Profile profile = Record(SHAPES_PROGRAM);
+    for (int run = 0; run < 3; ++run) {
+        profile.Merge(Record(SHAPES_PROGRAM));
+    }
+    for (const bool guided : {false, true}) {
+        auto program = Compile(SHAPES_PROGRAM, guided ? profile : Profile{});
+        jit::Jit jit(jit::Options{true, 10});
+        jit::Jit::Scope scope(jit);
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+        ASSERT_EQUAL(context.output.str(), "small big shape big shape\n"s);
+
+        const auto* square = closure.at("Square"s).TryAs<runtime::Class>();
+        ASSERT_EQUAL(jit.IsCompiled(*square, *square->GetMethod("area"s)), guided);
+        ASSERT_EQUAL(jit.GetStats().native_calls, guided ? 3u : 0u);
+    }
+}
+
+}  // namespace
+
+void RunPgoTests(TestRunner& tr) {
+    RUN_TEST(tr, TestRecordsProfile);
+    RUN_TEST(tr, TestWriteReadMerge);
+    RUN_TEST(tr, TestApplyProfile);
+    RUN_TEST(tr, TestIgnoresProfileOfOtherSource);
+    RUN_TEST(tr, TestPrimesJit);
+}
+
+}  // namespace pgo
@@ -0,0 +1,265 @@
+#include "profiler.h"
+
+#include "runtime.h"
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+using namespace std;
+
+namespace profile {
+
+    namespace {
+
+        struct sigaction previous_action;
+
+        string FunctionName(const Frame& frame) {
+            if (!frame.method) {
+                return "<module>"s;
+            }
+            return frame.cls->GetDeclaringClass(*frame.method).GetName() + '.' + frame.method->name;
+        }
+
+        uint32_t LineOf(const Frame& frame) {
+            if (frame.statement) {
+                return frame.statement->GetPosition().line;
+            }
+            return frame.method ? frame.method->body->GetPosition().line : 0;
+        }
+
+        // ----------------------Counts-----------------------
+
+        struct Counts {
+            size_t                                     self = 0;
+            size_t                                     total = 0;
+        };
+
+        template <typename Key>
+        void Count(map<Key, Counts>& counts, const vector<Key>& stack) {
+            for (size_t i = 0; i < stack.size(); ++i) {
+                if (find(stack.begin(), stack.begin() + i, stack[i]) == stack.begin() + i) {
+                    ++counts[stack[i]].total;
+                }
+            }
+            if (!stack.empty()) {
+                ++counts[stack.back()].self;
+            }
+        }
+
+        template <typename Key>
+        vector<pair<Key, Counts>> MostExpensiveFirst(const map<Key, Counts>& counts) {
+            vector<pair<Key, Counts>> result(counts.begin(), counts.end());
+            stable_sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+                return tie(lhs.second.self, lhs.second.total) > tie(rhs.second.self, rhs.second.total);
+            });
+            return result;
+        }
+
+        void WriteCounts(ostream& out, const Counts& counts, size_t samples) {
+            const auto percent = [samples](size_t count) {
+                return samples ? 100.0 * static_cast<double>(count) / static_cast<double>(samples) : 0.0;
+            };
+            out << setw(8) << counts.self << setw(8) << percent(counts.self) << '%'
+                << setw(8) << counts.total << setw(8) << percent(counts.total) << '%';
+        }
+
+    }  // namespace
+
+    // ----------------------CallStack-----------------------
+
+    void CallStack::Push(const runtime::Class& cls, const runtime::Method& method) {
+        const size_t depth = depth_.load(memory_order_relaxed);
+        if (depth < MAX_DEPTH) {
+            entries_[depth].cls = &cls;
+            entries_[depth].method = &method;
+            entries_[depth].statement.store(nullptr, memory_order_relaxed);
+        }
+        atomic_signal_fence(memory_order_release);
+        depth_.store(depth + 1, memory_order_relaxed);
+    }
+
+    void CallStack::Pop() {
+        depth_.store(depth_.load(memory_order_relaxed) - 1, memory_order_relaxed);
+        atomic_signal_fence(memory_order_release);
+    }
+
+    size_t CallStack::Snapshot(Frame* frames, size_t capacity) const {
+        const size_t depth = min({depth_.load(memory_order_relaxed), MAX_DEPTH, capacity});
+        atomic_signal_fence(memory_order_acquire);
+        for (size_t i = 0; i < depth; ++i) {
+            frames[i] = Frame{entries_[i].cls, entries_[i].method, entries_[i].statement.load(memory_order_relaxed)};
+        }
+        return depth;
+    }
+
+    // ----------------------Profiler-----------------------
+
+    Profiler::Profiler(ProfilerOptions options)
+        : options_(options) {}
+
+    Profiler::~Profiler() {
+        Stop();
+    }
+
+    void Profiler::Start() {
+        if (running_) {
+            return;
+        }
+        Profiler* expected = nullptr;
+        if (!active_.compare_exchange_strong(expected, this)) {
+            throw runtime_error("Another profiler is already running"s);
+        }
+        if (samples_.empty()) {
+            samples_.resize(options_.max_samples);
+            frames_.resize(options_.max_frames);
+        }
+
+        struct sigaction action{};
+        action.sa_handler = &Profiler::HandleSignal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, &previous_action);
+        current_ = &stack_;
+
+        sigevent event{};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+        const auto seconds = chrono::duration_cast<chrono::seconds>(options_.interval);
+        const auto nanoseconds = chrono::duration_cast<chrono::nanoseconds>(options_.interval - seconds);
+        itimerspec period{};
+        period.it_interval.tv_sec = static_cast<time_t>(seconds.count());
+        period.it_interval.tv_nsec = static_cast<long>(nanoseconds.count());
+        period.it_value = period.it_interval;
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer_) != 0) {
+            const int error = errno;
+            current_ = nullptr;
+            sigaction(SIGPROF, &previous_action, nullptr);
+            active_.store(nullptr);
+            throw runtime_error("Cannot create the profiling timer: "s + to_string(error));
+        }
+        timer_settime(timer_, 0, &period, nullptr);
+        running_ = true;
+    }
+
+    void Profiler::Stop() {
+        if (!running_) {
+            return;
+        }
+        // A pending signal for this thread is delivered before timer_delete returns.
+        timer_delete(timer_);
+        current_ = nullptr;
+        sigaction(SIGPROF, &previous_action, nullptr);
+        active_.store(nullptr);
+        running_ = false;
+    }
+
+    bool Profiler::IsRunning() const {
+        return running_;
+    }
+
+    size_t Profiler::GetSampleCount() const {
+        return sample_count_.load(memory_order_relaxed);
+    }
+
+    size_t Profiler::GetDroppedCount() const {
+        return dropped_.load(memory_order_relaxed);
+    }
+
+    void Profiler::HandleSignal(int /*signal*/) {
+        const int saved_errno = errno;
+        Profiler* profiler = active_.load(memory_order_relaxed);
+        if (profiler && current_ == &profiler->stack_) {
+            profiler->TakeSample();
+        }
+        errno = saved_errno;
+    }
+
+    void Profiler::TakeSample() {
+        const size_t index = sample_count_.load(memory_order_relaxed);
+        const size_t offset = frame_count_.load(memory_order_relaxed);
+        if (index == samples_.size() || frames_.size() - offset < CallStack::MAX_DEPTH) {
+            dropped_.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        const size_t depth = stack_.Snapshot(frames_.data() + offset, CallStack::MAX_DEPTH);
+        samples_[index] = Sample{offset, depth};
+        frame_count_.store(offset + depth, memory_order_relaxed);
+        sample_count_.store(index + 1, memory_order_relaxed);
+    }
+
+    void Profiler::WriteCollapsed(ostream& out) const {
+        map<string, size_t> stacks;
+        for (size_t i = 0; i < GetSampleCount(); ++i) {
+            string stack;
+            for (size_t j = 0; j < samples_[i].depth; ++j) {
+                const Frame& frame = frames_[samples_[i].offset + j];
+                stack += (j ? ";"s : ""s) + FunctionName(frame) + ':' + to_string(LineOf(frame));
+            }
+            ++stacks[stack];
+        }
+        for (const auto& [stack, count] : stacks) {
+            out << stack << ' ' << count << '\n';
+        }
+    }
+
+    void Profiler::WriteTable(ostream& out) const {
+        using Line = pair<uint32_t, string>;
+
+        map<string, Counts> methods;
+        map<Line, Counts> lines;
+        map<string, uint32_t> definitions;
+        const size_t samples = GetSampleCount();
+        for (size_t i = 0; i < samples; ++i) {
+            vector<string> method_stack;
+            vector<Line> line_stack;
+            for (size_t j = 0; j < samples_[i].depth; ++j) {
+                const Frame& frame = frames_[samples_[i].offset + j];
+                method_stack.push_back(FunctionName(frame));
+                line_stack.emplace_back(LineOf(frame), method_stack.back());
+                if (frame.method) {
+                    definitions[method_stack.back()] = frame.method->body->GetPosition().line;
+                }
+            }
+            Count(methods, method_stack);
+            Count(lines, line_stack);
+        }
+
+        const auto old_flags = out.flags();
+        const auto old_precision = out.precision();
+        out << fixed << setprecision(1);
+        out << "samples: " << samples << ", dropped: " << GetDroppedCount()
+            << ", interval: " << options_.interval.count() << "us\n\n";
+        out << "    self    self%   total   total%  method\n";
+        for (const auto& [name, counts] : MostExpensiveFirst(methods)) {
+            WriteCounts(out, counts, samples);
+            out << "  " << name;
+            if (auto it = definitions.find(name); it != definitions.end()) {
+                out << " (line " << it->second << ')';
+            }
+            out << '\n';
+        }
+        out << "\n    self    self%   total   total%  line\n";
+        for (const auto& [line, counts] : MostExpensiveFirst(lines)) {
+            WriteCounts(out, counts, samples);
+            out << "  " << line.first << ' ' << line.second << '\n';
+        }
+        out.flags(old_flags);
+        out.precision(old_precision);
+    }
+
+}  // namespace profile
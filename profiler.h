@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <iosfwd>
+#include <vector>
+
+namespace runtime {
+
+    class Class;
+    class Executable;
+    struct Method;
+
+}  // namespace runtime
+
+// A sampling profiler of Mython programs. While a Profiler runs, the interpreter mirrors its
+// call stack into a CallStack of the profiled thread: ClassInstance::Call pushes a frame per
+// method and Compound::Execute records the statement each frame is at. A SIGPROF timer driven by
+// the thread's CPU time copies that stack into preallocated storage, so the signal handler never
+// allocates or locks. Samples are symbolized only when reports are written after Stop.
+namespace profile {
+
+    // ----------------------Frame-----------------------
+
+    // A method activation, or the module level when method is null. statement is the statement
+    // of the frame being executed, null until the first one starts.
+    struct Frame {
+        const runtime::Class*                          cls = nullptr;
+        const runtime::Method*                         method = nullptr;
+        const runtime::Executable*                     statement = nullptr;
+    };
+
+    // ----------------------CallStack-----------------------
+
+    // Written only by its own thread and read by the signal handler interrupting that thread.
+    // Frames deeper than MAX_DEPTH are counted but not recorded.
+    class CallStack {
+    public:
+        static constexpr size_t                        MAX_DEPTH = 256;
+
+        void                                           Push(const runtime::Class& cls, const runtime::Method& method);
+
+        void                                           Pop();
+
+        void                                           At(const runtime::Executable& statement);
+
+        // Copies the recorded frames, outermost first, and returns how many were copied.
+        size_t                                         Snapshot(Frame* frames, size_t capacity) const;
+
+    private:
+        struct Entry {
+            const runtime::Class*                      cls = nullptr;
+            const runtime::Method*                     method = nullptr;
+            std::atomic<const runtime::Executable*>    statement{nullptr};
+        };
+
+        std::array<Entry, MAX_DEPTH>                   entries_;
+        std::atomic<size_t>                            depth_{1};
+    };
+
+    // ----------------------ProfilerOptions-----------------------
+
+    struct ProfilerOptions {
+        std::chrono::microseconds                      interval{1000};
+        size_t                                         max_samples = 1 << 16;
+        size_t                                         max_frames = 1 << 20;
+    };
+
+    // ----------------------Profiler-----------------------
+
+    // Start and Stop are called on the thread that executes the program, outside of it; only
+    // that thread is sampled. At most one Profiler runs at a time in a process.
+    class Profiler {
+    public:
+        // Keeps a method frame on the current thread's stack, if it is being profiled.
+        class MethodScope {
+        public:
+                                                       MethodScope(const runtime::Class& cls, const runtime::Method& method);
+
+            MethodScope(const MethodScope&) = delete;
+            MethodScope& operator=(const MethodScope&) = delete;
+
+            ~MethodScope();
+
+        private:
+            CallStack* stack_;
+        };
+
+        explicit                                       Profiler(ProfilerOptions options = {});
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        ~Profiler();
+
+        void                                           Start();
+
+        void                                           Stop();
+
+        [[nodiscard]] bool                             IsRunning() const;
+
+        static void                                    AtStatement(const runtime::Executable& statement);
+
+        [[nodiscard]] size_t                           GetSampleCount() const;
+
+        // Samples that did not fit into max_samples or max_frames.
+        [[nodiscard]] size_t                           GetDroppedCount() const;
+
+        // One line per distinct stack, "frame;frame;... count", outermost first, where a frame is
+        // "Class.method:line" or "<module>:line". Ready for flamegraph.pl and speedscope.
+        void                                           WriteCollapsed(std::ostream& out) const;
+
+        // Self and total samples per method and per source line, most expensive first.
+        void                                           WriteTable(std::ostream& out) const;
+
+    private:
+        struct Sample {
+            size_t                                     offset = 0;
+            size_t                                     depth = 0;
+        };
+
+        static void                                    HandleSignal(int signal);
+
+        void                                           TakeSample();
+
+        ProfilerOptions                                options_;
+        CallStack                                      stack_;
+        std::vector<Sample>                            samples_;
+        std::vector<Frame>                             frames_;
+        std::atomic<size_t>                            sample_count_{0};
+        std::atomic<size_t>                            frame_count_{0};
+        std::atomic<size_t>                            dropped_{0};
+        bool                                           running_ = false;
+        timer_t                                        timer_{};
+
+        static inline thread_local CallStack*          current_ = nullptr;
+        static inline std::atomic<Profiler*>           active_{nullptr};
+    };
+
+    inline void CallStack::At(const runtime::Executable& statement) {
+        const size_t depth = depth_.load(std::memory_order_relaxed);
+        if (depth <= MAX_DEPTH) {
+            entries_[depth - 1].statement.store(&statement, std::memory_order_relaxed);
+        }
+    }
+
+    inline void Profiler::AtStatement(const runtime::Executable& statement) {
+        if (current_) {
+            current_->At(statement);
+        }
+    }
+
+    inline Profiler::MethodScope::MethodScope(const runtime::Class& cls, const runtime::Method& method)
+        : stack_(current_) {
+        if (stack_) {
+            stack_->Push(cls, method);
+        }
+    }
+
+    inline Profiler::MethodScope::~MethodScope() {
+        if (stack_) {
+            stack_->Pop();
+        }
+    }
+
+}  // namespace profile
@@ -0,0 +1,129 @@
+#include "profiler.h"
+#include "statement.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace profile {
+
+namespace {
+
+const string FIB_PROGRAM = R"(
+class Fib:
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+class Loud(Fib):
+  def shout():
+    return self.fib(12)
+
+f = Loud()
+x = f.shout()
+)"s;
+
+const runtime::Class& ClassOf(const runtime::Executable& statement) {
+    return *dynamic_cast<const ast::ClassDefinition&>(statement).GetClass().TryAs<runtime::Class>();
+}
+
+void TestStatementPositions() {
+    auto program = ParseFromString(FIB_PROGRAM);
+    const auto& statements = dynamic_cast<ast::Compound&>(*program).GetStatements();
+    ASSERT_EQUAL(statements.size(), 4u);
+    ASSERT_EQUAL(statements[0]->GetPosition().line, 2u);
+    ASSERT_EQUAL(statements[1]->GetPosition().line, 8u);
+    ASSERT_EQUAL(statements[3]->GetPosition().line, 13u);
+    ASSERT_EQUAL(statements[3]->GetPosition().column, 1u);
+
+    const runtime::Method* fib = ClassOf(*statements[0]).GetMethod("fib"s);
+    ASSERT_EQUAL(fib->body->GetPosition().line, 3u);
+    ASSERT_EQUAL(fib->body->GetPosition().column, 3u);
+    const auto* body = dynamic_cast<const ast::MethodBody&>(*fib->body).GetBody();
+    const auto& fib_statements = dynamic_cast<const ast::Compound&>(*body).GetStatements();
+    ASSERT_EQUAL(fib_statements[0]->GetPosition().line, 4u);
+    ASSERT_EQUAL(fib_statements[0]->GetPosition().column, 5u);
+    ASSERT_EQUAL(fib_statements[1]->GetPosition().line, 6u);
+}
+
+void TestCallStackSnapshot() {
+    auto program = ParseFromString(FIB_PROGRAM);
+    const auto& statements = dynamic_cast<ast::Compound&>(*program).GetStatements();
+    const runtime::Class& fib_class = ClassOf(*statements[0]);
+
+    CallStack stack;
+    Frame frames[CallStack::MAX_DEPTH];
+    ASSERT_EQUAL(stack.Snapshot(frames, CallStack::MAX_DEPTH), 1u);
+    ASSERT(frames[0].method == nullptr && frames[0].statement == nullptr);
+
+    stack.At(*statements[3]);
+    stack.Push(fib_class, *fib_class.GetMethod("fib"s));
+    stack.At(*statements[2]);
+    ASSERT_EQUAL(stack.Snapshot(frames, CallStack::MAX_DEPTH), 2u);
+    ASSERT(frames[0].statement == statements[3].get());
+    ASSERT(frames[1].method == fib_class.GetMethod("fib"s));
+    ASSERT(frames[1].statement == statements[2].get());
+    ASSERT_EQUAL(stack.Snapshot(frames, 1), 1u);
+
+    for (size_t i = 0; i < CallStack::MAX_DEPTH + 10; ++i) {
+        stack.Push(fib_class, *fib_class.GetMethod("fib"s));
+    }
+    ASSERT_EQUAL(stack.Snapshot(frames, CallStack::MAX_DEPTH), CallStack::MAX_DEPTH);
+    for (size_t i = 0; i < CallStack::MAX_DEPTH + 10; ++i) {
+        stack.Pop();
+    }
+    stack.Pop();
+    ASSERT_EQUAL(stack.Snapshot(frames, CallStack::MAX_DEPTH), 1u);
+}
+
+void TestSamplesAttributeMethodsAndLines() {
+    auto program = ParseFromString(FIB_PROGRAM);
+    Profiler profiler(ProfilerOptions{chrono::microseconds(200)});
+    profiler.Start();
+    ASSERT(profiler.IsRunning());
+    ASSERT_THROWS(Profiler().Start(), runtime_error);
+    for (size_t i = 0; i < 1000 && profiler.GetSampleCount() < 20; ++i) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        program->Execute(closure, context);
+    }
+    profiler.Stop();
+    ASSERT(!profiler.IsRunning());
+    ASSERT(profiler.GetSampleCount() >= 20);
+
+    ostringstream collapsed;
+    profiler.WriteCollapsed(collapsed);
+    istringstream stacks(collapsed.str());
+    size_t counted = 0;
+    bool inherited_call_seen = false;
+    for (string stack; getline(stacks, stack);) {
+        ASSERT(stack.rfind("<module>:"s, 0) == 0);
+        counted += stoul(stack.substr(stack.rfind(' ') + 1));
+        inherited_call_seen |= stack.rfind("<module>:13;Loud.shout:10;Fib.fib:"s, 0) == 0;
+    }
+    ASSERT_EQUAL(counted, profiler.GetSampleCount());
+    ASSERT(inherited_call_seen);
+
+    ostringstream table;
+    profiler.WriteTable(table);
+    ASSERT(table.str().find("  Fib.fib (line 3)\n"s) != string::npos);
+    ASSERT(table.str().find("  Loud.shout (line 9)\n"s) != string::npos);
+    ASSERT(table.str().find("  10 Loud.shout\n"s) != string::npos);
+
+    Profiler next;
+    next.Start();
+    next.Stop();
+}
+
+}  // namespace
+
+void RunProfilerTests(TestRunner& tr) {
+    RUN_TEST(tr, TestStatementPositions);
+    RUN_TEST(tr, TestCallStackSnapshot);
+    RUN_TEST(tr, TestSamplesAttributeMethodsAndLines);
+}
+
+}  // namespace profile
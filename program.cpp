@@ -0,0 +1,67 @@
+#include "program.h"
+
+#include "jit.h"
+#include "lexer.h"
+#include "parse.h"
+
+using namespace std;
+
+Program::Program(unique_ptr<runtime::Executable> tree, pgo::Feedback feedback)
+    : tree_(move(tree))
+    , feedback_(move(feedback)) {}
+
+runtime::ObjectHolder Program::Execute(runtime::Closure& closure, runtime::Context& context, ExecutionMode mode,
+    const vm::Options& options) const {
+    runtime::Stats::Scope stats_scope(context.GetStats());
+    if (jit::Jit* jit = jit::Jit::Current(); jit) {
+        for (const pgo::JitCandidate& candidate : feedback_.jit_candidates) {
+            jit->Prime(*candidate.cls, *candidate.method, candidate.calls);
+        }
+    }
+    if (mode == ExecutionMode::STACKLESS) {
+        return vm::Execute(GetModule(), closure, context, options);
+    }
+    if (mode == ExecutionMode::CLOSURE_COMPILED) {
+        return GetCompiled().Execute(closure, context);
+    }
+    if (mode == ExecutionMode::SEALED_TREE) {
+        return GetSealed().Evaluate(closure, context);
+    }
+    runtime::MemoryAccount::Scope memory_scope(context.GetMemoryAccount());
+    return tree_->Execute(closure, context);
+}
+
+const vm::Module& Program::GetModule() const {
+    call_once(module_once_, [this] {
+        module_ = make_unique<vm::Module>(*tree_);
+    });
+    return *module_;
+}
+
+const compiled::Module& Program::GetCompiled() const {
+    call_once(compiled_once_, [this] {
+        compiled_ = make_unique<compiled::Module>(*tree_);
+    });
+    return *compiled_;
+}
+
+const sealed::Tree& Program::GetSealed() const {
+    call_once(sealed_once_, [this] {
+        sealed_ = make_unique<sealed::Tree>(*tree_);
+    });
+    return *sealed_;
+}
+
+const pgo::Feedback& Program::GetFeedback() const {
+    return feedback_;
+}
+
+shared_ptr<const Program> CompileProgram(parse::Lexer& lexer) {
+    return make_shared<const Program>(ParseProgram(lexer));
+}
+
+shared_ptr<const Program> CompileProgram(parse::Lexer& lexer, const pgo::Profile& profile) {
+    unique_ptr<runtime::Executable> tree = ParseProgram(lexer);
+    pgo::Feedback feedback = pgo::Apply(profile, lexer.GetSourceHash(), *tree);
+    return make_shared<const Program>(move(tree), move(feedback));
+}
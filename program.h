@@ -0,0 +1,68 @@
+#pragma once
+
+#include "compiled.h"
+#include "pgo.h"
+#include "runtime.h"
+#include "sealed_ast.h"
+#include "vm.h"
+
+#include <memory>
+#include <mutex>
+
+namespace parse {
+class Lexer;
+}
+
+// A parsed Mython program. Everything it owns - the statement tree, the classes declared in it
+// and its constants - is immutable after parsing, so one Program may be executed any number of
+// times and from any number of threads at once, provided every execution gets its own Closure
+// and Context. Objects created by an execution are owned by that execution's closure and may
+// outlive the Program.
+//
+// STACKLESS runs the program on the vm interpreter, whose call frames live on the heap, so the
+// recursion depth is bounded by vm::Options::max_stack_bytes rather than by the native stack.
+// CLOSURE_COMPILED runs the program as a tree of closures built once by compiled::Module, and
+// SEALED_TREE evaluates its std::variant form, sealed::Tree, without virtual dispatch.
+enum class ExecutionMode {
+    TREE_WALKING,
+    STACKLESS,
+    CLOSURE_COMPILED,
+    SEALED_TREE
+};
+
+class Program {
+public:
+    explicit                                       Program(std::unique_ptr<runtime::Executable> tree,
+                                                           pgo::Feedback feedback = {});
+
+    runtime::ObjectHolder                          Execute(runtime::Closure& closure, runtime::Context& context,
+                                                           ExecutionMode mode = ExecutionMode::TREE_WALKING,
+                                                           const vm::Options& options = {}) const;
+
+    [[nodiscard]] const vm::Module& GetModule() const;
+
+    // What the profile given to CompileProgram changed; nothing was applied without one.
+    [[nodiscard]] const pgo::Feedback&             GetFeedback() const;
+
+private:
+    [[nodiscard]] const compiled::Module&          GetCompiled() const;
+
+    [[nodiscard]] const sealed::Tree&              GetSealed() const;
+
+    std::unique_ptr<runtime::Executable>           tree_;
+    // The forms of the other execution modes are built on their first use, so a program only
+    // pays for the modes it is actually run in.
+    mutable std::once_flag                         module_once_;
+    mutable std::unique_ptr<vm::Module>            module_;
+    mutable std::once_flag                         compiled_once_;
+    mutable std::unique_ptr<compiled::Module>      compiled_;
+    mutable std::once_flag                         sealed_once_;
+    mutable std::unique_ptr<sealed::Tree>          sealed_;
+    pgo::Feedback                                  feedback_;
+};
+
+std::shared_ptr<const Program> CompileProgram(parse::Lexer& lexer);
+
+// Applies a profile recorded from the same source (see pgo::Apply) before the tree is converted
+// to the other execution modes, so they are built from the optimized tree.
+std::shared_ptr<const Program> CompileProgram(parse::Lexer& lexer, const pgo::Profile& profile);
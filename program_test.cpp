@@ -0,0 +1,91 @@
+#include "program.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const string SHAPES_PROGRAM = R"(
+class Box:
+  def __init__(value):
+    self.value = value
+
+  def __str__():
+    return 'Box(' + str(self.value) + ')'
+
+class Factory:
+  def make(value):
+    return Box(value)
+
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+factory = Factory()
+a = factory.make(1)
+b = factory.make('two')
+a.value = a.value + 10
+fib = Fib()
+print a, b, fib.calc(15)
+)"s;
+
+void TestNewInstanceCreatesFreshObjects() {
+    auto program = CompileFromString(SHAPES_PROGRAM);
+    for (int i = 0; i < 2; ++i) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        program->Execute(closure, context);
+        ASSERT_EQUAL(context.output.str(), "Box(11) Box(two) 610\n"s);
+        ASSERT(closure.at("a"s).Get() != closure.at("b"s).Get());
+    }
+}
+
+void TestResultsOutliveProgram() {
+    runtime::Closure closure;
+    {
+        auto program = CompileFromString("x = 'constant'\ny = 42\n"s);
+        runtime::DummyContext context;
+        program->Execute(closure, context);
+    }
+    ASSERT_EQUAL(closure.at("x"s).TryAs<runtime::String>()->GetValue(), "constant"s);
+    ASSERT_EQUAL(closure.at("y"s).TryAs<runtime::Number>()->GetValue(), 42);
+}
+
+void TestConcurrentExecution() {
+    auto program = CompileFromString(SHAPES_PROGRAM);
+    atomic<int> failures = 0;
+    vector<thread> workers;
+    // Every mode is first used by two threads at once, which race to build its form.
+    const ExecutionMode modes[] = {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS, ExecutionMode::CLOSURE_COMPILED,
+                                   ExecutionMode::SEALED_TREE};
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([&program, &failures, mode = modes[t % 4]] {
+            for (int i = 0; i < 20; ++i) {
+                runtime::DummyContext context;
+                runtime::Closure closure;
+                program->Execute(closure, context, mode);
+                if (context.output.str() != "Box(11) Box(two) 610\n"s) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQUAL(failures.load(), 0);
+}
+
+}  // namespace
+
+void RunProgramTests(TestRunner& tr) {
+    RUN_TEST(tr, TestNewInstanceCreatesFreshObjects);
+    RUN_TEST(tr, TestResultsOutliveProgram);
+    RUN_TEST(tr, TestConcurrentExecution);
+}
@@ -0,0 +1,131 @@
+#include "quota.h"
+
+#include <string>
+
+using namespace std;
+
+namespace runtime {
+
+    // ----------------------MemoryQuotaExceededError-----------------------
+
+    MemoryQuotaExceededError::MemoryQuotaExceededError(size_t requested, size_t quota)
+        : runtime_error("Memory quota exceeded: "s + to_string(requested) + " more bytes requested, quota is "s
+            + to_string(quota) + " bytes"s)
+        , requested_(requested)
+        , quota_(quota) {}
+
+    size_t MemoryQuotaExceededError::GetRequested() const {
+        return requested_;
+    }
+
+    size_t MemoryQuotaExceededError::GetQuota() const {
+        return quota_;
+    }
+
+    // ----------------------Scope-----------------------
+
+    MemoryAccount::Scope::Scope(MemoryAccount* account)
+        : previous_(current_) {
+        if (account) {
+            current_ = account;
+        }
+    }
+
+    MemoryAccount::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    // ----------------------State-----------------------
+
+    MemoryAccount::State::State(size_t quota)
+        : quota(quota) {}
+
+    void MemoryAccount::State::Charge(size_t bytes) {
+        size_t used = current.load(memory_order_relaxed);
+        do {
+            if (bytes > quota || used > quota - bytes) {
+                throw MemoryQuotaExceededError(bytes, quota);
+            }
+        } while (!current.compare_exchange_weak(used, used + bytes, memory_order_relaxed));
+
+        const size_t now = used + bytes;
+        size_t seen = peak.load(memory_order_relaxed);
+        while (seen < now && !peak.compare_exchange_weak(seen, now, memory_order_relaxed)) {
+        }
+    }
+
+    void MemoryAccount::State::Refund(size_t bytes) {
+        current.fetch_sub(bytes, memory_order_relaxed);
+    }
+
+    // ----------------------MemoryAccount-----------------------
+
+    MemoryAccount::MemoryAccount(size_t quota)
+        : state_(make_shared<State>(quota)) {}
+
+    void MemoryAccount::Charge(size_t bytes) {
+        state_->Charge(bytes);
+    }
+
+    void MemoryAccount::Refund(size_t bytes) {
+        state_->Refund(bytes);
+    }
+
+    size_t MemoryAccount::GetQuota() const {
+        return state_->quota;
+    }
+
+    size_t MemoryAccount::GetCurrentBytes() const {
+        return state_->current.load(memory_order_relaxed);
+    }
+
+    size_t MemoryAccount::GetPeakBytes() const {
+        return state_->peak.load(memory_order_relaxed);
+    }
+
+    // ----------------------MemoryCharge-----------------------
+
+    MemoryCharge::MemoryCharge(MemoryCharge&& other) noexcept
+        : state_(move(other.state_))
+        , bytes_(other.bytes_) {
+        other.bytes_ = 0;
+    }
+
+    MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+        if (this != &other) {
+            Release();
+            state_ = move(other.state_);
+            bytes_ = other.bytes_;
+            other.bytes_ = 0;
+        }
+        return *this;
+    }
+
+    MemoryCharge::~MemoryCharge() {
+        Release();
+    }
+
+    void MemoryCharge::Add(size_t bytes) {
+        if (!state_) {
+            MemoryAccount* account = MemoryAccount::Current();
+            if (!account) {
+                return;
+            }
+            state_ = account->state_;
+        }
+        state_->Charge(bytes);
+        bytes_ += bytes;
+    }
+
+    size_t MemoryCharge::GetBytes() const {
+        return bytes_;
+    }
+
+    void MemoryCharge::Release() {
+        if (state_ && bytes_ > 0) {
+            state_->Refund(bytes_);
+        }
+        bytes_ = 0;
+    }
+
+}  // namespace runtime
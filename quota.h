@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace runtime {
+
+    // ----------------------MemoryQuotaExceededError-----------------------
+
+    class MemoryQuotaExceededError : public std::runtime_error {
+    public:
+        MemoryQuotaExceededError(size_t requested, size_t quota);
+
+        [[nodiscard]] size_t                           GetRequested() const;
+
+        [[nodiscard]] size_t                           GetQuota() const;
+
+    private:
+        size_t                                         requested_;
+        size_t                                         quota_;
+    };
+
+    // ----------------------MemoryAccount-----------------------
+
+    // Counts the bytes held by runtime objects allocated while the account is current. Objects keep
+    // the account state alive and refund their bytes when they are destroyed, whichever thread that
+    // happens on.
+    class MemoryAccount {
+    public:
+        static constexpr size_t                        UNLIMITED = std::numeric_limits<size_t>::max();
+
+        class Scope {
+        public:
+            // A null account leaves the enclosing one current.
+            explicit                                   Scope(MemoryAccount* account);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            MemoryAccount* previous_;
+        };
+
+        explicit                                       MemoryAccount(size_t quota = UNLIMITED);
+
+        [[nodiscard]] static MemoryAccount* Current();
+
+        void                                           Charge(size_t bytes);
+
+        void                                           Refund(size_t bytes);
+
+        [[nodiscard]] size_t                           GetQuota() const;
+
+        [[nodiscard]] size_t                           GetCurrentBytes() const;
+
+        [[nodiscard]] size_t                           GetPeakBytes() const;
+
+    private:
+        struct State {
+            explicit                                   State(size_t quota);
+
+            void                                       Charge(size_t bytes);
+
+            void                                       Refund(size_t bytes);
+
+            size_t                                     quota;
+            std::atomic<size_t>                        current = 0;
+            std::atomic<size_t>                        peak = 0;
+        };
+
+        template <typename T, typename Inner>
+        friend class AccountingAllocator;
+
+        friend class MemoryCharge;
+
+        std::shared_ptr<State>                         state_;
+
+        static inline thread_local MemoryAccount* current_ = nullptr;
+    };
+
+    inline MemoryAccount* MemoryAccount::Current() {
+        return current_;
+    }
+
+    // ----------------------MemoryCharge-----------------------
+
+    // Bytes charged on behalf of an object outside its own allocation, such as the entries of an
+    // instance's field map. They are refunded when the charge is destroyed.
+    class MemoryCharge {
+    public:
+        MemoryCharge() = default;
+
+        MemoryCharge(const MemoryCharge&) = delete;
+        MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+        MemoryCharge(MemoryCharge&& other) noexcept;
+        MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+
+        ~MemoryCharge();
+
+        // Charges the current account, if any.
+        void                                           Add(size_t bytes);
+
+        [[nodiscard]] size_t                           GetBytes() const;
+
+    private:
+        void                                           Release();
+
+        std::shared_ptr<MemoryAccount::State>          state_;
+        size_t                                         bytes_ = 0;
+    };
+
+    // ----------------------AccountingAllocator-----------------------
+
+    // Wraps another allocator and charges every allocation, plus extra_bytes held outside of it,
+    // to an account.
+    template <typename T, typename Inner>
+    class AccountingAllocator {
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind {
+            using other = AccountingAllocator<U, typename std::allocator_traits<Inner>::template rebind_alloc<U>>;
+        };
+
+        AccountingAllocator(const MemoryAccount& account, Inner inner, size_t extra_bytes);
+
+        template <typename U, typename OtherInner>
+        AccountingAllocator(const AccountingAllocator<U, OtherInner>& other);
+
+        [[nodiscard]] T* allocate(size_t n);
+
+        void                                           deallocate(T* ptr, size_t n);
+
+        template <typename U, typename OtherInner>
+        bool                                           operator==(const AccountingAllocator<U, OtherInner>& other) const;
+
+        template <typename U, typename OtherInner>
+        bool                                           operator!=(const AccountingAllocator<U, OtherInner>& other) const;
+
+    private:
+        template <typename U, typename OtherInner>
+        friend class AccountingAllocator;
+
+        std::shared_ptr<MemoryAccount::State>          state_;
+        Inner                                          inner_;
+        size_t                                         extra_bytes_;
+    };
+
+    template <typename T, typename Inner>
+    AccountingAllocator<T, Inner>::AccountingAllocator(const MemoryAccount& account, Inner inner, size_t extra_bytes)
+        : state_(account.state_)
+        , inner_(std::move(inner))
+        , extra_bytes_(extra_bytes) {}
+
+    template <typename T, typename Inner>
+    template <typename U, typename OtherInner>
+    AccountingAllocator<T, Inner>::AccountingAllocator(const AccountingAllocator<U, OtherInner>& other)
+        : state_(other.state_)
+        , inner_(other.inner_)
+        , extra_bytes_(other.extra_bytes_) {}
+
+    template <typename T, typename Inner>
+    T* AccountingAllocator<T, Inner>::allocate(size_t n) {
+        const size_t bytes = n * sizeof(T) + extra_bytes_;
+        state_->Charge(bytes);
+        try {
+            return inner_.allocate(n);
+        }
+        catch (...) {
+            state_->Refund(bytes);
+            throw;
+        }
+    }
+
+    template <typename T, typename Inner>
+    void AccountingAllocator<T, Inner>::deallocate(T* ptr, size_t n) {
+        inner_.deallocate(ptr, n);
+        state_->Refund(n * sizeof(T) + extra_bytes_);
+    }
+
+    template <typename T, typename Inner>
+    template <typename U, typename OtherInner>
+    bool AccountingAllocator<T, Inner>::operator==(const AccountingAllocator<U, OtherInner>& other) const {
+        return state_ == other.state_ && inner_ == other.inner_;
+    }
+
+    template <typename T, typename Inner>
+    template <typename U, typename OtherInner>
+    bool AccountingAllocator<T, Inner>::operator!=(const AccountingAllocator<U, OtherInner>& other) const {
+        return !(*this == other);
+    }
+
+}  // namespace runtime
@@ -0,0 +1,120 @@
+#include "executor.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string DOUBLING_PROGRAM = R"(
+class Grow:
+  def run(s, n):
+    if n == 0:
+      return s
+    return self.run(s + s, n - 1)
+
+g = Grow()
+result = g.run('0123456789abcdef', n)
+)"s;
+
+void TestAccountTracksObjects() {
+    MemoryAccount account;
+    {
+        MemoryAccount::Scope scope(&account);
+        ObjectHolder number = ObjectHolder::Own(Number(42));
+        const size_t after_number = account.GetCurrentBytes();
+        ASSERT(after_number >= sizeof(Number));
+
+        ObjectHolder text = ObjectHolder::Own(String(string(1000, 'x')));
+        ASSERT(account.GetCurrentBytes() >= after_number + sizeof(String) + 1000);
+
+        ObjectHolder copy = text;
+        number = {};
+        text = {};
+        ASSERT(account.GetCurrentBytes() >= 1000);
+    }
+    ASSERT_EQUAL(account.GetCurrentBytes(), 0U);
+    ASSERT(account.GetPeakBytes() >= sizeof(Number) + sizeof(String) + 1000);
+}
+
+void TestInstanceFieldsAreCharged() {
+    Class cls("Point"s, {}, nullptr);
+    MemoryAccount account;
+    MemoryAccount::Scope scope(&account);
+    ObjectHolder point = ObjectHolder::Own(ClassInstance(cls));
+    const size_t empty = account.GetCurrentBytes();
+
+    auto instance = point.TryAs<ClassInstance>();
+    instance->SetField("x"s, ObjectHolder::Own(Number(1)));
+    const size_t one_field = account.GetCurrentBytes();
+    ASSERT(one_field > empty + sizeof(Number));
+    instance->SetField("x"s, ObjectHolder::Own(Number(2)));
+    ASSERT_EQUAL(account.GetCurrentBytes(), one_field);
+    instance->SetField("a_field_name_long_enough_to_live_on_the_heap"s, ObjectHolder::None());
+    ASSERT(account.GetCurrentBytes() > one_field + 40);
+
+    point = {};
+    ASSERT_EQUAL(account.GetCurrentBytes(), 0U);
+}
+
+void TestQuotaStopsRunawayStrings() {
+    auto program = CompileFromString(DOUBLING_PROGRAM);
+    for (auto mode : {ExecutionMode::TREE_WALKING, ExecutionMode::STACKLESS, ExecutionMode::CLOSURE_COMPILED,
+                      ExecutionMode::SEALED_TREE}) {
+        MemoryAccount account(1 << 20);
+        DummyContext context;
+        context.SetMemoryAccount(&account);
+        {
+            Closure closure;
+            closure["n"s] = ObjectHolder::Own(Number(10));
+            program->Execute(closure, context, mode);
+            ASSERT_EQUAL(closure.at("result"s).TryAs<String>()->GetValue().size(), 16U << 10);
+        }
+        ASSERT_EQUAL(account.GetCurrentBytes(), 0U);
+
+        Closure closure;
+        closure["n"s] = ObjectHolder::Own(Number(40));
+        try {
+            program->Execute(closure, context, mode);
+            ASSERT(false);
+        }
+        catch (const MemoryQuotaExceededError& error) {
+            ASSERT_EQUAL(error.GetQuota(), size_t{1 << 20});
+        }
+        ASSERT(account.GetPeakBytes() <= account.GetQuota());
+        closure.clear();
+        ASSERT_EQUAL(account.GetCurrentBytes(), 0U);
+    }
+}
+
+void TestJobsCarryQuota() {
+    auto program = CompileFromString(DOUBLING_PROGRAM);
+    Executor executor(1);
+
+    Job small{program, {}, nullptr};
+    small.inputs["n"s] = ObjectHolder::Own(Number(4));
+    JobResult result = executor.Submit(move(small)).get();
+    ASSERT(result.ok);
+    ASSERT(result.peak_memory_bytes > 256);
+
+    Job runaway{program, {}, nullptr};
+    runaway.inputs["n"s] = ObjectHolder::Own(Number(40));
+    runaway.memory_quota = 1 << 16;
+    result = executor.Submit(move(runaway)).get();
+    ASSERT(!result.ok);
+    ASSERT(result.error.find("Memory quota exceeded"s) == 0);
+    ASSERT(result.peak_memory_bytes <= size_t{1 << 16});
+}
+
+}  // namespace
+
+void RunQuotaTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestAccountTracksObjects);
+    RUN_TEST(tr, runtime::TestInstanceFieldsAreCharged);
+    RUN_TEST(tr, runtime::TestQuotaStopsRunawayStrings);
+    RUN_TEST(tr, runtime::TestJobsCarryQuota);
+}
+
+}  // namespace runtime
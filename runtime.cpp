@@ -1,11 +1,64 @@
 #include "runtime.h"
 
+#include "counters.h"
+#include "jit.h"
+#include "pgo.h"
+#include "profiler.h"
+#include "trace.h"
+
+#include <algorithm>
 #include <cassert>
 
 using namespace std;
 
 namespace runtime {
 
+    namespace {
+        size_t HeapBytes(const std::string& value) {
+            const char* begin = reinterpret_cast<const char*>(&value);
+            const bool is_inline = value.data() >= begin && value.data() < begin + sizeof(value);
+            return is_inline ? 0 : value.capacity() + 1;
+        }
+    }  // namespace
+
+    // ----------------------Context-----------------------
+
+    void Context::Write(std::string_view data) {
+        GetOutputStream().write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    void Context::SetBudget(ExecutionBudget* budget) {
+        budget_ = budget;
+    }
+
+    ExecutionBudget* Context::GetBudget() const {
+        return budget_;
+    }
+
+    void Context::SetMemoryAccount(MemoryAccount* account) {
+        memory_account_ = account;
+    }
+
+    MemoryAccount* Context::GetMemoryAccount() const {
+        return memory_account_;
+    }
+
+    void Context::SetStats(Stats* stats) {
+        stats_ = stats;
+    }
+
+    Stats* Context::GetStats() const {
+        return stats_;
+    }
+
+    // ----------------------Object-----------------------
+
+    void Object::FormatTo(std::string& buffer, Context& context) {
+        ostringstream os;
+        Print(os, context);
+        buffer += os.str();
+    }
+
     // ----------------------ObjectHolder-----------------------
 
     ObjectHolder::ObjectHolder(shared_ptr<Object> data)
@@ -17,6 +70,13 @@ namespace runtime {
     }
 
     ObjectHolder ObjectHolder::Share(Object& object) {
+        // An owning self is what lets a collector see the cycle in self.me = self, but without a
+        // collector to break it that cycle would never be freed.
+        if (CycleCollector::Current()) {
+            if (auto owner = object.weak_from_this().lock(); owner) {
+                return ObjectHolder(move(owner));
+            }
+        }
         return ObjectHolder(shared_ptr<Object>(&object, [](auto*) {}));
     }
 
@@ -57,10 +117,19 @@ namespace runtime {
         return false;
     }
 
-    // ----------------------Bool-----------------------
+    // ----------------------PrintArgument-----------------------
 
-    void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
-        os << (GetValue() ? "True"sv : "False"sv);
+    size_t PrintArgument(const ObjectHolder& object, bool last, Context& context) {
+        string buffer;
+        if (object) {
+            object->FormatTo(buffer, context);
+        }
+        else {
+            buffer += "None"sv;
+        }
+        buffer += last ? '\n' : ' ';
+        context.Write(buffer);
+        return buffer.size();
     }
 
     // ----------------------Class-----------------------
@@ -86,8 +155,40 @@ namespace runtime {
         return name_;
     }
 
-    void Class::Print(ostream& os, [[maybe_unused]] Context& context) {
-        os << "Class "sv << GetName();
+    const std::vector<Method>& Class::GetMethods() const {
+        return methods_;
+    }
+
+    const Class* Class::GetParent() const {
+        return parent_;
+    }
+
+    const Class& Class::GetDeclaringClass(const Method& method) const {
+        for (const Class* current = this; current; current = current->parent_) {
+            for (const Method& candidate : current->methods_) {
+                if (&candidate == &method) {
+                    return *current;
+                }
+            }
+        }
+        return *this;
+    }
+
+    void Class::OrderMethods(const std::function<uint64_t(const Method&)>& weight) {
+        std::stable_sort(methods_.begin(), methods_.end(), [&weight](const Method& lhs, const Method& rhs) {
+            return weight(lhs) > weight(rhs);
+        });
+    }
+
+    void Class::Print(ostream& os, Context& context) {
+        string buffer;
+        FormatTo(buffer, context);
+        os << buffer;
+    }
+
+    void Class::FormatTo(std::string& buffer, [[maybe_unused]] Context& context) {
+        buffer += "Class "sv;
+        buffer += GetName();
     }
 
     // ----------------------ClassInstance-----------------------
@@ -96,34 +197,76 @@ namespace runtime {
         : cls_(cls) {}
 
     void ClassInstance::Print(ostream& os, Context& context) {
+        string buffer;
+        FormatTo(buffer, context);
+        os << buffer;
+    }
+
+    void ClassInstance::FormatTo(std::string& buffer, Context& context) {
         const string method_name = "__str__"s;
         if (HasMethod(method_name, 0)) {
-            Call(method_name, {}, context).Get()->Print(os, context);
+            if (ObjectHolder result = Call(method_name, {}, context); result) {
+                result->FormatTo(buffer, context);
+            }
+            else {
+                buffer += "None"sv;
+            }
         }
         else {
-            os << this;
+            FormatPointer(buffer, this);
         }
     }
 
     ObjectHolder ClassInstance::Call(const std::string& method,
         const std::vector<ObjectHolder>& actual_args,
         Context& context) {
-        if (HasMethod(method, actual_args.size())) {
-            Closure closure;
-            for (size_t i = 0; i < actual_args.size(); ++i) {
-                closure.emplace(cls_.GetMethod(method)->formal_params.at(i), actual_args.at(i));
-            }
-            closure.emplace("self"s, ObjectHolder::Share(*this));
-            return cls_.GetMethod(method)->body->Execute(closure, context);
+        context.ChargeStep();
+        Hooks::MethodLookedUp();
+        if (const Method* callee = cls_.GetMethod(method); callee && callee->formal_params.size() == actual_args.size()) {
+            return Invoke(*callee, actual_args, context);
         }
         throw runtime_error("No method "s + method);
     }
 
+    ObjectHolder ClassInstance::Call(const Method& method,
+        const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+        context.ChargeStep();
+        return Invoke(method, actual_args, context);
+    }
+
+    ObjectHolder ClassInstance::Invoke(const Method& method,
+        const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+        Hooks::Call call;
+        HeapProfiler::CallSite call_site;
+        profile::Profiler::MethodScope frame(cls_, method);
+        profile::CounterProfiler::MethodScope counters(cls_, method);
+        pgo::Recorder::Invoked(cls_, method);
+        trace::Tracer::Span span("call", &cls_.GetName(), method.name, "arity", actual_args.size());
+        if (jit::Jit* jit = jit::Jit::Current(); jit) {
+            if (auto result = jit->TryCall(*this, method, actual_args, context); result) {
+                return *result;
+            }
+        }
+        Hooks::ClosureCreated();
+        Closure closure;
+        for (size_t i = 0; i < actual_args.size(); ++i) {
+            closure.emplace(method.formal_params.at(i), actual_args.at(i));
+        }
+        closure.emplace("self"s, ObjectHolder::Share(*this));
+        return method.body->Execute(closure, context);
+    }
+
     bool ClassInstance::HasMethod(const string& method, size_t argument_count) const {
         const Method* ptr_method = cls_.GetMethod(method);
         return ptr_method && ptr_method->formal_params.size() == argument_count;
     }
 
+    const Class& ClassInstance::GetClass() const {
+        return cls_;
+    }
+
     Closure& ClassInstance::Fields() {
         return closure_;
     }
@@ -132,6 +275,36 @@ namespace runtime {
         return closure_;
     }
 
+    void ClassInstance::SetField(const std::string& name, ObjectHolder value) {
+        auto [it, inserted] = closure_.try_emplace(name, move(value));
+        if (!inserted) {
+            it->second = move(value);
+            return;
+        }
+        try {
+            // A hash node holds the entry and a link to the next node.
+            fields_charge_.Add(sizeof(Closure::value_type) + sizeof(void*) + HeapBytes(it->first));
+        }
+        catch (...) {
+            closure_.erase(it);
+            throw;
+        }
+    }
+
+    size_t ClassInstance::GetFieldBytes() const {
+        size_t bytes = closure_.bucket_count() * sizeof(void*);
+        for (const auto& [name, value] : closure_) {
+            bytes += sizeof(Closure::value_type) + sizeof(void*) + HeapBytes(name);
+        }
+        return bytes;
+    }
+
+    // ----------------------String-----------------------
+
+    size_t ExternalBytes(const String& object) {
+        return HeapBytes(object.GetValue());
+    }
+
     // ----------------------Predicate-----------------------
 
 #define COMPARE(type, lhs, rhs, sign)                                                    \
@@ -1,9 +1,22 @@
 #pragma once
 
+#include "arena.h"
+#include "budget.h"
+#include "format.h"
+#include "gc.h"
+#include "heap.h"
+#include "quota.h"
+#include "slab.h"
+#include "stats.h"
+
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -15,26 +28,78 @@ namespace runtime {
     public:
         virtual std::ostream& GetOutputStream() = 0;
 
+        virtual void                                 Write(std::string_view data);
+
+        void                                         SetBudget(ExecutionBudget* budget);
+
+        [[nodiscard]] ExecutionBudget* GetBudget() const;
+
+        void                                         ChargeStep();
+
+        void                                         SetMemoryAccount(MemoryAccount* account);
+
+        [[nodiscard]] MemoryAccount* GetMemoryAccount() const;
+
+        void                                         SetStats(Stats* stats);
+
+        [[nodiscard]] Stats* GetStats() const;
+
     protected:
         ~Context() = default;
+
+    private:
+        ExecutionBudget* budget_ = nullptr;
+        MemoryAccount* memory_account_ = nullptr;
+        Stats* stats_ = nullptr;
     };
 
+    inline void Context::ChargeStep() {
+        if (budget_) {
+            budget_->Charge();
+        }
+    }
+
     // ----------------------Object-----------------------
-    class Object {
+    class Object : public std::enable_shared_from_this<Object> {
     public:
         virtual                                      ~Object() = default;
 
         virtual void                                 Print(std::ostream& os, Context& context) = 0;
+
+        virtual void                                 FormatTo(std::string& buffer, Context& context);
     };
 
+    class ClassInstance;
+
+    // ----------------------IsSlabAllocated-----------------------
+
+    template <typename T>
+    struct IsSlabAllocated : std::false_type {};
+
+    // ----------------------ExternalBytes-----------------------
+
+    // Bytes an object owns outside of its own allocation, charged to the memory account with it.
+    template <typename T>
+    size_t ExternalBytes(const T&) {
+        return 0;
+    }
+
     // ----------------------ObjectHolder-----------------------
     class ObjectHolder {
     public:
         ObjectHolder() = default;
 
+        ObjectHolder(const ObjectHolder& other);
+        ObjectHolder& operator=(const ObjectHolder& other);
+
+        ObjectHolder(ObjectHolder&& other) noexcept = default;
+        ObjectHolder& operator=(ObjectHolder&& other) noexcept = default;
+
         template <typename T>
         [[nodiscard]] static ObjectHolder             Own(T&& object);
 
+        // A holder that does not own object, or, while a CycleCollector is bound to the thread
+        // and object is already owned, one more owning reference to it.
         [[nodiscard]] static ObjectHolder             Share(Object& object);
 
         [[nodiscard]] static ObjectHolder             None();
@@ -51,16 +116,69 @@ namespace runtime {
         explicit                                      operator bool() const;
 
     private:
+        friend class CycleCollector;
+        friend class HeapProfiler;
+
         explicit                                      ObjectHolder(std::shared_ptr<Object> data);
 
+        template <typename T>
+        [[nodiscard]] static std::shared_ptr<T>       Allocate(T&& object);
+
+        template <typename T, typename Allocator>
+        [[nodiscard]] static std::shared_ptr<T>       AllocateWith(const Allocator& allocator, T&& object);
+
         void                                          AssertIsValid() const;
 
         std::shared_ptr<Object>                       data_;
     };
 
+    inline ObjectHolder::ObjectHolder(const ObjectHolder& other)
+        : data_(other.data_) {
+        Hooks::HolderCopied();
+    }
+
+    inline ObjectHolder& ObjectHolder::operator=(const ObjectHolder& other) {
+        Hooks::HolderCopied();
+        data_ = other.data_;
+        return *this;
+    }
+
     template <typename T>
     ObjectHolder ObjectHolder::Own(T&& object) {
-        return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+        Hooks::ObjectAllocated(ObjectKindOf<std::decay_t<T>>::value);
+        ObjectHolder result(Allocate(std::forward<T>(object)));
+        if constexpr (std::is_same_v<T, ClassInstance>) {
+            if (CycleCollector* collector = CycleCollector::Current(); collector) {
+                collector->Track(result);
+            }
+        }
+        if (HeapProfiler* heap = HeapProfiler::Current(); heap) {
+            heap->Track(result, ObjectKindOf<std::decay_t<T>>::value);
+        }
+        return result;
+    }
+
+    template <typename T>
+    std::shared_ptr<T> ObjectHolder::Allocate(T&& object) {
+        if (Arena* arena = Arena::Current(); arena) {
+            return AllocateWith(ArenaAllocator<T>(*arena), std::forward<T>(object));
+        }
+        if constexpr (IsSlabAllocated<T>::value) {
+            return AllocateWith(SlabAllocator<T>(), std::forward<T>(object));
+        }
+        else {
+            return AllocateWith(std::allocator<T>(), std::forward<T>(object));
+        }
+    }
+
+    template <typename T, typename Allocator>
+    std::shared_ptr<T> ObjectHolder::AllocateWith(const Allocator& allocator, T&& object) {
+        if (MemoryAccount* account = MemoryAccount::Current(); account) {
+            const size_t extra_bytes = ExternalBytes(object);
+            return std::allocate_shared<T>(AccountingAllocator<T, Allocator>(*account, allocator, extra_bytes),
+                std::forward<T>(object));
+        }
+        return std::allocate_shared<T>(allocator, std::forward<T>(object));
     }
 
     template <typename T>
@@ -76,6 +194,8 @@ namespace runtime {
 
         void                                          Print(std::ostream& os, Context& context) override;
 
+        void                                          FormatTo(std::string& buffer, Context& context) override;
+
         [[nodiscard]] const T& GetValue() const;
 
     private:
@@ -87,8 +207,28 @@ namespace runtime {
         : value_(v) {}
 
     template <typename T>
-    void ValueObject<T>::Print(std::ostream& os, [[maybe_unused]] Context& context) {
-        os << value_;
+    void ValueObject<T>::Print(std::ostream& os, Context& context) {
+        std::string buffer;
+        FormatTo(buffer, context);
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    template <typename T>
+    void ValueObject<T>::FormatTo(std::string& buffer, [[maybe_unused]] Context& context) {
+        if constexpr (std::is_same_v<T, int>) {
+            FormatInt(buffer, value_);
+        }
+        else if constexpr (std::is_same_v<T, bool>) {
+            FormatBool(buffer, value_);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            FormatString(buffer, value_);
+        }
+        else {
+            std::ostringstream os;
+            os << value_;
+            buffer += os.str();
+        }
     }
 
     template <typename T>
@@ -104,17 +244,49 @@ namespace runtime {
 
     bool IsTrue(const ObjectHolder& object);
 
+    // ----------------------PrintArgument-----------------------
+
+    // Writes one argument of a print statement followed by a space, or by a newline after the
+    // last one, and returns the bytes written. Each argument must be written before the next
+    // is evaluated: evaluating or formatting it may run Mython code that prints as well.
+    size_t PrintArgument(const ObjectHolder& object, bool last, Context& context);
+
+    // ----------------------SourcePosition-----------------------
+
+    // Line and column of the first token of a statement, counted from 1; zero when unknown.
+    struct SourcePosition {
+        uint32_t                                       line = 0;
+        uint32_t                                       column = 0;
+    };
+
     // ----------------------Executable-----------------------
     class Executable {
     public:
         virtual                                        ~Executable() = default;
         virtual ObjectHolder                           Execute(Closure& closure, Context& context) = 0;
+
+        void                                           SetPosition(SourcePosition position);
+
+        [[nodiscard]] SourcePosition                   GetPosition() const;
+
+    private:
+        SourcePosition                                 position_;
     };
 
+    inline void Executable::SetPosition(SourcePosition position) {
+        position_ = position;
+    }
+
+    inline SourcePosition Executable::GetPosition() const {
+        return position_;
+    }
+
     // ----------------------String-----------------------
 
     using String = ValueObject<std::string>;
 
+    size_t ExternalBytes(const String& object);
+
     // ----------------------Number-----------------------
 
     using Number = ValueObject<int>;
@@ -123,8 +295,27 @@ namespace runtime {
     class Bool : public ValueObject<bool> {
     public:
         using ValueObject<bool>::ValueObject;
+    };
 
-        void                                           Print(std::ostream& os, Context& context) override;
+    template <>
+    struct IsSlabAllocated<Number> : std::true_type {};
+
+    template <>
+    struct IsSlabAllocated<Bool> : std::true_type {};
+
+    template <>
+    struct ObjectKindOf<Number> {
+        static constexpr ObjectKind value = ObjectKind::NUMBER;
+    };
+
+    template <>
+    struct ObjectKindOf<String> {
+        static constexpr ObjectKind value = ObjectKind::STRING;
+    };
+
+    template <>
+    struct ObjectKindOf<Bool> {
+        static constexpr ObjectKind value = ObjectKind::BOOL;
     };
 
     // ----------------------Method-----------------------
@@ -145,8 +336,22 @@ namespace runtime {
 
         const std::string& GetName() const;
 
+        [[nodiscard]] const std::vector<Method>& GetMethods() const;
+
+        [[nodiscard]] const Class* GetParent() const;
+
+        // The class that declares method: this one or, for an inherited method, an ancestor.
+        // This class when method belongs to none of them.
+        [[nodiscard]] const Class& GetDeclaringClass(const Method& method) const;
+
+        // Reorders the methods, heaviest first, so that they are found sooner. Only allowed
+        // before anything holds a pointer to a method of the class.
+        void                                           OrderMethods(const std::function<uint64_t(const Method&)>& weight);
+
         void                                           Print(std::ostream& os, Context& context) override;
 
+        void                                           FormatTo(std::string& buffer, Context& context) override;
+
     private:
         std::string                                    name_;
         std::vector<Method>                            methods_;
@@ -160,19 +365,53 @@ namespace runtime {
 
         void                                           Print(std::ostream& os, Context& context) override;
 
+        void                                           FormatTo(std::string& buffer, Context& context) override;
+
         ObjectHolder                                   Call(const std::string& method,
             const std::vector<ObjectHolder>& actual_args,
             Context& context);
 
+        // Calls a method already resolved on this instance's class, with a matching arity.
+        ObjectHolder                                   Call(const Method& method,
+            const std::vector<ObjectHolder>& actual_args,
+            Context& context);
+
         [[nodiscard]] bool                             HasMethod(const std::string& method, size_t argument_count) const;
 
+        [[nodiscard]] const Class& GetClass() const;
+
         [[nodiscard]] Closure& Fields();
 
         [[nodiscard]] const Closure& Fields() const;
 
+        // Assigns a field, charging a newly created entry to the current memory account.
+        void                                           SetField(const std::string& name, ObjectHolder value);
+
+        // Bytes held by the field map: every entry as SetField charges it, plus the bucket array,
+        // which SetField never charges to the memory account.
+        [[nodiscard]] size_t                           GetFieldBytes() const;
+
     private:
+        ObjectHolder                                   Invoke(const Method& method,
+            const std::vector<ObjectHolder>& actual_args,
+            Context& context);
+
         const Class& cls_;
         Closure                                        closure_;
+        MemoryCharge                                   fields_charge_;
+    };
+
+    template <>
+    struct IsSlabAllocated<ClassInstance> : std::true_type {};
+
+    template <>
+    struct ObjectKindOf<Class> {
+        static constexpr ObjectKind value = ObjectKind::CLASS;
+    };
+
+    template <>
+    struct ObjectKindOf<ClassInstance> {
+        static constexpr ObjectKind value = ObjectKind::INSTANCE;
     };
 
     // ----------------------Predicate-----------------------
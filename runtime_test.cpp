@@ -71,6 +71,38 @@ void TestString() {
     ASSERT_EQUAL(word.GetValue(), "hello!"s);
 }
 
+void TestFormatTo() {
+    DummyContext context;
+
+    string buffer;
+    Number(-2147483647 - 1).FormatTo(buffer, context);
+    buffer += ' ';
+    Number(0).FormatTo(buffer, context);
+    buffer += ' ';
+    Bool(true).FormatTo(buffer, context);
+    buffer += ' ';
+    Bool(false).FormatTo(buffer, context);
+    buffer += ' ';
+    String("text"s).FormatTo(buffer, context);
+    ASSERT_EQUAL(buffer, "-2147483648 0 True False text"s);
+
+    Class cls("Empty"s, {}, nullptr);
+    ClassInstance instance(cls);
+    ostringstream expected;
+    expected << "Class Empty "sv << &instance;
+
+    buffer.clear();
+    cls.FormatTo(buffer, context);
+    buffer += ' ';
+    instance.FormatTo(buffer, context);
+    ASSERT_EQUAL(buffer, expected.str());
+
+    cls.Print(context.output, context);
+    context.output << ' ';
+    instance.Print(context.output, context);
+    ASSERT_EQUAL(context.output.str(), expected.str());
+}
+
 struct TestMethodBody : Executable {
     using Fn = std::function<ObjectHolder(Closure& closure, Context& context)>;
     Fn body;
@@ -159,6 +191,10 @@ void TestMethodInvocation() {
 
     ASSERT(!child_inst.HasMethod("test"s, 1U));
     ASSERT_THROWS(child_inst.Call("test"s, {ObjectHolder::None()}, context), runtime_error);
+
+    ASSERT_EQUAL(&child_class.GetDeclaringClass(*child_class.GetMethod("test"s)), &child_class);
+    ASSERT_EQUAL(&child_class.GetDeclaringClass(*child_class.GetMethod("test_2"s)), &base_class);
+    ASSERT_EQUAL(&base_class.GetDeclaringClass(*child_class.GetMethod("test"s)), &base_class);
 }
 
 void TestNonowning() {
@@ -234,14 +270,15 @@ void TestNullptr() {
 void RunObjectsTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestNumber);
     RUN_TEST(tr, runtime::TestString);
+    RUN_TEST(tr, runtime::TestFormatTo);
     RUN_TEST(tr, runtime::TestMethodInvocation);
 }
 
 void RunObjectHolderTests(TestRunner& tr) {
-    RUN_TEST(tr, runtime::TestNonowning);
-    RUN_TEST(tr, runtime::TestOwning);
-    RUN_TEST(tr, runtime::TestMove);
-    RUN_TEST(tr, runtime::TestNullptr);
+    RUN_BENCH(tr, runtime::TestNonowning);
+    RUN_BENCH(tr, runtime::TestOwning);
+    RUN_BENCH(tr, runtime::TestMove);
+    RUN_BENCH(tr, runtime::TestNullptr);
 }
 
 }  // namespace runtime
\ No newline at end of file
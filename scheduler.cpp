@@ -0,0 +1,120 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <exception>
+
+using namespace std;
+
+namespace runtime {
+
+    // ----------------------Scheduler-----------------------
+
+    Scheduler::Scheduler(size_t thread_count, size_t time_slice)
+        : time_slice_(max<size_t>(time_slice, 1)) {
+        thread_count = max<size_t>(thread_count, 1);
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers_.emplace_back([this, i] {
+                WorkerLoop(i);
+            });
+        }
+    }
+
+    Scheduler::~Scheduler() {
+        {
+            lock_guard guard(lock_);
+            stopping_ = true;
+        }
+        ready_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    future<JobResult> Scheduler::Submit(Job job) {
+        auto task = make_unique<Task>();
+        task->job = move(job);
+        task->enqueued = chrono::steady_clock::now();
+        future<JobResult> result = task->promise.get_future();
+        {
+            lock_guard guard(lock_);
+            ready_.push_back(move(task));
+        }
+        submitted_.fetch_add(1, memory_order_relaxed);
+        ready_cv_.notify_one();
+        return result;
+    }
+
+    size_t Scheduler::GetThreadCount() const {
+        return workers_.size();
+    }
+
+    SchedulerStats Scheduler::GetStats() const {
+        return {submitted_.load(memory_order_relaxed), completed_.load(memory_order_relaxed),
+                slices_.load(memory_order_relaxed), preemptions_.load(memory_order_relaxed)};
+    }
+
+    void Scheduler::WorkerLoop(size_t index) {
+        while (true) {
+            unique_ptr<Task> task;
+            {
+                unique_lock guard(lock_);
+                ready_cv_.wait(guard, [this] {
+                    return stopping_ || !ready_.empty();
+                });
+                if (ready_.empty()) {
+                    return;
+                }
+                task = move(ready_.front());
+                ready_.pop_front();
+            }
+
+            slices_.fetch_add(1, memory_order_relaxed);
+            if (!RunSlice(*task, index)) {
+                preemptions_.fetch_add(1, memory_order_relaxed);
+                {
+                    lock_guard guard(lock_);
+                    ready_.push_back(move(task));
+                }
+                ready_cv_.notify_one();
+                continue;
+            }
+
+            if (!task->job.output) {
+                task->result.output = task->captured.str();
+            }
+            completed_.fetch_add(1, memory_order_relaxed);
+            task->promise.set_value(move(task->result));
+        }
+    }
+
+    bool Scheduler::RunSlice(Task& task, size_t worker) {
+        JobResult& result = task.result;
+        const auto started = chrono::steady_clock::now();
+        if (!task.interpreter) {
+            result.queue_time = chrono::duration_cast<chrono::nanoseconds>(started - task.enqueued);
+            result.globals = move(task.job.inputs);
+            task.context = make_unique<SimpleContext>(task.job.output ? *task.job.output : task.captured);
+            task.context->SetBudget(&task.job.budget);
+            task.memory = make_unique<MemoryAccount>(task.job.memory_quota);
+            task.context->SetMemoryAccount(task.memory.get());
+            task.interpreter = make_unique<vm::Interpreter>(task.job.program->GetModule(), result.globals, *task.context);
+        }
+        result.worker = worker;
+
+        bool finished = true;
+        try {
+            finished = task.interpreter->Resume(time_slice_) == vm::Status::FINISHED;
+            result.ok = finished;
+        }
+        catch (const exception& e) {
+            result.error = e.what();
+        }
+        catch (...) {
+            result.error = "Unknown exception"s;
+        }
+        result.run_time += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started);
+        result.peak_memory_bytes = task.memory->GetPeakBytes();
+        return finished;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "executor.h"
+#include "vm.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+    // ----------------------SchedulerStats-----------------------
+
+    struct SchedulerStats {
+        size_t                                         submitted = 0;
+        size_t                                         completed = 0;
+        size_t                                         slices = 0;
+        size_t                                         preemptions = 0;
+    };
+
+    // ----------------------Scheduler-----------------------
+
+    // Runs many scripts over a few threads. Each job is executed by a stackless vm::Interpreter
+    // for at most time_slice safe points, then put back at the end of the run queue, so a
+    // long-running script cannot hold a thread while short ones wait behind it.
+    class Scheduler {
+    public:
+        static constexpr size_t                        DEFAULT_TIME_SLICE = 1000;
+
+        explicit                                       Scheduler(size_t thread_count = std::thread::hardware_concurrency(),
+                                                                 size_t time_slice = DEFAULT_TIME_SLICE);
+
+        Scheduler(const Scheduler&) = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+
+        ~Scheduler();
+
+        [[nodiscard]] std::future<JobResult>           Submit(Job job);
+
+        [[nodiscard]] size_t                           GetThreadCount() const;
+
+        [[nodiscard]] SchedulerStats                   GetStats() const;
+
+    private:
+        struct Task {
+            Job                                        job;
+            std::promise<JobResult>                    promise;
+            JobResult                                  result;
+            std::ostringstream                         captured;
+            std::unique_ptr<MemoryAccount>             memory;
+            std::unique_ptr<SimpleContext>             context;
+            std::unique_ptr<vm::Interpreter>           interpreter;
+            std::chrono::steady_clock::time_point      enqueued;
+        };
+
+        void                                           WorkerLoop(size_t index);
+
+        bool                                           RunSlice(Task& task, size_t worker);
+
+        size_t                                         time_slice_;
+        std::vector<std::thread>                       workers_;
+        std::mutex                                     lock_;
+        std::condition_variable                        ready_cv_;
+        std::deque<std::unique_ptr<Task>>              ready_;
+        std::atomic<size_t>                            submitted_ = 0;
+        std::atomic<size_t>                            completed_ = 0;
+        std::atomic<size_t>                            slices_ = 0;
+        std::atomic<size_t>                            preemptions_ = 0;
+        bool                                           stopping_ = false;
+    };
+
+}  // namespace runtime
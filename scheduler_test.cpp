@@ -0,0 +1,85 @@
+#include "scheduler.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string COUNTDOWN_PROGRAM = R"(
+class Countdown:
+  def run(n):
+    if n == 0:
+      return 0
+    return self.run(n - 1) + 1
+
+c = Countdown()
+print name, c.run(n)
+)"s;
+
+Job MakeJob(shared_ptr<const Program> program, const string& name, int n) {
+    Job job{move(program), {}, nullptr};
+    job.inputs["name"s] = ObjectHolder::Own(String(name));
+    job.inputs["n"s] = ObjectHolder::Own(Number(n));
+    return job;
+}
+
+void TestSchedulerRunsManyScripts() {
+    auto program = CompileFromString(COUNTDOWN_PROGRAM);
+    Scheduler scheduler(4, 16);
+    vector<future<JobResult>> results;
+    for (int i = 0; i < 2000; ++i) {
+        results.push_back(scheduler.Submit(MakeJob(program, "job"s + to_string(i), i % 50)));
+    }
+    for (int i = 0; i < 2000; ++i) {
+        JobResult result = results[i].get();
+        ASSERT(result.ok);
+        ASSERT_EQUAL(result.output, "job"s + to_string(i) + " "s + to_string(i % 50) + "\n"s);
+        ASSERT(result.worker < scheduler.GetThreadCount());
+    }
+    const auto stats = scheduler.GetStats();
+    ASSERT_EQUAL(stats.submitted, 2000U);
+    ASSERT_EQUAL(stats.completed, 2000U);
+    ASSERT(stats.preemptions > 0);
+    ASSERT_EQUAL(stats.slices, stats.completed + stats.preemptions);
+}
+
+void TestLongScriptDoesNotBlockShortOnes() {
+    auto program = CompileFromString(COUNTDOWN_PROGRAM);
+    Scheduler scheduler(1, 100);
+    auto long_running = scheduler.Submit(MakeJob(program, "long"s, 100000));
+    vector<future<JobResult>> short_ones;
+    for (int i = 0; i < 100; ++i) {
+        short_ones.push_back(scheduler.Submit(MakeJob(program, "short"s, 1)));
+    }
+    for (auto& result : short_ones) {
+        ASSERT(result.get().ok);
+    }
+    ASSERT(long_running.wait_for(chrono::seconds(0)) != future_status::ready);
+    JobResult result = long_running.get();
+    ASSERT(result.ok);
+    ASSERT_EQUAL(result.output, "long 100000\n"s);
+}
+
+void TestSchedulerReportsErrors() {
+    Scheduler scheduler(2);
+    auto failing = scheduler.Submit({CompileFromString("print 1 / 0\n"s), {}, nullptr});
+    auto missing = scheduler.Submit({CompileFromString("print undefined\n"s), {}, nullptr});
+
+    JobResult result = failing.get();
+    ASSERT(!result.ok);
+    ASSERT_EQUAL(result.error, "The denominator is zero"s);
+    ASSERT(!missing.get().ok);
+}
+
+}  // namespace
+
+void RunSchedulerTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestSchedulerRunsManyScripts);
+    RUN_TEST(tr, runtime::TestLongScriptDoesNotBlockShortOnes);
+    RUN_TEST(tr, runtime::TestSchedulerReportsErrors);
+}
+
+}  // namespace runtime
@@ -0,0 +1,433 @@
+#include "sealed_ast.h"
+
+#include "jit.h"
+#include "statement.h"
+
+using namespace std;
+
+namespace sealed {
+
+    using runtime::Closure;
+    using runtime::Context;
+    using runtime::IsTrue;
+    using runtime::ObjectHolder;
+
+    namespace {
+        const string ADD_METHOD = "__add__"s;
+        const string INIT_METHOD = "__init__"s;
+        const string SELF = "self"s;
+
+        NodePtr Wrap(Node node) {
+            return make_unique<Node>(move(node));
+        }
+    }  // namespace
+
+    // ----------------------Converter-----------------------
+
+    class Converter {
+    public:
+        explicit Converter(Tree& tree)
+            : tree_(tree) {}
+
+        Node Convert(runtime::Executable& statement) {
+            if (auto node = dynamic_cast<ast::NumericConst*>(&statement); node) {
+                return {Constant{node->GetValue()}};
+            }
+            if (auto node = dynamic_cast<ast::StringConst*>(&statement); node) {
+                return {Constant{node->GetValue()}};
+            }
+            if (auto node = dynamic_cast<ast::BoolConst*>(&statement); node) {
+                return {Constant{node->GetValue()}};
+            }
+            if (auto node = dynamic_cast<ast::VariableValue*>(&statement); node) {
+                return {Variable{node->GetDottedIds()}};
+            }
+            if (auto node = dynamic_cast<ast::Assignment*>(&statement); node) {
+                return {Assignment{node->GetName(), ConvertPtr(node->GetValue())}};
+            }
+            if (auto node = dynamic_cast<ast::FieldAssignment*>(&statement); node) {
+                return {FieldAssignment{Variable{node->GetObject().GetDottedIds()}, node->GetFieldName(),
+                    ConvertPtr(node->GetValue())}};
+            }
+            if (dynamic_cast<ast::None*>(&statement)) {
+                return {None{}};
+            }
+            if (auto node = dynamic_cast<ast::Print*>(&statement); node) {
+                return {Print{ConvertAll(node->GetArgs())}};
+            }
+            if (auto node = dynamic_cast<ast::MethodCall*>(&statement); node) {
+                return {MethodCall{ConvertPtr(node->GetObject()), node->GetMethod(), ConvertAll(node->GetArgs())}};
+            }
+            if (auto node = dynamic_cast<ast::NewInstance*>(&statement); node) {
+                ConvertClass(node->GetClass());
+                return {NewInstance{&node->GetClass(), ConvertAll(node->GetArgs())}};
+            }
+            if (auto node = dynamic_cast<ast::Stringify*>(&statement); node) {
+                return {Stringify{ConvertPtr(node->GetArgument())}};
+            }
+            if (auto node = dynamic_cast<ast::Not*>(&statement); node) {
+                return {Not{ConvertPtr(node->GetArgument())}};
+            }
+            if (auto node = dynamic_cast<ast::Add*>(&statement); node) {
+                return ConvertBinary<Add>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Sub*>(&statement); node) {
+                return ConvertBinary<Sub>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Mult*>(&statement); node) {
+                return ConvertBinary<Mult>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Div*>(&statement); node) {
+                return ConvertBinary<Div>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Or*>(&statement); node) {
+                return ConvertBinary<Or>(*node);
+            }
+            if (auto node = dynamic_cast<ast::And*>(&statement); node) {
+                return ConvertBinary<And>(*node);
+            }
+            if (auto node = dynamic_cast<ast::Comparison*>(&statement); node) {
+                return {Comparison{node->GetComparator(), ConvertPtr(node->GetLhs()), ConvertPtr(node->GetRhs())}};
+            }
+            if (auto node = dynamic_cast<ast::Compound*>(&statement); node) {
+                return {Compound{ConvertAll(node->GetStatements())}};
+            }
+            if (auto node = dynamic_cast<ast::MethodBody*>(&statement); node) {
+                return {MethodBody{ConvertPtr(node->GetBody())}};
+            }
+            if (auto node = dynamic_cast<ast::Return*>(&statement); node) {
+                return {Return{ConvertPtr(node->GetStatement())}};
+            }
+            if (auto node = dynamic_cast<ast::ClassDefinition*>(&statement); node) {
+                ConvertClass(*node->GetClass().TryAs<runtime::Class>());
+                return {ClassDefinition{node->GetClass()}};
+            }
+            if (auto node = dynamic_cast<ast::IfElse*>(&statement); node) {
+                return {IfElse{ConvertPtr(node->GetCondition()), ConvertPtr(node->GetIfBody()),
+                    node->GetElseBody() ? ConvertPtr(node->GetElseBody()) : nullptr}};
+            }
+            return {Native{&statement}};
+        }
+
+    private:
+        void ConvertClass(const runtime::Class& cls) {
+            for (const auto& method : cls.GetMethods()) {
+                if (tree_.methods_.count(&method)) {
+                    continue;
+                }
+                Node& body = tree_.methods_[&method];
+                body = Convert(*method.body);
+            }
+            if (cls.GetParent()) {
+                ConvertClass(*cls.GetParent());
+            }
+        }
+
+        NodePtr ConvertPtr(runtime::Executable* statement) {
+            return Wrap(Convert(*statement));
+        }
+
+        vector<Node> ConvertAll(const vector<unique_ptr<ast::Statement>>& statements) {
+            vector<Node> result;
+            result.reserve(statements.size());
+            for (const auto& statement : statements) {
+                result.push_back(Convert(*statement));
+            }
+            return result;
+        }
+
+        template <typename T>
+        Node ConvertBinary(const ast::BinaryOperation& node) {
+            return {T{ConvertPtr(node.GetLhs()), ConvertPtr(node.GetRhs())}};
+        }
+
+        Tree& tree_;
+    };
+
+    // ----------------------Evaluator-----------------------
+
+    namespace {
+
+        class Evaluator {
+        public:
+            Evaluator(const Tree& tree, Closure& closure, Context& context, bool in_method)
+                : tree_(tree)
+                , closure_(closure)
+                , context_(context)
+                , in_method_(in_method) {}
+
+            ObjectHolder Evaluate(const Node& node) {
+                return visit(*this, node.value);
+            }
+
+            ObjectHolder operator()(const Constant& node) {
+                return node.value;
+            }
+
+            ObjectHolder operator()(const Variable& node) {
+                const Closure* scope = &closure_;
+                for (size_t i = 0; i < node.dotted_ids.size(); ++i) {
+                    const string& field_name = node.dotted_ids[i];
+                    auto it = scope->find(field_name);
+                    if (it == scope->end()) {
+                        throw runtime_error("Not field"s + field_name);
+                    }
+                    if (i == node.dotted_ids.size() - 1) {
+                        return it->second;
+                    }
+                    auto ptr_obj = it->second.TryAs<runtime::ClassInstance>();
+                    if (!ptr_obj) {
+                        throw runtime_error("This isn't object"s);
+                    }
+                    scope = &ptr_obj->Fields();
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const Assignment& node) {
+                return closure_[node.name] = Evaluate(*node.value);
+            }
+
+            ObjectHolder operator()(const FieldAssignment& node) {
+                ObjectHolder object = (*this)(node.object);
+                if (auto ptr_obj = object.TryAs<runtime::ClassInstance>(); ptr_obj) {
+                    ObjectHolder value = Evaluate(*node.value);
+                    ptr_obj->SetField(node.field_name, value);
+                    return value;
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const None& /*node*/) {
+                return {};
+            }
+
+            ObjectHolder operator()(const Print& node) {
+                for (size_t i = 0; i < node.args.size(); ++i) {
+                    runtime::PrintArgument(Evaluate(node.args[i]), i + 1 == node.args.size(), context_);
+                }
+                if (node.args.empty()) {
+                    context_.Write("\n"sv);
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const MethodCall& node) {
+                ObjectHolder object = Evaluate(*node.object);
+                if (auto ptr_obj = object.TryAs<runtime::ClassInstance>(); ptr_obj) {
+                    return tree_.Call(*ptr_obj, node.method, EvaluateAll(node.args), context_);
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const NewInstance& node) {
+                ObjectHolder instance = ObjectHolder::Own(runtime::ClassInstance(*node.cls));
+                auto ptr_instance = instance.TryAs<runtime::ClassInstance>();
+                if (ptr_instance->HasMethod(INIT_METHOD, node.args.size())) {
+                    tree_.Call(*ptr_instance, INIT_METHOD, EvaluateAll(node.args), context_);
+                }
+                return instance;
+            }
+
+            ObjectHolder operator()(const Stringify& node) {
+                ObjectHolder obj = Evaluate(*node.argument);
+                if (obj) {
+                    string buffer;
+                    obj->FormatTo(buffer, context_);
+                    return ObjectHolder::Own(runtime::String(move(buffer)));
+                }
+                return ObjectHolder::Own(runtime::String("None"s));
+            }
+
+            ObjectHolder operator()(const Not& node) {
+                return ObjectHolder::Own(runtime::Bool(!IsTrue(Evaluate(*node.argument))));
+            }
+
+            ObjectHolder operator()(const Add& node) {
+                ObjectHolder lhs = Evaluate(*node.lhs);
+                ObjectHolder rhs = Evaluate(*node.rhs);
+                if (auto result = Arithmetic<runtime::Number>(lhs, rhs, plus<int>()); result) {
+                    return result;
+                }
+                if (auto result = Arithmetic<runtime::String>(lhs, rhs, plus<string>()); result) {
+                    return result;
+                }
+                if (auto ptr = lhs.TryAs<runtime::ClassInstance>(); ptr) {
+                    return tree_.Call(*ptr, ADD_METHOD, {rhs}, context_);
+                }
+                throw runtime_error("The operator is not overloaded +"s);
+            }
+
+            ObjectHolder operator()(const Sub& node) {
+                ObjectHolder lhs = Evaluate(*node.lhs);
+                ObjectHolder rhs = Evaluate(*node.rhs);
+                if (auto result = Arithmetic<runtime::Number>(lhs, rhs, minus<int>()); result) {
+                    return result;
+                }
+                throw runtime_error("The operator is not overloaded -"s);
+            }
+
+            ObjectHolder operator()(const Mult& node) {
+                ObjectHolder lhs = Evaluate(*node.lhs);
+                ObjectHolder rhs = Evaluate(*node.rhs);
+                if (auto result = Arithmetic<runtime::Number>(lhs, rhs, multiplies<int>()); result) {
+                    return result;
+                }
+                throw runtime_error("The operator is not overloaded *"s);
+            }
+
+            ObjectHolder operator()(const Div& node) {
+                ObjectHolder lhs = Evaluate(*node.lhs);
+                ObjectHolder rhs = Evaluate(*node.rhs);
+                const auto ptr_left = lhs.TryAs<runtime::Number>();
+                const auto ptr_right = rhs.TryAs<runtime::Number>();
+                if (ptr_left && ptr_right) {
+                    if (ptr_right->GetValue() != 0) {
+                        return ObjectHolder::Own(runtime::Number(ptr_left->GetValue() / ptr_right->GetValue()));
+                    }
+                    throw runtime_error("The denominator is zero"s);
+                }
+                throw runtime_error("The operator is not overloaded /"s);
+            }
+
+            ObjectHolder operator()(const Or& node) {
+                if (!IsTrue(Evaluate(*node.lhs))) {
+                    return ObjectHolder::Own(runtime::Bool(IsTrue(Evaluate(*node.rhs))));
+                }
+                return ObjectHolder::Own(runtime::Bool(true));
+            }
+
+            ObjectHolder operator()(const And& node) {
+                if (IsTrue(Evaluate(*node.lhs))) {
+                    return ObjectHolder::Own(runtime::Bool(IsTrue(Evaluate(*node.rhs))));
+                }
+                return ObjectHolder::Own(runtime::Bool(false));
+            }
+
+            ObjectHolder operator()(const Comparison& node) {
+                ObjectHolder lhs = Evaluate(*node.lhs);
+                ObjectHolder rhs = Evaluate(*node.rhs);
+                return ObjectHolder::Own(runtime::Bool(node.comparator(lhs, rhs, context_)));
+            }
+
+            ObjectHolder operator()(const Compound& node) {
+                for (const Node& statement : node.statements) {
+                    context_.ChargeStep();
+                    runtime::CycleCollector::AtSafePoint();
+                    Evaluate(statement);
+                    if (returning_) {
+                        break;
+                    }
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const MethodBody& node) {
+                Evaluate(*node.body);
+                if (returning_) {
+                    returning_ = false;
+                    return move(result_);
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const Return& node) {
+                ObjectHolder value = Evaluate(*node.value);
+                if (!in_method_) {
+                    throw value;
+                }
+                result_ = move(value);
+                returning_ = true;
+                return {};
+            }
+
+            ObjectHolder operator()(const ClassDefinition& node) {
+                return closure_[node.cls.TryAs<runtime::Class>()->GetName()] = node.cls;
+            }
+
+            ObjectHolder operator()(const IfElse& node) {
+                if (IsTrue(Evaluate(*node.condition))) {
+                    return Evaluate(*node.if_body);
+                }
+                if (node.else_body) {
+                    return Evaluate(*node.else_body);
+                }
+                return {};
+            }
+
+            ObjectHolder operator()(const Native& node) {
+                return node.statement->Execute(closure_, context_);
+            }
+
+        private:
+            template <typename T, typename Operation>
+            static ObjectHolder Arithmetic(const ObjectHolder& lhs, const ObjectHolder& rhs, Operation operation) {
+                const auto* left = lhs.TryAs<T>();
+                const auto* right = rhs.TryAs<T>();
+                if (left && right) {
+                    return ObjectHolder::Own(T(operation(left->GetValue(), right->GetValue())));
+                }
+                return {};
+            }
+
+            vector<ObjectHolder> EvaluateAll(const vector<Node>& nodes) {
+                vector<ObjectHolder> result;
+                result.reserve(nodes.size());
+                for (const Node& node : nodes) {
+                    result.push_back(Evaluate(node));
+                }
+                return result;
+            }
+
+            const Tree& tree_;
+            Closure& closure_;
+            Context& context_;
+            bool                                       in_method_;
+            bool                                       returning_ = false;
+            ObjectHolder                               result_;
+        };
+
+    }  // namespace
+
+    // ----------------------Tree-----------------------
+
+    Tree::Tree(runtime::Executable& program) {
+        root_ = Converter(*this).Convert(program);
+    }
+
+    ObjectHolder Tree::Evaluate(Closure& closure, Context& context) const {
+        runtime::MemoryAccount::Scope memory_scope(context.GetMemoryAccount());
+        return Evaluator(*this, closure, context, false).Evaluate(root_);
+    }
+
+    ObjectHolder Tree::Execute(Closure& closure, Context& context) {
+        return Evaluate(closure, context);
+    }
+
+    ObjectHolder Tree::Call(runtime::ClassInstance& self, const std::string& method,
+        const std::vector<ObjectHolder>& args, Context& context) const {
+        const runtime::Method* target = self.GetClass().GetMethod(method);
+        auto it = target && target->formal_params.size() == args.size() ? methods_.find(target) : methods_.end();
+        if (it == methods_.end()) {
+            return self.Call(method, args, context);
+        }
+
+        context.ChargeStep();
+        if (jit::Jit* jit = jit::Jit::Current(); jit) {
+            if (auto result = jit->TryCall(self, *target, args, context); result) {
+                return *result;
+            }
+        }
+        Closure closure;
+        for (size_t i = 0; i < args.size(); ++i) {
+            closure.emplace(target->formal_params[i], args[i]);
+        }
+        closure.emplace(SELF, ObjectHolder::Share(self));
+        return Evaluator(*this, closure, context, true).Evaluate(it->second);
+    }
+
+    const Node& Tree::GetRoot() const {
+        return root_;
+    }
+
+}  // namespace sealed
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// A closed representation of the statement tree. The node set of statement.h never changes, so
+// here every node is a plain struct and a Node is a std::variant of them: evaluation is a visit
+// the compiler lowers to a jump table and can inline into, instead of a virtual Execute call per
+// node. Child lists are stored by value, so the arguments of a call or the statements of a block
+// are contiguous in memory.
+namespace sealed {
+
+    struct Node;
+
+    using NodePtr = std::unique_ptr<Node>;
+
+    // ----------------------Nodes-----------------------
+
+    struct Constant {
+        runtime::ObjectHolder                          value;
+    };
+
+    struct Variable {
+        std::vector<std::string>                       dotted_ids;
+    };
+
+    struct Assignment {
+        std::string                                    name;
+        NodePtr                                        value;
+    };
+
+    struct FieldAssignment {
+        Variable                                       object;
+        std::string                                    field_name;
+        NodePtr                                        value;
+    };
+
+    struct None {};
+
+    struct Print {
+        std::vector<Node>                              args;
+    };
+
+    struct MethodCall {
+        NodePtr                                        object;
+        std::string                                    method;
+        std::vector<Node>                              args;
+    };
+
+    struct NewInstance {
+        const runtime::Class* cls;
+        std::vector<Node>                              args;
+    };
+
+    struct Stringify {
+        NodePtr                                        argument;
+    };
+
+    struct Not {
+        NodePtr                                        argument;
+    };
+
+    template <typename Tag>
+    struct BinaryOperation {
+        NodePtr                                        lhs;
+        NodePtr                                        rhs;
+    };
+
+    using Add = BinaryOperation<struct AddTag>;
+    using Sub = BinaryOperation<struct SubTag>;
+    using Mult = BinaryOperation<struct MultTag>;
+    using Div = BinaryOperation<struct DivTag>;
+    using Or = BinaryOperation<struct OrTag>;
+    using And = BinaryOperation<struct AndTag>;
+
+    struct Comparison {
+        std::function<bool(const runtime::ObjectHolder&, const runtime::ObjectHolder&, runtime::Context&)> comparator;
+        NodePtr                                        lhs;
+        NodePtr                                        rhs;
+    };
+
+    struct Compound {
+        std::vector<Node>                              statements;
+    };
+
+    struct MethodBody {
+        NodePtr                                        body;
+    };
+
+    struct Return {
+        NodePtr                                        value;
+    };
+
+    struct ClassDefinition {
+        runtime::ObjectHolder                          cls;
+    };
+
+    struct IfElse {
+        NodePtr                                        condition;
+        NodePtr                                        if_body;
+        NodePtr                                        else_body;
+    };
+
+    // A statement outside the closed set, executed through its own Execute.
+    struct Native {
+        runtime::Executable* statement;
+    };
+
+    // ----------------------Node-----------------------
+
+    struct Node {
+        std::variant<Constant, Variable, Assignment, FieldAssignment, None, Print, MethodCall, NewInstance, Stringify,
+                     Not, Add, Sub, Mult, Div, Or, And, Comparison, Compound, MethodBody, Return, ClassDefinition,
+                     IfElse, Native> value;
+    };
+
+    // ----------------------Tree-----------------------
+
+    // A program converted from the tree built by ParseProgram, along with the method bodies of
+    // the classes it uses. Calls made by sealed code to those methods evaluate their sealed
+    // bodies; methods invoked by the runtime itself (__str__, __eq__, __lt__) still run on the
+    // statement tree. Being an Executable, a Tree can stand in for the statement tree anywhere,
+    // which is how the tests run it. It is immutable after construction.
+    class Tree : public runtime::Executable {
+    public:
+        explicit                                       Tree(runtime::Executable& program);
+
+        runtime::ObjectHolder                          Evaluate(runtime::Closure& closure, runtime::Context& context) const;
+
+        runtime::ObjectHolder                          Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        runtime::ObjectHolder                          Call(runtime::ClassInstance& self, const std::string& method,
+                                                            const std::vector<runtime::ObjectHolder>& args,
+                                                            runtime::Context& context) const;
+
+        [[nodiscard]] const Node& GetRoot() const;
+
+    private:
+        friend class Converter;
+
+        Node                                           root_;
+        std::unordered_map<const runtime::Method*, Node> methods_;
+    };
+
+}  // namespace sealed
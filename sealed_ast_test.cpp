@@ -0,0 +1,47 @@
+#include "program.h"
+#include "sealed_ast.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace sealed {
+
+namespace {
+
+void TestMatchesStatementTree() {
+    AssertSampleMatchesTreeWalking(ExecutionMode::SEALED_TREE);
+}
+
+void TestPrintOrderMatchesStatementTree() {
+    AssertPrintOrderMatchesTreeWalking(ExecutionMode::SEALED_TREE);
+}
+
+void TestNodeStorage() {
+    auto program = ParseFromString("x = 1 + 2\nprint x, 'y'\n"s);
+    Tree tree(*program);
+    const auto& root = get<Compound>(tree.GetRoot().value);
+    ASSERT_EQUAL(root.statements.size(), 2u);
+    const auto& assignment = get<Assignment>(root.statements[0].value);
+    ASSERT_EQUAL(assignment.name, "x"s);
+    ASSERT(holds_alternative<Add>(assignment.value->value));
+    const auto& print = get<Print>(root.statements[1].value);
+    ASSERT_EQUAL(print.args.size(), 2u);
+    ASSERT(holds_alternative<Variable>(print.args[0].value));
+    ASSERT(holds_alternative<Constant>(print.args[1].value));
+}
+
+void TestErrorsMatchStatementTree() {
+    AssertErrorsMatchTreeWalking(ExecutionMode::SEALED_TREE);
+}
+
+}  // namespace
+
+void RunSealedAstTests(TestRunner& tr) {
+    RUN_TEST(tr, TestMatchesStatementTree);
+    RUN_TEST(tr, TestPrintOrderMatchesStatementTree);
+    RUN_TEST(tr, TestNodeStorage);
+    RUN_TEST(tr, TestErrorsMatchStatementTree);
+}
+
+}  // namespace sealed
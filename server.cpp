@@ -0,0 +1,482 @@
+#include "server.h"
+
+#include "jit.h"
+#include "lexer.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+
+using namespace std;
+
+namespace server {
+
+    namespace {
+
+        constexpr size_t MAX_HEADER_SIZE = 256;
+        constexpr size_t FRAME_SIZE = 4096;
+
+        [[noreturn]] void ThrowSystemError(const string& what) {
+            throw runtime_error(what + ": "s + strerror(errno));
+        }
+
+        sockaddr_un SocketAddress(const string& path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+                throw runtime_error("Invalid socket path: "s + path);
+            }
+            memcpy(address.sun_path, path.data(), path.size());
+            return address;
+        }
+
+        bool SendAll(int fd, string_view data) {
+            while (!data.empty()) {
+                const ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+                if (sent < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (sent <= 0) {
+                    return false;
+                }
+                data.remove_prefix(static_cast<size_t>(sent));
+            }
+            return true;
+        }
+
+        // Buffered reads from a socket, so that headers do not take a call per byte.
+        class SocketReader {
+        public:
+            explicit SocketReader(int fd)
+                : fd_(fd) {}
+
+            // A line up to '\n', without it; nothing on end of stream or an overlong line.
+            optional<string> ReadLine() {
+                string line;
+                while (line.size() <= MAX_HEADER_SIZE) {
+                    if (begin_ == end_ && !Fill()) {
+                        return nullopt;
+                    }
+                    const char c = buffer_[begin_++];
+                    if (c == '\n') {
+                        return line;
+                    }
+                    line += c;
+                }
+                return nullopt;
+            }
+
+            optional<string> Read(size_t size) {
+                string data;
+                data.reserve(size);
+                while (data.size() < size) {
+                    if (begin_ == end_ && !Fill()) {
+                        return nullopt;
+                    }
+                    const size_t count = min(size - data.size(), end_ - begin_);
+                    data.append(buffer_ + begin_, count);
+                    begin_ += count;
+                }
+                return data;
+            }
+
+        private:
+            bool Fill() {
+                while (true) {
+                    const ssize_t received = recv(fd_, buffer_, sizeof(buffer_), 0);
+                    if (received < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    begin_ = 0;
+                    end_ = received > 0 ? static_cast<size_t>(received) : 0;
+                    return received > 0;
+                }
+            }
+
+            int fd_;
+            char buffer_[FRAME_SIZE];
+            size_t begin_ = 0;
+            size_t end_ = 0;
+        };
+
+        string Frame(string_view tag, string_view payload) {
+            return string(tag) + ' ' + to_string(payload.size()) + '\n' + string(payload);
+        }
+
+        // Sends what is printed to a socket in output frames. Once the client has gone away,
+        // the rest of the output is dropped and the script runs to its end.
+        class FrameBuffer : public streambuf {
+        public:
+            explicit FrameBuffer(int fd)
+                : fd_(fd) {
+                setp(buffer_, buffer_ + FRAME_SIZE);
+            }
+
+            bool IsConnected() const {
+                return connected_;
+            }
+
+        protected:
+            int_type overflow(int_type c) override {
+                SendFrame();
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+
+            int sync() override {
+                SendFrame();
+                return 0;
+            }
+
+        private:
+            void SendFrame() {
+                const string_view data(pbase(), static_cast<size_t>(pptr() - pbase()));
+                if (!data.empty() && connected_) {
+                    connected_ = SendAll(fd_, Frame("output"sv, data));
+                }
+                setp(buffer_, buffer_ + FRAME_SIZE);
+            }
+
+            int fd_;
+            bool connected_ = true;
+            char buffer_[FRAME_SIZE];
+        };
+
+        string ReadScript(const string& path) {
+            ifstream file(path, ios::binary);
+            if (!file) {
+                throw runtime_error("Cannot open "s + path);
+            }
+            return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        }
+
+    }  // namespace
+
+    // ----------------------ProgramCache-----------------------
+
+    ProgramCache::ProgramCache(size_t capacity)
+        : capacity_(max<size_t>(capacity, 1)) {}
+
+    shared_ptr<const Program> ProgramCache::Get(const string& source) {
+        const uint64_t hash = parse::HashSource(source);
+        {
+            lock_guard guard(lock_);
+            if (auto it = index_.find(hash); it != index_.end() && it->second->source == source) {
+                entries_.splice(entries_.begin(), entries_, it->second);
+                ++stats_.hits;
+                return it->second->program;
+            }
+            ++stats_.misses;
+        }
+
+        istringstream input(source);
+        parse::Lexer lexer(input);
+        shared_ptr<const Program> program = CompileProgram(lexer);
+
+        lock_guard guard(lock_);
+        if (auto it = index_.find(hash); it != index_.end()) {
+            if (it->second->source == source) {
+                // Another thread compiled it meanwhile.
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return it->second->program;
+            }
+            // A different source with the same hash.
+            entries_.erase(it->second);
+            index_.erase(it);
+            ++stats_.evictions;
+        }
+        entries_.push_front(Entry{hash, source, program});
+        index_[hash] = entries_.begin();
+        if (entries_.size() > capacity_) {
+            index_.erase(entries_.back().hash);
+            entries_.pop_back();
+            ++stats_.evictions;
+        }
+        return program;
+    }
+
+    ProgramCacheStats ProgramCache::GetStats() const {
+        lock_guard guard(lock_);
+        ProgramCacheStats stats = stats_;
+        stats.size = entries_.size();
+        return stats;
+    }
+
+    // ----------------------Server-----------------------
+
+    Server::Server(ServerOptions options)
+        : options_(move(options))
+        , cache_(options_.cache_capacity) {
+        const sockaddr_un address = SocketAddress(options_.socket_path);
+        struct stat existing {};
+        if (lstat(options_.socket_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                throw runtime_error("Not a socket: "s + options_.socket_path);
+            }
+            unlink(options_.socket_path.c_str());
+        }
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            ThrowSystemError("socket"s);
+        }
+        if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+            || listen(listen_fd_, SOMAXCONN) < 0 || pipe2(wake_fds_, O_CLOEXEC) < 0) {
+            const int error = errno;
+            close(listen_fd_);
+            errno = error;
+            ThrowSystemError("Cannot listen on "s + options_.socket_path);
+        }
+        for (size_t i = 0; i < max<size_t>(options_.thread_count, 1); ++i) {
+            workers_.emplace_back([this] {
+                WorkerLoop();
+            });
+        }
+    }
+
+    Server::~Server() {
+        Stop();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        for (const int fd : connections_) {
+            close(fd);
+        }
+        close(listen_fd_);
+        close(wake_fds_[0]);
+        close(wake_fds_[1]);
+        unlink(options_.socket_path.c_str());
+    }
+
+    void Server::Run() {
+        pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+        while (true) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ThrowSystemError("poll"s);
+            }
+            if (fds[1].revents) {
+                return;
+            }
+            const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            if (options_.io_timeout.count() > 0) {
+                const auto milliseconds = options_.io_timeout.count();
+                const timeval timeout{static_cast<time_t>(milliseconds / 1000),
+                                      static_cast<suseconds_t>(milliseconds % 1000 * 1000)};
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            }
+            {
+                lock_guard guard(queue_lock_);
+                connections_.push_back(fd);
+            }
+            queue_cv_.notify_one();
+        }
+    }
+
+    void Server::Stop() {
+        {
+            lock_guard guard(queue_lock_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+        }
+        queue_cv_.notify_all();
+        const char wake = 0;
+        (void)!write(wake_fds_[1], &wake, 1);
+    }
+
+    ServerStats Server::GetStats() const {
+        return {requests_.load(memory_order_relaxed), failed_.load(memory_order_relaxed),
+                collected_.load(memory_order_relaxed)};
+    }
+
+    ProgramCacheStats Server::GetCacheStats() const {
+        return cache_.GetStats();
+    }
+
+    void Server::WorkerLoop() {
+        // Slab caches and the Jits of this thread stay warm from one request to the next.
+        WorkerJits jits;
+        while (true) {
+            int fd = -1;
+            {
+                unique_lock guard(queue_lock_);
+                queue_cv_.wait(guard, [this] {
+                    return stopping_ || !connections_.empty();
+                });
+                if (stopping_) {
+                    return;
+                }
+                fd = connections_.front();
+                connections_.pop_front();
+            }
+            try {
+                Serve(fd, jits);
+            } catch (const exception& e) {
+                failed_.fetch_add(1, memory_order_relaxed);
+                SendAll(fd, Frame("error"sv, e.what()));
+            }
+            close(fd);
+        }
+    }
+
+    void Server::Serve(int fd, WorkerJits& jits) {
+        requests_.fetch_add(1, memory_order_relaxed);
+        SocketReader reader(fd);
+        const optional<string> header = reader.ReadLine();
+        istringstream fields(header.value_or(""s));
+        string kind;
+        size_t length = 0;
+        size_t input_length = 0;
+        if (!(fields >> kind >> length >> input_length) || (kind != "source"s && kind != "path"s)) {
+            failed_.fetch_add(1, memory_order_relaxed);
+            SendAll(fd, Frame("error"sv, "Malformed request"sv));
+            return;
+        }
+        if (length > options_.max_request_bytes || input_length > options_.max_request_bytes - length) {
+            failed_.fetch_add(1, memory_order_relaxed);
+            SendAll(fd, Frame("error"sv, "Request too large"sv));
+            return;
+        }
+        const optional<string> script = reader.Read(length);
+        const optional<string> input = reader.Read(input_length);
+        if (!script || !input) {
+            failed_.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        FrameBuffer buffer(fd);
+        ostream output(&buffer);
+        runtime::SimpleContext context(output);
+        optional<runtime::ExecutionBudget> budget;
+        if (options_.timeout.count() > 0) {
+            budget = runtime::ExecutionBudget::WithTimeout(options_.timeout, options_.max_steps);
+        } else if (options_.max_steps != runtime::ExecutionBudget::UNLIMITED) {
+            budget.emplace(options_.max_steps);
+        }
+        if (budget) {
+            context.SetBudget(&*budget);
+        }
+        optional<runtime::MemoryAccount> memory;
+        if (options_.max_memory_bytes != runtime::MemoryAccount::UNLIMITED) {
+            context.SetMemoryAccount(&memory.emplace(options_.max_memory_bytes));
+        }
+        // The cycles a script leaves behind, such as self.me = self, die with its request instead
+        // of piling up in a daemon that never exits.
+        runtime::CycleCollector collector;
+        string error;
+        try {
+            shared_ptr<const Program> program = cache_.Get(kind == "path"s ? ReadScript(*script) : *script);
+            optional<jit::Jit::Scope> jit_scope;
+            if (options_.jit && !budget && options_.mode != ExecutionMode::STACKLESS) {
+                for (auto it = jits.begin(); it != jits.end();) {
+                    it = it->second.program.expired() ? jits.erase(it) : next(it);
+                }
+                WorkerJit& entry = jits[program.get()];
+                if (!entry.jit) {
+                    entry = {program, make_unique<jit::Jit>()};
+                }
+                jit_scope.emplace(*entry.jit);
+            }
+            runtime::CycleCollector::Scope collector_scope(collector);
+            runtime::Closure closure;
+            closure["stdin"s] = runtime::ObjectHolder::Own(runtime::String(*input));
+            program->Execute(closure, context, options_.mode);
+        } catch (const exception& e) {
+            error = e.what();
+        } catch (...) {
+            error = "Unknown exception"s;
+        }
+        // The closure is gone by now, so whatever the collector still tracks is only reachable
+        // through cycles.
+        collected_.fetch_add(collector.Collect(), memory_order_relaxed);
+        output.flush();
+        if (!error.empty()) {
+            failed_.fetch_add(1, memory_order_relaxed);
+        }
+        if (buffer.IsConnected()) {
+            SendAll(fd, error.empty() ? "done\n"s : Frame("error"sv, error));
+        }
+    }
+
+    // ----------------------Client-----------------------
+
+    Response SendRequest(const string& socket_path, const Request& request, ostream& output) {
+        const sockaddr_un address = SocketAddress(socket_path);
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            ThrowSystemError("socket"s);
+        }
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            const int error = errno;
+            close(fd);
+            errno = error;
+            ThrowSystemError("Cannot connect to "s + socket_path);
+        }
+        const bool by_path = !request.path.empty();
+        const string& script = by_path ? request.path : request.source;
+        const string message = (by_path ? "path "s : "source "s) + to_string(script.size()) + ' '
+            + to_string(request.input.size()) + '\n' + script + request.input;
+
+        Response response;
+        bool finished = false;
+        SocketReader reader(fd);
+        if (SendAll(fd, message)) {
+            while (const optional<string> line = reader.ReadLine()) {
+                if (*line == "done"s) {
+                    response.ok = true;
+                    finished = true;
+                    break;
+                }
+                istringstream fields(*line);
+                string tag;
+                size_t length = 0;
+                if (!(fields >> tag >> length)) {
+                    break;
+                }
+                const optional<string> payload = reader.Read(length);
+                if (!payload) {
+                    break;
+                }
+                if (tag == "output"s) {
+                    output << *payload;
+                } else if (tag == "error"s) {
+                    response.error = *payload;
+                    finished = true;
+                    break;
+                } else {
+                    break;
+                }
+            }
+        }
+        close(fd);
+        if (!finished) {
+            throw runtime_error("Incomplete response from "s + socket_path);
+        }
+        return response;
+    }
+
+}  // namespace server
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "program.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A long-running interpreter behind a Unix domain socket, so that short scripts pay neither
+// process startup nor, once their source has been seen, lexing and parsing.
+//
+// A connection carries one request: a header line "<source|path> <length> <input length>\n",
+// then the script source or the path of a script file, then the input payload, which the
+// script reads as the global string stdin. The reply streams the output as it is printed, in
+// frames "output <length>\n<bytes>", and ends with "done\n" or "error <length>\n<message>".
+namespace jit {
+    class Jit;
+}
+
+namespace server {
+
+    // ----------------------ProgramCache-----------------------
+
+    struct ProgramCacheStats {
+        size_t                                         hits = 0;
+        size_t                                         misses = 0;
+        size_t                                         evictions = 0;
+        size_t                                         size = 0;
+    };
+
+    // Compiled programs by the parse::HashSource of their source, dropping the least recently
+    // used one when full. Programs are compiled outside the lock, so two threads missing on the
+    // same source at once both compile it; sources that fail to compile are not cached.
+    class ProgramCache {
+    public:
+        static constexpr size_t                        DEFAULT_CAPACITY = 64;
+
+        explicit                                       ProgramCache(size_t capacity = DEFAULT_CAPACITY);
+
+        // Throws the errors of Lexer and ParseProgram.
+        [[nodiscard]] std::shared_ptr<const Program>   Get(const std::string& source);
+
+        [[nodiscard]] ProgramCacheStats                GetStats() const;
+
+    private:
+        struct Entry {
+            uint64_t                                   hash = 0;
+            std::string                                source;
+            std::shared_ptr<const Program>             program;
+        };
+
+        size_t                                         capacity_;
+        mutable std::mutex                             lock_;
+        std::list<Entry>                               entries_;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+        ProgramCacheStats                              stats_;
+    };
+
+    // ----------------------Server-----------------------
+
+    struct ServerOptions {
+        std::string                                    socket_path;
+        size_t                                         thread_count = std::thread::hardware_concurrency();
+        size_t                                         cache_capacity = ProgramCache::DEFAULT_CAPACITY;
+        // Requests whose script and input are together longer are answered with an error
+        // frame before anything is read or allocated for them.
+        size_t                                         max_request_bytes = 16 << 20;
+        // The stackless interpreter keeps a deeply recursive script from overflowing the stack of
+        // the worker thread, which would take the whole daemon down.
+        ExecutionMode                                  mode = ExecutionMode::STACKLESS;
+        // Each request runs under an ExecutionBudget of at most max_steps steps and timeout of
+        // wall time; a zero timeout and UNLIMITED steps run it without a budget.
+        size_t                                         max_steps = runtime::ExecutionBudget::UNLIMITED;
+        std::chrono::milliseconds                      timeout{30000};
+        // Each request runs under a MemoryAccount of this quota, so that one script cannot take
+        // all of the daemon's memory; UNLIMITED runs it without one.
+        size_t                                         max_memory_bytes = runtime::MemoryAccount::UNLIMITED;
+        // Receive and send timeout of a connection, so that a client that stalls in the middle
+        // of its request or stops reading the output cannot hold a worker forever.
+        std::chrono::milliseconds                      io_timeout{10000};
+        // Each worker keeps a jit::Jit per program across requests, dropped with the program.
+        // Only used for requests run without a budget in a mode other than STACKLESS.
+        bool                                           jit = true;
+    };
+
+    struct ServerStats {
+        size_t                                         requests = 0;
+        size_t                                         failed = 0;
+        // Instances freed by the CycleCollector each request runs under.
+        size_t                                         collected = 0;
+    };
+
+    // Listens from construction on; Run accepts connections until Stop, and workers serve them.
+    // A stale socket file left at the path by an earlier server is replaced.
+    class Server {
+    public:
+        // Throws std::runtime_error when the socket cannot be set up.
+        explicit                                       Server(ServerOptions options);
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        ~Server();
+
+        void                                           Run();
+
+        // May be called from any thread, including before Run.
+        void                                           Stop();
+
+        [[nodiscard]] ServerStats                      GetStats() const;
+
+        [[nodiscard]] ProgramCacheStats                GetCacheStats() const;
+
+    private:
+        // The Jits of a worker thread by the program they ran, as a Jit must not outlive its
+        // program. The weak reference tells when the program is gone and keeps its address from
+        // being reused meanwhile.
+        struct WorkerJit {
+            std::weak_ptr<const Program>               program;
+            std::unique_ptr<jit::Jit>                  jit;
+        };
+
+        using WorkerJits = std::unordered_map<const Program*, WorkerJit>;
+
+        void                                           WorkerLoop();
+
+        void                                           Serve(int fd, WorkerJits& jits);
+
+        ServerOptions                                  options_;
+        ProgramCache                                   cache_;
+        int                                            listen_fd_ = -1;
+        int                                            wake_fds_[2] = {-1, -1};
+        std::mutex                                     queue_lock_;
+        std::condition_variable                        queue_cv_;
+        std::deque<int>                                connections_;
+        bool                                           stopping_ = false;
+        std::vector<std::thread>                       workers_;
+        std::atomic<size_t>                            requests_ = 0;
+        std::atomic<size_t>                            failed_ = 0;
+        std::atomic<size_t>                            collected_ = 0;
+    };
+
+    // ----------------------Client-----------------------
+
+    struct Request {
+        // A script file on the server's file system, read instead of source when not empty.
+        std::string                                    path;
+        std::string                                    source;
+        std::string                                    input;
+    };
+
+    struct Response {
+        bool                                           ok = false;
+        std::string                                    error;
+    };
+
+    // Sends a request and copies the output to output as it arrives. Throws std::runtime_error
+    // when the server cannot be reached or breaks the protocol.
+    Response SendRequest(const std::string& socket_path, const Request& request, std::ostream& output);
+
+}  // namespace server
@@ -0,0 +1,313 @@
+#include "lexer.h"
+#include "server.h"
+#include "test_runner_p.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace server {
+
+namespace {
+
+const string FIB_PROGRAM = R"(
+class Fib:
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+f = Fib()
+print stdin, f.fib(15)
+)"s;
+
+const string COUNTDOWN_PROGRAM = R"(
+class Countdown:
+  def run(n):
+    if n > 0:
+      print 'line', n
+      self.run(n - 1)
+
+c = Countdown()
+c.run(500)
+)"s;
+
+string SocketPath() {
+    return "/tmp/mython_server_test_"s + to_string(getpid()) + ".sock"s;
+}
+
+// Runs a server on a thread for the lifetime of the object.
+class RunningServer {
+public:
+    explicit RunningServer(ServerOptions options)
+        : server_(move(options))
+        , thread_([this] {
+            server_.Run();
+        }) {}
+
+    ~RunningServer() {
+        server_.Stop();
+        thread_.join();
+    }
+
+    Server& Get() {
+        return server_;
+    }
+
+private:
+    Server server_;
+    thread thread_;
+};
+
+Response Send(const Request& request, string& output) {
+    ostringstream stream;
+    Response response = SendRequest(SocketPath(), request, stream);
+    output = stream.str();
+    return response;
+}
+
+// Sends message as is and returns everything the server answers until it closes the connection.
+string SendRaw(const string& message) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const string path = SocketPath();
+    memcpy(address.sun_path, path.data(), path.size());
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT(fd >= 0);
+    ASSERT(connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+    ASSERT_EQUAL(send(fd, message.data(), message.size(), MSG_NOSIGNAL), static_cast<ssize_t>(message.size()));
+    string reply;
+    char buffer[256];
+    ssize_t received = 0;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, static_cast<size_t>(received));
+    }
+    close(fd);
+    return reply;
+}
+
+void TestProgramCache() {
+    ProgramCache cache(2);
+    const string a = "print 'a'\n"s;
+    const string b = "print 'b'\n"s;
+    const string c = "print 'c'\n"s;
+    auto first = cache.Get(a);
+    ASSERT(cache.Get(a) == first);
+    (void)cache.Get(b);
+    (void)cache.Get(c);
+    ASSERT(cache.Get(a) != first);
+    ASSERT_THROWS((void)cache.Get("print ("s), exception);
+
+    const ProgramCacheStats stats = cache.GetStats();
+    ASSERT_EQUAL(stats.hits, 1u);
+    ASSERT_EQUAL(stats.misses, 5u);
+    ASSERT_EQUAL(stats.evictions, 2u);
+    ASSERT_EQUAL(stats.size, 2u);
+    ASSERT(parse::HashSource(a) != parse::HashSource(b));
+
+    // The cache and the profiles recorded by pgo key the same source by the same hash.
+    istringstream input(a);
+    ASSERT_EQUAL(parse::Lexer(input).GetSourceHash(), parse::HashSource(a));
+}
+
+void TestServesRequests() {
+    RunningServer server({SocketPath(), 2, 4});
+    string output;
+
+    Request request;
+    request.source = "print 'hello', stdin\n"s;
+    request.input = "world"s;
+    ASSERT(Send(request, output).ok);
+    ASSERT_EQUAL(output, "hello world\n"s);
+    ASSERT(Send(request, output).ok);
+    ASSERT_EQUAL(output, "hello world\n"s);
+    ASSERT_EQUAL(server.Get().GetCacheStats().hits, 1u);
+
+    const string path = "/tmp/mython_server_test_"s + to_string(getpid()) + ".my"s;
+    {
+        ofstream script(path);
+        script << COUNTDOWN_PROGRAM;
+    }
+    Request by_path;
+    by_path.path = path;
+    ASSERT(Send(by_path, output).ok);
+    remove(path.c_str());
+    ASSERT(output.size() > 4096u);
+    ASSERT_EQUAL(output.rfind("line 500\nline 499\n"s, 0), 0u);
+    ASSERT_EQUAL(output.substr(output.size() - 14), "line 2\nline 1\n"s);
+
+    Response missing = Send(by_path, output);
+    ASSERT(!missing.ok);
+    ASSERT_EQUAL(missing.error, "Cannot open "s + path);
+
+    Request failing;
+    failing.source = "print 'before'\nx = 1 / 0\n"s;
+    Response failed = Send(failing, output);
+    ASSERT(!failed.ok);
+    ASSERT(!failed.error.empty());
+    ASSERT_EQUAL(output, "before\n"s);
+
+    Request malformed;
+    malformed.source = "print (\n"s;
+    ASSERT(!Send(malformed, output).ok);
+    ASSERT(output.empty());
+
+    const ServerStats stats = server.Get().GetStats();
+    ASSERT_EQUAL(stats.requests, 6u);
+    ASSERT_EQUAL(stats.failed, 3u);
+}
+
+void TestConcurrentClients() {
+    // A cache smaller than the set of scripts makes workers drop the Jits of evicted programs
+    // while other workers may still run them.
+    ServerOptions options{SocketPath(), 3, 2};
+    options.mode = ExecutionMode::TREE_WALKING;
+    options.timeout = chrono::milliseconds(0);
+    RunningServer server(options);
+    const vector<string> sources = {FIB_PROGRAM, FIB_PROGRAM + "\n"s, FIB_PROGRAM + "\n\n"s};
+    vector<thread> clients;
+    vector<size_t> failures(4, 0);
+    for (size_t client = 0; client < failures.size(); ++client) {
+        clients.emplace_back([&, client] {
+            for (size_t i = 0; i < 6; ++i) {
+                Request request;
+                request.source = sources[(client + i) % sources.size()];
+                request.input = to_string(client);
+                string output;
+                if (!Send(request, output).ok || output != to_string(client) + " 610\n"s) {
+                    ++failures[client];
+                }
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    for (const size_t count : failures) {
+        ASSERT_EQUAL(count, 0u);
+    }
+    ASSERT_EQUAL(server.Get().GetStats().requests, 24u);
+    ASSERT(server.Get().GetCacheStats().evictions > 0);
+}
+
+void TestRejectsOversizedRequests() {
+    ServerOptions options{SocketPath(), 1, 4};
+    options.max_request_bytes = 64;
+    RunningServer server(options);
+
+    const string too_large = "error 17\nRequest too large"s;
+    ASSERT_EQUAL(SendRaw("source 18446744073709551615 0\n"s), too_large);
+    ASSERT_EQUAL(SendRaw("source 10 18446744073709551615\n"s), too_large);
+    ASSERT_EQUAL(SendRaw("source -1 0\n"s), too_large);
+    ASSERT_EQUAL(SendRaw("run 1 0\nx"s), "error 17\nMalformed request"s);
+
+    string output;
+    Request request;
+    request.source = "print '"s + string(60, 'x') + "'\n"s;
+    Response response = Send(request, output);
+    ASSERT(!response.ok);
+    ASSERT_EQUAL(response.error, "Request too large"s);
+
+    request.source = "print 'fits'\n"s;
+    ASSERT(Send(request, output).ok);
+    ASSERT_EQUAL(output, "fits\n"s);
+    ASSERT_EQUAL(server.Get().GetStats().failed, 5u);
+}
+
+void TestLimitsRequests() {
+    ServerOptions options{SocketPath(), 1, 4};
+    options.max_steps = 1000;
+    options.io_timeout = chrono::milliseconds(100);
+    RunningServer server(options);
+
+    string output;
+    Request request;
+    request.source = COUNTDOWN_PROGRAM;
+    Response response = Send(request, output);
+    ASSERT(!response.ok);
+    ASSERT_EQUAL(response.error, "Execution budget exceeded: step limit"s);
+    ASSERT_EQUAL(output.rfind("line 500\n"s, 0), 0u);
+
+    request.source = "print 'short'\n"s;
+    ASSERT(Send(request, output).ok);
+    ASSERT_EQUAL(output, "short\n"s);
+
+    // A client that never completes its request is cut off by the receive timeout.
+    const auto start = chrono::steady_clock::now();
+    ASSERT_EQUAL(SendRaw("source 10 0\nprint"s), ""s);
+    ASSERT(chrono::steady_clock::now() - start < chrono::seconds(5));
+    ASSERT_EQUAL(server.Get().GetStats().failed, 2u);
+}
+
+void TestCollectsCyclesPerRequest() {
+    ServerOptions options{SocketPath(), 1, 4};
+    options.max_memory_bytes = 1 << 20;
+    RunningServer server(options);
+
+    string output;
+    Request request;
+    request.source = "class Node:\n  def __init__():\n    self.me = self\n\na = Node()\nb = Node()\nprint 'ok'\n"s;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT(Send(request, output).ok);
+        ASSERT_EQUAL(output, "ok\n"s);
+    }
+    ASSERT_EQUAL(server.Get().GetStats().collected, 20u);
+}
+
+void TestLimitsMemory() {
+    ServerOptions options{SocketPath(), 1, 4};
+    options.max_memory_bytes = 16 << 10;
+    RunningServer server(options);
+
+    string output;
+    Request request;
+    request.source = R"(
+class Grow:
+  def run(s, n):
+    if n == 0:
+      return s
+    return self.run(s + s, n - 1)
+
+g = Grow()
+print g.run('0123456789abcdef', 20)
+)"s;
+    Response response = Send(request, output);
+    ASSERT(!response.ok);
+    ASSERT_EQUAL(response.error.rfind("Memory quota exceeded"s, 0), 0u);
+    ASSERT_EQUAL(output, ""s);
+
+    // The quota is per request, so what the failed one held does not count against the next.
+    request.source = "print 'short'\n"s;
+    ASSERT(Send(request, output).ok);
+    ASSERT_EQUAL(output, "short\n"s);
+}
+
+void TestSendWithoutServer() {
+    ostringstream output;
+    ASSERT_THROWS((void)SendRequest("/tmp/mython_server_test_missing.sock"s, {}, output), runtime_error);
+}
+
+}  // namespace
+
+void RunServerTests(TestRunner& tr) {
+    RUN_TEST(tr, TestProgramCache);
+    RUN_TEST(tr, TestServesRequests);
+    RUN_TEST(tr, TestConcurrentClients);
+    RUN_TEST(tr, TestRejectsOversizedRequests);
+    RUN_TEST(tr, TestLimitsRequests);
+    RUN_TEST(tr, TestCollectsCyclesPerRequest);
+    RUN_TEST(tr, TestLimitsMemory);
+    RUN_TEST(tr, TestSendWithoutServer);
+}
+
+}  // namespace server
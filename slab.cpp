@@ -0,0 +1,227 @@
+#include "slab.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct Magazine {
+            FreeBlock* head = nullptr;
+            size_t count = 0;
+        };
+
+        struct Depot {
+            mutex lock;
+            vector<Magazine> magazines;
+            atomic<size_t> allocations = 0;
+            atomic<size_t> frees = 0;
+            atomic<size_t> slabs = 0;
+            atomic<size_t> exchanges = 0;
+        };
+
+        // Slabs are never returned to the system, so a block may be freed by any thread and
+        // reused by any other; the depots are leaked to stay valid during thread-exit flushes.
+        Depot* Depots() {
+            static Depot* depots = new Depot[Slab::CLASS_COUNT];
+            return depots;
+        }
+
+        constexpr size_t ClassIndex(size_t size) {
+            return (size - 1) / Slab::GRANULARITY;
+        }
+
+        constexpr size_t BlockSize(size_t index) {
+            return (index + 1) * Slab::GRANULARITY;
+        }
+
+        // Must be called with the depot lock held.
+        void CarveSlab(size_t index, Depot& depot) {
+            const size_t block_size = BlockSize(index);
+            const size_t block_count = Slab::SLAB_SIZE / block_size;
+            auto* slab = static_cast<std::byte*>(::operator new(Slab::SLAB_SIZE, align_val_t{Slab::GRANULARITY}));
+
+            Magazine magazine;
+            for (size_t i = block_count; i > 0; --i) {
+                auto* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * block_size);
+                block->next = magazine.head;
+                magazine.head = block;
+                if (++magazine.count == Slab::MAGAZINE_SIZE || i == 1) {
+                    depot.magazines.push_back(exchange(magazine, Magazine{}));
+                }
+            }
+            depot.slabs.fetch_add(1, memory_order_relaxed);
+        }
+
+        thread_local bool thread_cache_destroyed = false;
+
+        class ThreadCache {
+        public:
+            ~ThreadCache() {
+                Flush();
+                thread_cache_destroyed = true;
+            }
+
+            void* Allocate(size_t index) {
+                Bin& bin = bins_[index];
+                if (!bin.items.head) {
+                    Refill(index);
+                }
+                FreeBlock* block = bin.items.head;
+                bin.items.head = block->next;
+                --bin.items.count;
+                ++bin.allocations;
+                return block;
+            }
+
+            void Deallocate(void* ptr, size_t index) {
+                Bin& bin = bins_[index];
+                auto* block = static_cast<FreeBlock*>(ptr);
+                block->next = bin.items.head;
+                bin.items.head = block;
+                ++bin.items.count;
+                ++bin.frees;
+                if (bin.items.count >= 2 * Slab::MAGAZINE_SIZE) {
+                    Spill(index);
+                }
+            }
+
+            void Flush() {
+                for (size_t index = 0; index < Slab::CLASS_COUNT; ++index) {
+                    Bin& bin = bins_[index];
+                    Depot& depot = Depots()[index];
+                    PublishCounters(index);
+                    if (bin.items.count > 0) {
+                        lock_guard guard(depot.lock);
+                        depot.magazines.push_back(exchange(bin.items, Magazine{}));
+                    }
+                }
+            }
+
+            void AddCounters(size_t index, SlabStats& stats) const {
+                stats.allocations += bins_[index].allocations;
+                stats.frees += bins_[index].frees;
+            }
+
+        private:
+            struct Bin {
+                Magazine items;
+                size_t allocations = 0;
+                size_t frees = 0;
+            };
+
+            void Refill(size_t index) {
+                Depot& depot = Depots()[index];
+                PublishCounters(index);
+                depot.exchanges.fetch_add(1, memory_order_relaxed);
+                lock_guard guard(depot.lock);
+                if (depot.magazines.empty()) {
+                    CarveSlab(index, depot);
+                }
+                bins_[index].items = depot.magazines.back();
+                depot.magazines.pop_back();
+            }
+
+            void Spill(size_t index) {
+                Bin& bin = bins_[index];
+                Magazine spilled{bin.items.head, Slab::MAGAZINE_SIZE};
+                FreeBlock* last = bin.items.head;
+                for (size_t i = 1; i < Slab::MAGAZINE_SIZE; ++i) {
+                    last = last->next;
+                }
+                bin.items.head = last->next;
+                bin.items.count -= Slab::MAGAZINE_SIZE;
+                last->next = nullptr;
+
+                Depot& depot = Depots()[index];
+                PublishCounters(index);
+                depot.exchanges.fetch_add(1, memory_order_relaxed);
+                lock_guard guard(depot.lock);
+                depot.magazines.push_back(spilled);
+            }
+
+            void PublishCounters(size_t index) {
+                Bin& bin = bins_[index];
+                Depot& depot = Depots()[index];
+                depot.allocations.fetch_add(exchange(bin.allocations, 0), memory_order_relaxed);
+                depot.frees.fetch_add(exchange(bin.frees, 0), memory_order_relaxed);
+            }
+
+            Bin bins_[Slab::CLASS_COUNT];
+        };
+
+        thread_local ThreadCache thread_cache;
+
+        void* AllocateFromDepot(size_t index) {
+            Depot& depot = Depots()[index];
+            depot.allocations.fetch_add(1, memory_order_relaxed);
+            lock_guard guard(depot.lock);
+            if (depot.magazines.empty()) {
+                CarveSlab(index, depot);
+            }
+            Magazine& magazine = depot.magazines.back();
+            FreeBlock* block = magazine.head;
+            magazine.head = block->next;
+            if (--magazine.count == 0) {
+                depot.magazines.pop_back();
+            }
+            return block;
+        }
+
+        void DeallocateToDepot(void* ptr, size_t index) {
+            Depot& depot = Depots()[index];
+            depot.frees.fetch_add(1, memory_order_relaxed);
+            auto* block = static_cast<FreeBlock*>(ptr);
+            block->next = nullptr;
+            lock_guard guard(depot.lock);
+            depot.magazines.push_back({block, 1});
+        }
+    }  // namespace
+
+    // ----------------------Slab-----------------------
+
+    void* Slab::Allocate(size_t size) {
+        if (thread_cache_destroyed) {
+            return AllocateFromDepot(ClassIndex(size));
+        }
+        return thread_cache.Allocate(ClassIndex(size));
+    }
+
+    void Slab::Deallocate(void* ptr, size_t size) {
+        if (thread_cache_destroyed) {
+            DeallocateToDepot(ptr, ClassIndex(size));
+            return;
+        }
+        thread_cache.Deallocate(ptr, ClassIndex(size));
+    }
+
+    std::vector<SlabStats> Slab::GetStats() {
+        vector<SlabStats> result(CLASS_COUNT);
+        for (size_t index = 0; index < CLASS_COUNT; ++index) {
+            const Depot& depot = Depots()[index];
+            SlabStats& stats = result[index];
+            stats.block_size = BlockSize(index);
+            stats.allocations = depot.allocations.load(memory_order_relaxed);
+            stats.frees = depot.frees.load(memory_order_relaxed);
+            stats.slabs = depot.slabs.load(memory_order_relaxed);
+            stats.depot_exchanges = depot.exchanges.load(memory_order_relaxed);
+            if (!thread_cache_destroyed) {
+                thread_cache.AddCounters(index, stats);
+            }
+        }
+        return result;
+    }
+
+    void Slab::FlushThreadCache() {
+        thread_cache.Flush();
+    }
+
+}  // namespace runtime
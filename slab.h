@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace runtime {
+
+    // ----------------------SlabStats-----------------------
+
+    struct SlabStats {
+        size_t                                         block_size = 0;
+        size_t                                         allocations = 0;
+        size_t                                         frees = 0;
+        size_t                                         slabs = 0;
+        size_t                                         depot_exchanges = 0;
+    };
+
+    // ----------------------Slab-----------------------
+
+    class Slab {
+    public:
+        static constexpr size_t                        GRANULARITY = 16;
+        static constexpr size_t                        MAX_BLOCK_SIZE = 256;
+        static constexpr size_t                        CLASS_COUNT = MAX_BLOCK_SIZE / GRANULARITY;
+        static constexpr size_t                        MAGAZINE_SIZE = 64;
+        static constexpr size_t                        SLAB_SIZE = 64 * 1024;
+
+        [[nodiscard]] static constexpr bool            Fits(size_t size, size_t alignment);
+
+        [[nodiscard]] static void* Allocate(size_t size);
+
+        static void                                    Deallocate(void* ptr, size_t size);
+
+        [[nodiscard]] static std::vector<SlabStats>    GetStats();
+
+        static void                                    FlushThreadCache();
+    };
+
+    constexpr bool Slab::Fits(size_t size, size_t alignment) {
+        return size > 0 && size <= MAX_BLOCK_SIZE && alignment <= GRANULARITY;
+    }
+
+    // ----------------------SlabAllocator-----------------------
+
+    template <typename T>
+    class SlabAllocator {
+    public:
+        using value_type = T;
+
+        SlabAllocator() = default;
+
+        template <typename U>
+        SlabAllocator(const SlabAllocator<U>&) {}
+
+        [[nodiscard]] T* allocate(size_t n);
+
+        void                                           deallocate(T* ptr, size_t n);
+
+        template <typename U>
+        bool                                           operator==(const SlabAllocator<U>&) const;
+
+        template <typename U>
+        bool                                           operator!=(const SlabAllocator<U>&) const;
+    };
+
+    template <typename T>
+    T* SlabAllocator<T>::allocate(size_t n) {
+        if (Slab::Fits(n * sizeof(T), alignof(T))) {
+            return static_cast<T*>(Slab::Allocate(n * sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    template <typename T>
+    void SlabAllocator<T>::deallocate(T* ptr, size_t n) {
+        if (Slab::Fits(n * sizeof(T), alignof(T))) {
+            Slab::Deallocate(ptr, n * sizeof(T));
+        }
+        else {
+            ::operator delete(ptr);
+        }
+    }
+
+    template <typename T>
+    template <typename U>
+    bool SlabAllocator<T>::operator==(const SlabAllocator<U>&) const {
+        return true;
+    }
+
+    template <typename T>
+    template <typename U>
+    bool SlabAllocator<T>::operator!=(const SlabAllocator<U>&) const {
+        return false;
+    }
+
+}  // namespace runtime
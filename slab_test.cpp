@@ -0,0 +1,92 @@
+#include "runtime.h"
+#include "slab.h"
+#include "test_runner_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+size_t TotalAllocations() {
+    auto stats = Slab::GetStats();
+    return accumulate(stats.begin(), stats.end(), size_t{0}, [](size_t sum, const SlabStats& s) {
+        return sum + s.allocations;
+    });
+}
+
+void TestSlabReusesBlocks() {
+    void* first = Slab::Allocate(24);
+    Slab::Deallocate(first, 24);
+    void* second = Slab::Allocate(30);
+    ASSERT_EQUAL(first, second);
+    Slab::Deallocate(second, 30);
+
+    const auto stats = Slab::GetStats();
+    ASSERT_EQUAL(stats.size(), Slab::CLASS_COUNT);
+    ASSERT_EQUAL(stats[1].block_size, 32U);
+    ASSERT(stats[1].allocations >= 2U);
+    ASSERT(stats[1].slabs >= 1U);
+}
+
+void TestSlabBlocksDoNotOverlap() {
+    vector<char*> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        auto* block = static_cast<char*>(Slab::Allocate(48));
+        fill(block, block + 48, static_cast<char>(i));
+        blocks.push_back(block);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT(all_of(blocks[i], blocks[i] + 48, [i](char c) {
+            return c == static_cast<char>(i);
+        }));
+        Slab::Deallocate(blocks[i], 48);
+    }
+}
+
+void TestSlabCrossThreadFree() {
+    vector<ObjectHolder> numbers;
+    thread producer([&numbers] {
+        for (int i = 0; i < 5000; ++i) {
+            numbers.push_back(ObjectHolder::Own(Number(i)));
+        }
+    });
+    producer.join();
+
+    const size_t before = TotalAllocations();
+    atomic<size_t> mismatches = 0;
+    vector<thread> consumers;
+    for (size_t t = 0; t < 4; ++t) {
+        consumers.emplace_back([&numbers, &mismatches, t] {
+            for (size_t i = t; i < numbers.size(); i += 4) {
+                if (numbers[i].TryAs<Number>()->GetValue() != static_cast<int>(i)) {
+                    ++mismatches;
+                }
+                numbers[i] = ObjectHolder::Own(Bool(i % 2 == 0));
+            }
+        });
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+    ASSERT_EQUAL(mismatches.load(), 0U);
+    ASSERT(TotalAllocations() >= before + numbers.size());
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        ASSERT_EQUAL(numbers[i].TryAs<Bool>()->GetValue(), i % 2 == 0);
+    }
+}
+
+}  // namespace
+
+void RunSlabTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestSlabReusesBlocks);
+    RUN_TEST(tr, runtime::TestSlabBlocksDoNotOverlap);
+    RUN_TEST(tr, runtime::TestSlabCrossThreadFree);
+}
+
+}  // namespace runtime
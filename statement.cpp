@@ -1,7 +1,10 @@
 #include "statement.h"
 
+#include "pgo.h"
+#include "profiler.h"
+#include "trace.h"
+
 #include <iostream>
-#include <sstream>
 
 using namespace std;
 
@@ -49,6 +52,10 @@ namespace ast {
         return {};
     }
 
+    const std::vector<std::string>& VariableValue::GetDottedIds() const {
+        return dotted_ids_;
+    }
+
     // -----------------------Assignment---------------------------
 
     Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv)
@@ -59,6 +66,14 @@ namespace ast {
         return closure[var_] = rv_->Execute(closure, context);
     }
 
+    const std::string& Assignment::GetName() const {
+        return var_;
+    }
+
+    Statement* Assignment::GetValue() const {
+        return rv_.get();
+    }
+
     // -----------------------FieldAssignment---------------------------
 
     FieldAssignment::FieldAssignment(VariableValue object, std::string field_name,
@@ -68,13 +83,27 @@ namespace ast {
         , rv_(move(rv)) {}
 
     ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
-        auto ptr_obj = object_.Execute(closure, context).TryAs<runtime::ClassInstance>();
-        if (ptr_obj) {
-            return ptr_obj->Fields()[field_name_] = rv_->Execute(closure, context);
+        ObjectHolder object = object_.Execute(closure, context);
+        if (auto ptr_obj = object.TryAs<runtime::ClassInstance>(); ptr_obj) {
+            ObjectHolder value = rv_->Execute(closure, context);
+            ptr_obj->SetField(field_name_, value);
+            return value;
         }
         return {};
     }
 
+    const VariableValue& FieldAssignment::GetObject() const {
+        return object_;
+    }
+
+    const std::string& FieldAssignment::GetFieldName() const {
+        return field_name_;
+    }
+
+    Statement* FieldAssignment::GetValue() const {
+        return rv_.get();
+    }
+
     // -----------------------None---------------------------
 
     ObjectHolder None::Execute([[maybe_unused]] Closure& closure,
@@ -97,23 +126,23 @@ namespace ast {
         : args_(move(args)) {}
 
     ObjectHolder Print::Execute(Closure& closure, Context& context) {
-        auto& os = context.GetOutputStream();
+        size_t bytes = 0;
         for (size_t i = 0; i < args_.size(); ++i) {
-            auto ptr_obj = args_.at(i)->Execute(closure, context).Get();
-            if (ptr_obj) {
-                ptr_obj->Print(os, context);
-            }
-            else {
-                os << "None"s;
-            }
-            if (i != args_.size() - 1) {
-                os << ' ';
-            }
+            bytes += runtime::PrintArgument(args_[i]->Execute(closure, context), i + 1 == args_.size(), context);
         }
-        os << '\n';
+        if (args_.empty()) {
+            context.Write("\n"sv);
+            bytes = 1;
+        }
+        runtime::Hooks::Printed(bytes);
+        trace::Tracer::Instant("print", "print"sv, "bytes", bytes);
         return {};
     }
 
+    const std::vector<std::unique_ptr<Statement>>& Print::GetArgs() const {
+        return args_;
+    }
+
     // -----------------------MethodCall---------------------------
 
     MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
@@ -123,35 +152,93 @@ namespace ast {
         , args_(move(args)) {}
 
     ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
-        auto ptr_obj = object_->Execute(closure, context).TryAs<runtime::ClassInstance>();
-        if (ptr_obj) {
+        ObjectHolder object = object_->Execute(closure, context);
+        if (auto ptr_obj = object.TryAs<runtime::ClassInstance>(); ptr_obj) {
             vector<ObjectHolder> params;
             for (size_t i = 0; i < args_.size(); ++i) {
                 params.push_back(args_.at(i)->Execute(closure, context));
             }
+            pgo::Recorder::Receiver(*this, ptr_obj->GetClass());
+            if (const runtime::Method* method = Resolve(ptr_obj->GetClass());
+                method && method->formal_params.size() == params.size()) {
+                return ptr_obj->Call(*method, params, context);
+            }
             return ptr_obj->Call(method_, params, context);
         }
         return {};
     }
 
+    const runtime::Method* MethodCall::Resolve(const runtime::Class& cls) {
+        const uint32_t sequence = cache_.sequence.load(memory_order_acquire);
+        if (sequence % 2 == 0 && cache_.cls.load(memory_order_relaxed) == &cls) {
+            const runtime::Method* method = cache_.method.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (cache_.sequence.load(memory_order_relaxed) == sequence) {
+                runtime::Hooks::InlineCacheHit();
+                return method;
+            }
+        }
+        runtime::Hooks::InlineCacheMissed();
+        runtime::Hooks::MethodLookedUp();
+        const runtime::Method* method = cls.GetMethod(method_);
+        uint32_t expected = sequence;
+        if (sequence % 2 == 0 && cache_.sequence.compare_exchange_strong(expected, sequence + 1, memory_order_acquire)) {
+            atomic_thread_fence(memory_order_release);
+            cache_.cls.store(&cls, memory_order_relaxed);
+            cache_.method.store(method, memory_order_relaxed);
+            cache_.sequence.store(sequence + 2, memory_order_release);
+        }
+        return method;
+    }
+
+    Statement* MethodCall::GetObject() const {
+        return object_.get();
+    }
+
+    const std::string& MethodCall::GetMethod() const {
+        return method_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& MethodCall::GetArgs() const {
+        return args_;
+    }
+
+    void MethodCall::Prime(const runtime::Class& cls) {
+        const uint32_t sequence = cache_.sequence.load(memory_order_relaxed);
+        cache_.cls.store(&cls, memory_order_relaxed);
+        cache_.method.store(cls.GetMethod(method_), memory_order_relaxed);
+        cache_.sequence.store(sequence + 2, memory_order_release);
+    }
+
     // -----------------------NewInstance---------------------------
 
-    NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args)
-        : cls_(class_)
+    NewInstance::NewInstance(const runtime::Class& cls, std::vector<std::unique_ptr<Statement>> args)
+        : class_(cls)
         , args_(move(args)) {}
 
-    NewInstance::NewInstance(const runtime::Class& class_)
-        : cls_(class_) {}
+    NewInstance::NewInstance(const runtime::Class& cls)
+        : class_(cls) {}
 
     ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
-        if (cls_.HasMethod(INIT_METHOD, args_.size())) {
+        trace::Tracer::Span span("new", nullptr, class_.GetName(), "arity", args_.size());
+        ObjectHolder instance = ObjectHolder::Own(runtime::ClassInstance(class_));
+        auto ptr_instance = instance.TryAs<runtime::ClassInstance>();
+        if (ptr_instance->HasMethod(INIT_METHOD, args_.size())) {
             vector<ObjectHolder> params;
             for (size_t i = 0; i < args_.size(); ++i) {
                 params.push_back(args_.at(i)->Execute(closure, context));
             }
-            cls_.Call(INIT_METHOD, params, context);
+            ptr_instance->Call(INIT_METHOD, params, context);
         }
-        return ObjectHolder::Share(cls_);
+        return instance;
+    }
+
+    const runtime::Class& NewInstance::GetClass() const {
+        return class_;
+    }
+
+    const std::vector<std::unique_ptr<Statement>>& NewInstance::GetArgs() const {
+        return args_;
     }
 
     // -----------------------UnaryOperation---------------------------
@@ -159,14 +246,18 @@ namespace ast {
     UnaryOperation::UnaryOperation(std::unique_ptr<Statement> argument)
         : argument_(std::move(argument)) {}
 
+    Statement* UnaryOperation::GetArgument() const {
+        return argument_.get();
+    }
+
     // -----------------------Stringify---------------------------
 
     ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
-        auto ptr_obj = argument_->Execute(closure, context).Get();
-        if (ptr_obj) {
-            ostringstream os;
-            ptr_obj->Print(os, context);
-            return ObjectHolder::Own(runtime::String(os.str()));
+        ObjectHolder obj = argument_->Execute(closure, context);
+        if (obj) {
+            string buffer;
+            obj->FormatTo(buffer, context);
+            return ObjectHolder::Own(runtime::String(move(buffer)));
         }
         return  ObjectHolder::Own(runtime::String("None"s));
     }
@@ -177,11 +268,23 @@ namespace ast {
         : lhs_(std::move(lhs))
         , rhs_(std::move(rhs)) {}
 
+    Statement* BinaryOperation::GetLhs() const {
+        return lhs_.get();
+    }
+
+    Statement* BinaryOperation::GetRhs() const {
+        return rhs_.get();
+    }
+
     // -----------------------Add---------------------------
 
     ObjectHolder Add::Execute(Closure& closure, Context& context) {
         ObjectHolder lhs = lhs_->Execute(closure, context);
         ObjectHolder rhs = rhs_->Execute(closure, context);
+        pgo::Recorder::Operands(*this, lhs, rhs);
+        if (strings_first_) {
+            BINARY_OPERATION(runtime::String, lhs, rhs, +);
+        }
         BINARY_OPERATION(runtime::Number, lhs, rhs, +);
         BINARY_OPERATION(runtime::String, lhs, rhs, +);
         if (auto ptr = lhs.TryAs<runtime::ClassInstance>(); ptr) {
@@ -190,11 +293,16 @@ namespace ast {
         throw runtime_error("The operator is not overloaded +"s);
     }
 
+    void Add::PreferStrings() {
+        strings_first_ = true;
+    }
+
     // -----------------------Sub---------------------------
 
     ObjectHolder Sub::Execute(Closure& closure, Context& context) {
         ObjectHolder lhs = lhs_->Execute(closure, context);
         ObjectHolder rhs = rhs_->Execute(closure, context);
+        pgo::Recorder::Operands(*this, lhs, rhs);
         BINARY_OPERATION(runtime::Number, lhs, rhs, -);
         throw runtime_error("The operator is not overloaded -"s);
     }
@@ -204,6 +312,7 @@ namespace ast {
     ObjectHolder Mult::Execute(Closure& closure, Context& context) {
         ObjectHolder lhs = lhs_->Execute(closure, context);
         ObjectHolder rhs = rhs_->Execute(closure, context);
+        pgo::Recorder::Operands(*this, lhs, rhs);
         BINARY_OPERATION(runtime::Number, lhs, rhs, *);
         throw runtime_error("The operator is not overloaded *"s);
     }
@@ -213,6 +322,7 @@ namespace ast {
     ObjectHolder Div::Execute(Closure& closure, Context& context) {
         ObjectHolder lhs = lhs_->Execute(closure, context);
         ObjectHolder rhs = rhs_->Execute(closure, context);
+        pgo::Recorder::Operands(*this, lhs, rhs);
         const auto ptr_left = lhs.TryAs<runtime::Number>();
         const auto ptr_right = rhs.TryAs<runtime::Number>();
         if (ptr_left && ptr_right) {
@@ -256,11 +366,19 @@ namespace ast {
 
     ObjectHolder Compound::Execute(Closure& closure, Context& context) {
         for (size_t i = 0; i < args_.size(); ++i) {
+            context.ChargeStep();
+            runtime::CycleCollector::AtSafePoint();
+            profile::Profiler::AtStatement(*args_.at(i));
+            runtime::HeapProfiler::AtStatement(*args_.at(i));
             args_.at(i)->Execute(closure, context);
         }
         return {};
     }
 
+    const std::vector<std::unique_ptr<Statement>>& Compound::GetStatements() const {
+        return args_;
+    }
+
     // -----------------------MethodBody---------------------------
 
     MethodBody::MethodBody(std::unique_ptr<Statement>&& body)
@@ -276,13 +394,23 @@ namespace ast {
         return {};
     }
 
+    Statement* MethodBody::GetBody() const {
+        return body_.get();
+    }
+
     // -----------------------Return---------------------------
 
     Return::Return(std::unique_ptr<Statement> statement)
         : statement_(std::move(statement)) {}
 
     ObjectHolder Return::Execute(Closure& closure, Context& context) {
-        throw statement_->Execute(closure, context);
+        ObjectHolder result = statement_->Execute(closure, context);
+        runtime::Hooks::ReturnThrown();
+        throw result;
+    }
+
+    Statement* Return::GetStatement() const {
+        return statement_.get();
     }
 
     // -----------------------ClassDefinition---------------------------
@@ -294,6 +422,10 @@ namespace ast {
         return closure[cls_.TryAs<runtime::Class>()->GetName()] = cls_;
     }
 
+    const ObjectHolder& ClassDefinition::GetClass() const {
+        return cls_;
+    }
+
     // -----------------------IfElse---------------------------
 
     IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
@@ -303,7 +435,9 @@ namespace ast {
         , else_body_(move(else_body)) {}
 
     ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
-        if (IsTrue(condition_->Execute(closure, context))) {
+        const bool taken = IsTrue(condition_->Execute(closure, context));
+        pgo::Recorder::Branch(*this, taken);
+        if (taken) {
             return if_body_->Execute(closure, context);
         }
         if (else_body_) {
@@ -312,6 +446,18 @@ namespace ast {
         return {};
     }
 
+    Statement* IfElse::GetCondition() const {
+        return condition_.get();
+    }
+
+    Statement* IfElse::GetIfBody() const {
+        return if_body_.get();
+    }
+
+    Statement* IfElse::GetElseBody() const {
+        return else_body_.get();
+    }
+
     // -----------------------Comparison---------------------------
 
     Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
@@ -321,7 +467,12 @@ namespace ast {
     ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
         ObjectHolder lhs = lhs_->Execute(closure, context);
         ObjectHolder rhs = rhs_->Execute(closure, context);
+        pgo::Recorder::Operands(*this, lhs, rhs);
         return ObjectHolder::Own(runtime::Bool(cmp_(lhs, rhs, context)));
     }
 
+    const Comparison::Comparator& Comparison::GetComparator() const {
+        return cmp_;
+    }
+
 }  // namespace ast
\ No newline at end of file
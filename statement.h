@@ -2,6 +2,8 @@
 
 #include "runtime.h"
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <utility>
 
@@ -20,18 +22,25 @@ namespace ast {
 
         runtime::ObjectHolder                                  Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const runtime::ObjectHolder& GetValue() const;
+
     private:
-        T                                                      value_;
+        runtime::ObjectHolder                                  value_;
     };
 
     template <typename T>
     ValueStatement<T>::ValueStatement(T v)
-        : value_(std::move(v)) {}
+        : value_(runtime::ObjectHolder::Own(std::move(v))) {}
 
     template <typename T>
     runtime::ObjectHolder ValueStatement<T>::Execute([[maybe_unused]] runtime::Closure& closure,
         [[maybe_unused]] runtime::Context& context) {
-        return runtime::ObjectHolder::Share(value_);
+        return value_;
+    }
+
+    template <typename T>
+    const runtime::ObjectHolder& ValueStatement<T>::GetValue() const {
+        return value_;
     }
 
     // -----------------------NumericConst---------------------------
@@ -56,6 +65,8 @@ namespace ast {
 
         runtime::ObjectHolder                                    Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const std::vector<std::string>& GetDottedIds() const;
+
     private:
         std::vector<std::string>                                 dotted_ids_;
     };
@@ -69,6 +80,10 @@ namespace ast {
 
         runtime::ObjectHolder                                    Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const std::string& GetName() const;
+
+        [[nodiscard]] Statement* GetValue() const;
+
     private:
         std::string                                              var_;
         std::unique_ptr<Statement>                               rv_;
@@ -84,6 +99,12 @@ namespace ast {
 
         runtime::ObjectHolder                                    Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const VariableValue& GetObject() const;
+
+        [[nodiscard]] const std::string& GetFieldName() const;
+
+        [[nodiscard]] Statement* GetValue() const;
+
     private:
         VariableValue                                            object_;
         std::string                                              field_name_;
@@ -109,6 +130,8 @@ namespace ast {
 
         runtime::ObjectHolder                                    Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
+
     private:
         std::vector<std::unique_ptr<Statement>>                  args_;
     };
@@ -123,10 +146,31 @@ namespace ast {
 
         runtime::ObjectHolder                                    Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] Statement* GetObject() const;
+
+        [[nodiscard]] const std::string& GetMethod() const;
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
+
+        // Fills the inline cache for receivers of cls before the first execution.
+        void                                                     Prime(const runtime::Class& cls);
+
     private:
+        // The class of the last receiver and the method it resolved to. A tree may be executed
+        // by several threads at once, so the pair is published under a sequence number that is
+        // odd while it is being written.
+        struct InlineCache {
+            std::atomic<uint32_t>                                sequence{0};
+            std::atomic<const runtime::Class*>                   cls{nullptr};
+            std::atomic<const runtime::Method*>                  method{nullptr};
+        };
+
+        const runtime::Method*                                   Resolve(const runtime::Class& cls);
+
         std::unique_ptr<Statement>                               object_;
         std::string                                              method_;
         std::vector<std::unique_ptr<Statement>>                  args_;
+        InlineCache                                              cache_;
     };
 
     // -----------------------NewInstance---------------------------
@@ -140,8 +184,12 @@ namespace ast {
 
         runtime::ObjectHolder                                    Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const runtime::Class& GetClass() const;
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const;
+
     private:
-        runtime::ClassInstance                                   cls_;
+        const runtime::Class& class_;
         std::vector<std::unique_ptr<Statement>>                  args_;
     };
 
@@ -151,6 +199,8 @@ namespace ast {
     public:
         explicit                                                 UnaryOperation(std::unique_ptr<Statement> argument);
 
+        [[nodiscard]] Statement* GetArgument() const;
+
     protected:
         std::unique_ptr<Statement>                               argument_;
     };
@@ -171,6 +221,10 @@ namespace ast {
         BinaryOperation(std::unique_ptr<Statement> lhs,
             std::unique_ptr<Statement> rhs);
 
+        [[nodiscard]] Statement* GetLhs() const;
+
+        [[nodiscard]] Statement* GetRhs() const;
+
     protected:
         std::unique_ptr<Statement> lhs_, rhs_;
     };
@@ -182,6 +236,12 @@ namespace ast {
         using BinaryOperation::BinaryOperation;
 
         runtime::ObjectHolder                                      Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        // Checks for strings before numbers.
+        void                                                       PreferStrings();
+
+    private:
+        bool                                                       strings_first_ = false;
     };
 
     // -----------------------Sub---------------------------
@@ -248,6 +308,8 @@ namespace ast {
 
         runtime::ObjectHolder                                       Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetStatements() const;
+
     private:
         std::vector<std::unique_ptr<Statement>>                     args_;
     };
@@ -267,6 +329,8 @@ namespace ast {
 
         runtime::ObjectHolder                                       Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] Statement* GetBody() const;
+
     private:
         std::unique_ptr<Statement>                                  body_;
     };
@@ -279,6 +343,8 @@ namespace ast {
 
         runtime::ObjectHolder                                       Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] Statement* GetStatement() const;
+
     private:
         std::unique_ptr<Statement>                                  statement_;
     };
@@ -291,6 +357,8 @@ namespace ast {
 
         runtime::ObjectHolder                                        Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const runtime::ObjectHolder& GetClass() const;
+
     private:
         runtime::ObjectHolder                                        cls_;
     };
@@ -305,6 +373,12 @@ namespace ast {
 
         runtime::ObjectHolder                                        Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] Statement* GetCondition() const;
+
+        [[nodiscard]] Statement* GetIfBody() const;
+
+        [[nodiscard]] Statement* GetElseBody() const;
+
     private:
         std::unique_ptr<Statement>                                   condition_, if_body_, else_body_;
     };
@@ -320,6 +394,8 @@ namespace ast {
 
         runtime::ObjectHolder                                        Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+        [[nodiscard]] const Comparator& GetComparator() const;
+
     private:
         Comparator cmp_;
     };
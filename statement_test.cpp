@@ -172,6 +172,32 @@ void TestPrintMultipleStatements() {
     ASSERT_EQUAL(context.output.str(), "hello 57 Python None\n"s);
 }
 
+void TestPrintWritesEachArgumentInTurn() {
+    runtime::DummyContext context;
+
+    auto str_body = make_unique<Compound>();
+    str_body->AddStatement(make_unique<Print>(make_unique<StringConst>("inner"s)));
+    str_body->AddStatement(make_unique<Return>(make_unique<StringConst>("a"s)));
+    vector<runtime::Method> methods;
+    methods.push_back({"__str__"s, {}, make_unique<MethodBody>(std::move(str_body))});
+    runtime::Class cls("A"s, std::move(methods), nullptr);
+
+    Closure closure = {{"x"s, ObjectHolder::Own(runtime::ClassInstance(cls))}};
+    vector<unique_ptr<Statement>> args;
+    args.push_back(make_unique<StringConst>("outer"s));
+    args.push_back(make_unique<VariableValue>("x"s));
+    Print(std::move(args)).Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "outer inner\na\n"s);
+
+    // What was printed before a failing argument stays printed.
+    runtime::DummyContext failing_context;
+    vector<unique_ptr<Statement>> failing_args;
+    failing_args.push_back(make_unique<StringConst>("before"s));
+    failing_args.push_back(make_unique<VariableValue>("missing"s));
+    ASSERT_THROWS(Print(std::move(failing_args)).Execute(closure, failing_context), std::runtime_error);
+    ASSERT_EQUAL(failing_context.output.str(), "before "s);
+}
+
 void TestStringify() {
     runtime::DummyContext context;
 
@@ -457,11 +483,12 @@ void TestNot() {
 void RunUnitTests(TestRunner& tr) {
     RUN_TEST(tr, ast::TestNumericConst);
     RUN_TEST(tr, ast::TestStringConst);
-    RUN_TEST(tr, ast::TestVariable);
-    RUN_TEST(tr, ast::TestAssignment);
-    RUN_TEST(tr, ast::TestFieldAssignment);
+    RUN_BENCH(tr, ast::TestVariable);
+    RUN_BENCH(tr, ast::TestAssignment);
+    RUN_BENCH(tr, ast::TestFieldAssignment);
     RUN_TEST(tr, ast::TestPrintVariable);
     RUN_TEST(tr, ast::TestPrintMultipleStatements);
+    RUN_TEST(tr, ast::TestPrintWritesEachArgumentInTurn);
     RUN_TEST(tr, ast::TestStringify);
     RUN_TEST(tr, ast::TestNumbersAddition);
     RUN_TEST(tr, ast::TestStringsAddition);
@@ -469,7 +496,7 @@ void RunUnitTests(TestRunner& tr) {
     RUN_TEST(tr, ast::TestSuccessfulClassInstanceAdd);
     RUN_TEST(tr, ast::TestClassInstanceAddWithoutMethod);
     RUN_TEST(tr, ast::TestCompound);
-    RUN_TEST(tr, ast::TestFields);
+    RUN_BENCH(tr, ast::TestFields);
     RUN_TEST(tr, ast::TestBaseClass);
     RUN_TEST(tr, ast::TestInheritance);
     RUN_TEST(tr, ast::TestOr);
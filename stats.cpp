@@ -0,0 +1,82 @@
+#include "stats.h"
+
+#include <numeric>
+#include <ostream>
+#include <string_view>
+#include <utility>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+
+        constexpr array<string_view, OBJECT_KIND_COUNT> OBJECT_KIND_NAMES = {
+            "number"sv, "string"sv, "bool"sv, "instance"sv, "class"sv, "other"sv
+        };
+
+        array<pair<string_view, size_t>, 8> Scalars(const StatsCounters& counters) {
+            return {{
+                {"holder_copies"sv, counters.holder_copies},
+                {"closures_created"sv, counters.closures_created},
+                {"method_lookups"sv, counters.method_lookups},
+                {"inline_cache_hits"sv, counters.inline_cache_hits},
+                {"inline_cache_misses"sv, counters.inline_cache_misses},
+                {"return_exceptions"sv, counters.return_exceptions},
+                {"bytes_printed"sv, counters.bytes_printed},
+                {"peak_call_depth"sv, counters.peak_call_depth},
+            }};
+        }
+
+    }  // namespace
+
+    std::string_view GetObjectKindName(ObjectKind kind) {
+        return OBJECT_KIND_NAMES[static_cast<size_t>(kind)];
+    }
+
+    // ----------------------Scope-----------------------
+
+    Stats::Scope::Scope(Stats* stats)
+        : previous_(current_) {
+        if (stats) {
+            current_ = stats;
+        }
+    }
+
+    Stats::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    // ----------------------Stats-----------------------
+
+    const StatsCounters& Stats::GetCounters() const {
+        return counters_;
+    }
+
+    size_t Stats::GetObjectsAllocated() const {
+        return accumulate(counters_.objects_allocated.begin(), counters_.objects_allocated.end(), size_t{0});
+    }
+
+    void Stats::WriteText(ostream& out) const {
+        out << "objects_allocated " << GetObjectsAllocated() << '\n';
+        for (size_t i = 0; i < OBJECT_KIND_COUNT; ++i) {
+            out << "  " << OBJECT_KIND_NAMES[i] << ' ' << counters_.objects_allocated[i] << '\n';
+        }
+        for (const auto& [name, value] : Scalars(counters_)) {
+            out << name << ' ' << value << '\n';
+        }
+    }
+
+    void Stats::WriteJson(ostream& out) const {
+        out << "{\"objects_allocated\": {";
+        for (size_t i = 0; i < OBJECT_KIND_COUNT; ++i) {
+            out << (i ? ", \"" : "\"") << OBJECT_KIND_NAMES[i] << "\": " << counters_.objects_allocated[i];
+        }
+        out << '}';
+        for (const auto& [name, value] : Scalars(counters_)) {
+            out << ", \"" << name << "\": " << value;
+        }
+        out << "}\n";
+    }
+
+}  // namespace runtime
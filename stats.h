@@ -0,0 +1,225 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+
+namespace runtime {
+
+    // ----------------------ObjectKind-----------------------
+
+    enum class ObjectKind {
+        NUMBER,
+        STRING,
+        BOOL,
+        INSTANCE,
+        CLASS,
+        OTHER
+    };
+
+    inline constexpr size_t OBJECT_KIND_COUNT = static_cast<size_t>(ObjectKind::OTHER) + 1;
+
+    // "number", "string", "bool", "instance", "class" or "other".
+    [[nodiscard]] std::string_view GetObjectKindName(ObjectKind kind);
+
+    template <typename T>
+    struct ObjectKindOf {
+        static constexpr ObjectKind value = ObjectKind::OTHER;
+    };
+
+    // ----------------------StatsCounters-----------------------
+
+    struct StatsCounters {
+        std::array<size_t, OBJECT_KIND_COUNT>          objects_allocated{};
+        size_t                                         holder_copies = 0;
+        size_t                                         closures_created = 0;
+        size_t                                         method_lookups = 0;
+        size_t                                         inline_cache_hits = 0;
+        size_t                                         inline_cache_misses = 0;
+        size_t                                         return_exceptions = 0;
+        size_t                                         bytes_printed = 0;
+        size_t                                         peak_call_depth = 0;
+    };
+
+    // ----------------------Stats-----------------------
+
+    // Counters of what an execution did, collected on the thread of the innermost open Scope.
+    // Program::Execute opens one for the statistics of its context. A method lookup is a search
+    // of a class by method name; a call site whose inline cache hits does not make one. Closures
+    // are the local variable maps created for method calls.
+    class Stats {
+    public:
+        class Scope {
+        public:
+            // A null stats keeps the enclosing one.
+            explicit                                   Scope(Stats* stats);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            Stats* previous_;
+        };
+
+        [[nodiscard]] static Stats* Current();
+
+        [[nodiscard]] const StatsCounters& GetCounters() const;
+
+        [[nodiscard]] size_t                           GetObjectsAllocated() const;
+
+        void                                           WriteText(std::ostream& out) const;
+
+        void                                           WriteJson(std::ostream& out) const;
+
+    private:
+        template <typename Policy>
+        friend class StatsHooks;
+
+        StatsCounters                                  counters_;
+        size_t                                         call_depth_ = 0;
+
+        static inline thread_local Stats* current_ = nullptr;
+    };
+
+    inline Stats* Stats::Current() {
+        return current_;
+    }
+
+    // ----------------------StatsPolicy-----------------------
+
+    struct CountingStatsPolicy {
+        static constexpr bool                          ENABLED = true;
+    };
+
+    // Every hook compiles to nothing.
+    struct ReleaseStatsPolicy {
+        static constexpr bool                          ENABLED = false;
+    };
+
+    // Counting is opt-in with -DMYTHON_STATS: the hooks sit on hot paths such as every
+    // ObjectHolder copy, which must cost nothing in a regular build.
+#ifdef MYTHON_STATS
+    using DefaultStatsPolicy = CountingStatsPolicy;
+#else
+    using DefaultStatsPolicy = ReleaseStatsPolicy;
+#endif
+
+    // ----------------------StatsHooks-----------------------
+
+    // The points where the interpreter reports to the current Stats, if any.
+    template <typename Policy>
+    class StatsHooks {
+    public:
+        // Counts a method call for the call depth while alive.
+        class Call {
+        public:
+                                                       Call();
+
+            Call(const Call&) = delete;
+            Call& operator=(const Call&) = delete;
+
+            ~Call();
+
+        private:
+            Stats* stats_ = nullptr;
+        };
+
+        static void                                    ObjectAllocated(ObjectKind kind);
+
+        static void                                    HolderCopied();
+
+        static void                                    ClosureCreated();
+
+        static void                                    MethodLookedUp();
+
+        static void                                    InlineCacheHit();
+
+        static void                                    InlineCacheMissed();
+
+        static void                                    ReturnThrown();
+
+        static void                                    Printed(size_t bytes);
+
+    private:
+        template <typename Update>
+        static void                                    Record(Update update);
+    };
+
+    using Hooks = StatsHooks<DefaultStatsPolicy>;
+
+    template <typename Policy>
+    template <typename Update>
+    inline void StatsHooks<Policy>::Record(Update update) {
+        if constexpr (Policy::ENABLED) {
+            if (Stats* stats = Stats::current_; stats) {
+                update(*stats);
+            }
+        }
+    }
+
+    template <typename Policy>
+    inline StatsHooks<Policy>::Call::Call() {
+        if constexpr (Policy::ENABLED) {
+            stats_ = Stats::current_;
+            if (stats_) {
+                const size_t depth = ++stats_->call_depth_;
+                if (depth > stats_->counters_.peak_call_depth) {
+                    stats_->counters_.peak_call_depth = depth;
+                }
+            }
+        }
+    }
+
+    template <typename Policy>
+    inline StatsHooks<Policy>::Call::~Call() {
+        if constexpr (Policy::ENABLED) {
+            if (stats_) {
+                --stats_->call_depth_;
+            }
+        }
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::ObjectAllocated(ObjectKind kind) {
+        Record([kind](Stats& stats) { ++stats.counters_.objects_allocated[static_cast<size_t>(kind)]; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::HolderCopied() {
+        Record([](Stats& stats) { ++stats.counters_.holder_copies; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::ClosureCreated() {
+        Record([](Stats& stats) { ++stats.counters_.closures_created; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::MethodLookedUp() {
+        Record([](Stats& stats) { ++stats.counters_.method_lookups; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::InlineCacheHit() {
+        Record([](Stats& stats) { ++stats.counters_.inline_cache_hits; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::InlineCacheMissed() {
+        Record([](Stats& stats) { ++stats.counters_.inline_cache_misses; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::ReturnThrown() {
+        Record([](Stats& stats) { ++stats.counters_.return_exceptions; });
+    }
+
+    template <typename Policy>
+    inline void StatsHooks<Policy>::Printed(size_t bytes) {
+        Record([bytes](Stats& stats) { stats.counters_.bytes_printed += bytes; });
+    }
+
+}  // namespace runtime
@@ -0,0 +1,171 @@
+#include "lexer.h"
+#include "program.h"
+#include "stats.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+const string COUNTING_PROGRAM = R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add(n):
+    self.value = self.value + n
+    return self.value
+
+class Walker:
+  def down(n):
+    if n == 0:
+      return 0
+    return self.down(n - 1) + 1
+
+c = Counter()
+c.add(1)
+c.add(2)
+w = Walker()
+print w.down(3), 'x'
+)"s;
+
+const string POLYMORPHIC_PROGRAM = R"(
+class A:
+  def name():
+    return 'a'
+
+class B(A):
+  def name():
+    return 'b'
+
+class Caller:
+  def call(x):
+    return x.name()
+
+c = Caller()
+a = A()
+b = B()
+print c.call(a), c.call(a), c.call(b), c.call(a)
+)"s;
+
+string Run(const string& source, Stats& stats) {
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    auto program = CompileProgram(lexer);
+    DummyContext context;
+    context.SetStats(&stats);
+    Closure closure;
+    program->Execute(closure, context, ExecutionMode::TREE_WALKING);
+    return context.output.str();
+}
+
+size_t Allocated(const Stats& stats, ObjectKind kind) {
+    return stats.GetCounters().objects_allocated[static_cast<size_t>(kind)];
+}
+
+void TestCountsExecution() {
+    if (!DefaultStatsPolicy::ENABLED) {
+        return;
+    }
+    Stats stats;
+    ASSERT_EQUAL(Run(COUNTING_PROGRAM, stats), "3 x\n"s);
+
+    const StatsCounters& counters = stats.GetCounters();
+    ASSERT_EQUAL(Allocated(stats, ObjectKind::INSTANCE), 2u);
+    ASSERT_EQUAL(Allocated(stats, ObjectKind::BOOL), 4u);
+    ASSERT_EQUAL(Allocated(stats, ObjectKind::CLASS), 0u);
+    ASSERT(Allocated(stats, ObjectKind::NUMBER) > 0);
+    ASSERT(counters.holder_copies > 0);
+    ASSERT_EQUAL(counters.closures_created, 7u);
+    ASSERT_EQUAL(counters.inline_cache_misses, 4u);
+    ASSERT_EQUAL(counters.inline_cache_hits, 2u);
+    ASSERT_EQUAL(counters.method_lookups, 5u);
+    ASSERT_EQUAL(counters.return_exceptions, 6u);
+    ASSERT_EQUAL(counters.bytes_printed, 4u);
+    ASSERT_EQUAL(counters.peak_call_depth, 4u);
+    ASSERT(Stats::Current() == nullptr);
+}
+
+void TestInlineCacheFollowsReceiverClass() {
+    if (!DefaultStatsPolicy::ENABLED) {
+        return;
+    }
+    Stats stats;
+    ASSERT_EQUAL(Run(POLYMORPHIC_PROGRAM, stats), "a a b a\n"s);
+    ASSERT_EQUAL(stats.GetCounters().inline_cache_hits, 1u);
+    ASSERT_EQUAL(stats.GetCounters().inline_cache_misses, 7u);
+
+    Stats arity_stats;
+    try {
+        Run(POLYMORPHIC_PROGRAM + "print a.name(1)\n"s, arity_stats);
+        ASSERT(false);
+    }
+    catch (const runtime_error& error) {
+        ASSERT_EQUAL(string(error.what()), "No method name"s);
+    }
+}
+
+void TestDumps() {
+    if (!DefaultStatsPolicy::ENABLED) {
+        return;
+    }
+    Stats stats;
+    Run(COUNTING_PROGRAM, stats);
+
+    ostringstream text;
+    stats.WriteText(text);
+    ASSERT(text.str().find("  instance 2\n"s) != string::npos);
+    ASSERT(text.str().find("\nmethod_lookups 5\n"s) != string::npos);
+    ASSERT(text.str().find("\npeak_call_depth 4\n"s) != string::npos);
+
+    ostringstream json;
+    stats.WriteJson(json);
+    ASSERT(json.str().rfind("{\"objects_allocated\": {\"number\": "s, 0) == 0);
+    ASSERT(json.str().find("\"instance\": 2, \"class\": 0, \"other\": 0}, \"holder_copies\": "s) != string::npos);
+    ASSERT(json.str().find(", \"bytes_printed\": 4, \"peak_call_depth\": 4}\n"s) != string::npos);
+}
+
+void TestReleasePolicyRecordsNothing() {
+    Stats stats;
+    Stats::Scope scope(&stats);
+    Stats::Scope keeps_enclosing(nullptr);
+    ASSERT(Stats::Current() == &stats);
+
+    using Release = StatsHooks<ReleaseStatsPolicy>;
+    Release::ObjectAllocated(ObjectKind::NUMBER);
+    Release::HolderCopied();
+    Release::MethodLookedUp();
+    Release::Printed(10);
+    {
+        Release::Call call;
+    }
+    ASSERT_EQUAL(stats.GetObjectsAllocated(), 0u);
+    ASSERT_EQUAL(stats.GetCounters().holder_copies, 0u);
+    ASSERT_EQUAL(stats.GetCounters().method_lookups, 0u);
+    ASSERT_EQUAL(stats.GetCounters().bytes_printed, 0u);
+    ASSERT_EQUAL(stats.GetCounters().peak_call_depth, 0u);
+
+    using Counting = StatsHooks<CountingStatsPolicy>;
+    Counting::Printed(10);
+    {
+        Counting::Call outer;
+        Counting::Call inner;
+    }
+    ASSERT_EQUAL(stats.GetCounters().bytes_printed, 10u);
+    ASSERT_EQUAL(stats.GetCounters().peak_call_depth, 2u);
+}
+
+}  // namespace
+
+void RunStatsTests(TestRunner& tr) {
+    RUN_TEST(tr, TestCountsExecution);
+    RUN_TEST(tr, TestInlineCacheFollowsReceiverClass);
+    RUN_TEST(tr, TestDumps);
+    RUN_TEST(tr, TestReleasePolicyRecordsNothing);
+}
+
+}  // namespace runtime
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "lexer.h"
+#include "parse.h"
+#include "program.h"
+#include "test_runner_p.h"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Parses a whole program into its statement tree; throws the errors of Lexer and ParseProgram.
+inline std::unique_ptr<runtime::Executable> ParseFromString(const std::string& source) {
+    std::istringstream input(source);
+    parse::Lexer lexer(input);
+    return ParseProgram(lexer);
+}
+
+// Compiles a whole program from its source; throws the errors of Lexer and ParseProgram.
+inline std::shared_ptr<const Program> CompileFromString(const std::string& source) {
+    std::istringstream input(source);
+    parse::Lexer lexer(input);
+    return CompileProgram(lexer);
+}
+
+// What program prints when run in a fresh closure in mode.
+inline std::string RunInMode(const Program& program, ExecutionMode mode, const vm::Options& options = {}) {
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    program.Execute(closure, context, mode, options);
+    return context.output.str();
+}
+
+// The message of the runtime_error running source in mode throws, or an empty string.
+inline std::string RunErrorInMode(const std::string& source, ExecutionMode mode) {
+    try {
+        RunInMode(*CompileFromString(source), mode);
+    }
+    catch (const std::runtime_error& error) {
+        return error.what();
+    }
+    return {};
+}
+
+// ---------------------------------Differential tests-------------------------------------------
+// Every execution mode must behave exactly like ExecutionMode::TREE_WALKING; each backend's test
+// file runs these checks for its own mode.
+
+// Classes, inheritance, the dunder methods, branches and every operator.
+inline const std::string SAMPLE_PROGRAM = R"(
+class Counter:
+  def __init__(start):
+    self.value = start
+
+  def add(n):
+    self.value = self.value + n
+    return self
+
+  def scaled(k):
+    if k > 1:
+      result = self.value * k
+    else:
+      result = 0 - self.value
+    return result
+
+  def sign():
+    if self.value < 0:
+      return 0 - 1
+    if self.value == 0:
+      return 0
+    return 1
+
+  def __str__():
+    return 'Counter(' + str(self.value) + ')'
+
+  def __add__(other):
+    return self.value + other.value
+
+class Named(Counter):
+  def __init__(name):
+    self.value = 0
+    self.name = name
+
+  def __str__():
+    return self.name + ':' + str(self.value)
+
+c = Counter(1)
+d = c.add(2)
+z = Counter(0)
+print c, d, c.value, c.scaled(3), c.scaled(1), c.sign(), z.sign()
+e = c + Counter(10)
+print e
+n = Named('n')
+n.add(5)
+print n, str(n), Counter
+if c.value > 2 and not (c.value == 4):
+  print 'big', None, True, 7 / 2
+else:
+  print 'small'
+x = 0 or 'fallback'
+print x, 'a' + 'b', 2 * 3 - 1, c.value <= 3, 'abc' < 'abd'
+)";
+
+inline void AssertSampleMatchesTreeWalking(ExecutionMode mode) {
+    auto program = CompileFromString(SAMPLE_PROGRAM);
+    const std::string expected = RunInMode(*program, ExecutionMode::TREE_WALKING);
+    ASSERT_EQUAL(expected, std::string("Counter(3) Counter(3) 3 9 -3 1 0\n13\nn:5 n:5 Class Counter\n"
+                                       "big None True 3\nTrue ab 5 True True\n"));
+    ASSERT_EQUAL(RunInMode(*program, mode), expected);
+}
+
+// __str__ and argument evaluation print in the middle of an outer print.
+inline void AssertPrintOrderMatchesTreeWalking(ExecutionMode mode) {
+    auto program = CompileFromString(R"(
+class A:
+  def __str__():
+    print 'inner'
+    return 'a'
+
+  def loud(n):
+    print 'loud', n
+    return n
+
+x = A()
+print 'outer', x, x.loud(1), 'end'
+print
+print x
+)");
+    const std::string expected = RunInMode(*program, ExecutionMode::TREE_WALKING);
+    ASSERT_EQUAL(expected, std::string("outer inner\na loud 1\n1 end\n\ninner\na\n"));
+    ASSERT_EQUAL(RunInMode(*program, mode), expected);
+}
+
+inline void AssertErrorsMatchTreeWalking(ExecutionMode mode) {
+    const std::vector<std::string> sources = {
+        "print missing\n",
+        "x = 1\nprint x.field\n",
+        "class A:\n  def f():\n    return 1\na = A()\nprint a.g()\n",
+        "class A:\n  def f():\n    return 1\na = A()\nprint a + 1\n",
+        "class A:\n  def f():\n    return y\na = A()\nprint a.f()\n",
+        "class A:\n  def f(x):\n    if x:\n      y = 1\n    return y\na = A()\nprint a.f(False)\n",
+        "print 1 / 0\n",
+        "print 'a' - 1\n",
+    };
+    for (const auto& source : sources) {
+        const std::string expected = RunErrorInMode(source, ExecutionMode::TREE_WALKING);
+        ASSERT(!expected.empty());
+        ASSERT_EQUAL(RunErrorInMode(source, mode), expected);
+    }
+}
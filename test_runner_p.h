@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <numeric>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -79,8 +86,185 @@ inline void Assert(bool b, const std::string& hint) {
     AssertEqual(b, true, hint);
 }
 
+// Makes the compiler assume value is read, so that the work computing it is not elided.
+template <class T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Makes the compiler assume all memory is read and written, so that stores are not elided.
+inline void ClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+// Benchmarking is off unless enabled, and RUN_BENCH then runs its function once like RUN_TEST.
+// FromEnvironment reads MYTHON_BENCH (any value enables), MYTHON_BENCH_WARMUP,
+// MYTHON_BENCH_REPETITIONS, MYTHON_BENCH_BASELINE (a file path), MYTHON_BENCH_THRESHOLD (a
+// fraction of the baseline median) and MYTHON_BENCH_UPDATE (any value rewrites the baseline).
+struct BenchOptions {
+    bool enabled = false;
+    size_t warmup = 3;
+    size_t repetitions = 15;
+    // Each repetition calls the function as many times as it takes to run for at least this long.
+    std::chrono::nanoseconds min_repetition_time = std::chrono::milliseconds(1);
+    std::string baseline_path;
+    double threshold = 0.1;
+    bool update_baseline = false;
+
+    static BenchOptions FromEnvironment() {
+        BenchOptions options;
+        options.enabled = std::getenv("MYTHON_BENCH") != nullptr;
+        if (const char* value = std::getenv("MYTHON_BENCH_WARMUP")) {
+            options.warmup = std::stoul(value);
+        }
+        if (const char* value = std::getenv("MYTHON_BENCH_REPETITIONS")) {
+            options.repetitions = std::max<size_t>(1, std::stoul(value));
+        }
+        if (const char* value = std::getenv("MYTHON_BENCH_BASELINE")) {
+            options.baseline_path = value;
+        }
+        if (const char* value = std::getenv("MYTHON_BENCH_THRESHOLD")) {
+            options.threshold = std::stod(value);
+        }
+        options.update_baseline = std::getenv("MYTHON_BENCH_UPDATE") != nullptr;
+        return options;
+    }
+};
+
+// Nanoseconds per call over the repetitions of a benchmark.
+struct BenchStats {
+    size_t samples = 0;
+    double min = 0;
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+};
+
+inline BenchStats ComputeBenchStats(std::vector<double> samples) {
+    BenchStats stats;
+    stats.samples = samples.size();
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t middle = samples.size() / 2;
+    stats.min = samples.front();
+    stats.median = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+    stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    if (samples.size() > 1) {
+        double squares = 0;
+        for (double sample : samples) {
+            squares += (sample - stats.mean) * (sample - stats.mean);
+        }
+        stats.stddev = std::sqrt(squares / (samples.size() - 1));
+    }
+    return stats;
+}
+
+// Median nanoseconds per call by benchmark name, stored one "name median" per line.
+using BenchBaseline = std::map<std::string, double>;
+
+inline BenchBaseline ReadBenchBaseline(std::istream& input) {
+    BenchBaseline baseline;
+    std::string name;
+    double median = 0;
+    while (input >> name >> median) {
+        baseline[name] = median;
+    }
+    return baseline;
+}
+
+inline void WriteBenchBaseline(std::ostream& output, const BenchBaseline& baseline) {
+    for (const auto& [name, median] : baseline) {
+        output << name << ' ' << std::setprecision(17) << median << '\n';
+    }
+}
+
+// The relative change of median from the baseline of name, if it has one.
+inline bool CompareWithBaseline(const BenchBaseline& baseline, const std::string& name, double median,
+                                double& change) {
+    auto it = baseline.find(name);
+    if (it == baseline.end() || it->second <= 0) {
+        return false;
+    }
+    change = median / it->second - 1;
+    return true;
+}
+
 class TestRunner {
 public:
+    void SetBenchOptions(BenchOptions options) {
+        bench_options_ = std::move(options);
+        if (!bench_options_.baseline_path.empty()) {
+            std::ifstream input(bench_options_.baseline_path);
+            baseline_ = ReadBenchBaseline(input);
+        }
+    }
+
+    // Runs func once, then, if benchmarking is enabled, warmup and timed repetitions of it. A
+    // median more than threshold above the baseline counts as a failure.
+    template <class BenchFunc>
+    void RunBench(BenchFunc func, const std::string& bench_name) {
+        using Clock = std::chrono::steady_clock;
+        if (!bench_options_.enabled) {
+            RunTest(func, bench_name);
+            return;
+        }
+        try {
+            func();
+            size_t calls = 1;
+            for (;;) {
+                const auto start = Clock::now();
+                for (size_t i = 0; i < calls; ++i) {
+                    func();
+                    ClobberMemory();
+                }
+                if (Clock::now() - start >= bench_options_.min_repetition_time || calls >= (size_t{1} << 30)) {
+                    break;
+                }
+                calls *= 2;
+            }
+            for (size_t i = 0; i < bench_options_.warmup * calls; ++i) {
+                func();
+                ClobberMemory();
+            }
+            std::vector<double> samples;
+            for (size_t repetition = 0; repetition < bench_options_.repetitions; ++repetition) {
+                const auto start = Clock::now();
+                for (size_t i = 0; i < calls; ++i) {
+                    func();
+                    ClobberMemory();
+                }
+                const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+                samples.push_back(elapsed.count() / calls);
+            }
+            const BenchStats stats = ComputeBenchStats(std::move(samples));
+            results_[bench_name] = stats.median;
+
+            std::ostringstream report;
+            report << std::fixed << std::setprecision(1) << "median " << stats.median << " ns, min " << stats.min
+                   << " ns, mean " << stats.mean << " ns, stddev " << stats.stddev << " ns, "
+                   << stats.samples << " x " << calls << " calls";
+            double change = 0;
+            const bool compared = CompareWithBaseline(baseline_, bench_name, stats.median, change);
+            if (compared) {
+                report << ", " << std::showpos << change * 100 << std::noshowpos << "% from baseline";
+            }
+            if (compared && change > bench_options_.threshold && !bench_options_.update_baseline) {
+                ++fail_count;
+                std::cerr << bench_name << " regressed: " << report.str() << std::endl;
+            } else {
+                std::cerr << bench_name << " OK: " << report.str() << std::endl;
+            }
+        } catch (std::exception& e) {
+            ++fail_count;
+            std::cerr << bench_name << " fail: " << e.what() << std::endl;
+        } catch (...) {
+            ++fail_count;
+            std::cerr << "Unknown exception caught" << std::endl;
+        }
+    }
+
     template <class TestFunc>
     void RunTest(TestFunc func, const std::string& test_name) {
         try {
@@ -96,6 +280,13 @@ public:
     }
 
     ~TestRunner() {
+        if (bench_options_.update_baseline && !bench_options_.baseline_path.empty() && !results_.empty()) {
+            for (const auto& [name, median] : results_) {
+                baseline_[name] = median;
+            }
+            std::ofstream output(bench_options_.baseline_path);
+            WriteBenchBaseline(output, baseline_);
+        }
         std::cerr.flush();
         if (fail_count > 0) {
             std::cerr << fail_count << " unit tests failed. Terminate" << std::endl;
@@ -105,6 +296,9 @@ public:
 
 private:
     int fail_count = 0;
+    BenchOptions bench_options_;
+    BenchBaseline baseline_;
+    BenchBaseline results_;
 };
 
 #ifndef FILE_NAME
@@ -127,6 +321,8 @@ private:
 
 #define RUN_TEST(tr, func) tr.RunTest(func, #func)
 
+#define RUN_BENCH(tr, func) tr.RunBench(func, #func)
+
 #define ASSERT_THROWS(expr, expected_exception)                                                   \
     {                                                                                             \
         bool __assert_private_flag = true;                                                        \
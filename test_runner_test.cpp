@@ -0,0 +1,78 @@
+#include "test_runner_p.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+void TestBenchStats() {
+    const BenchStats stats = ComputeBenchStats({4.0, 1.0, 3.0, 2.0});
+    ASSERT_EQUAL(stats.samples, 4u);
+    ASSERT_EQUAL(stats.min, 1.0);
+    ASSERT_EQUAL(stats.median, 2.5);
+    ASSERT_EQUAL(stats.mean, 2.5);
+    ASSERT(abs(stats.stddev - sqrt(5.0 / 3)) < 1e-12);
+
+    ASSERT_EQUAL(ComputeBenchStats({3.0, 1.0, 2.0}).median, 2.0);
+    ASSERT_EQUAL(ComputeBenchStats({7.0}).stddev, 0.0);
+    ASSERT_EQUAL(ComputeBenchStats({}).samples, 0u);
+}
+
+void TestBenchBaseline() {
+    istringstream input("TestA 100\nparse::TestB 2.5\n");
+    const BenchBaseline baseline = ReadBenchBaseline(input);
+    ASSERT_EQUAL(baseline.size(), 2u);
+    ASSERT_EQUAL(baseline.at("parse::TestB"s), 2.5);
+
+    ostringstream output;
+    WriteBenchBaseline(output, baseline);
+    ASSERT_EQUAL(output.str(), "TestA 100\nparse::TestB 2.5\n"s);
+
+    double change = 0;
+    ASSERT(CompareWithBaseline(baseline, "TestA"s, 125, change));
+    ASSERT_EQUAL(change, 0.25);
+    ASSERT(!CompareWithBaseline(baseline, "TestC"s, 125, change));
+}
+
+void TestRunBenchUpdatesBaseline() {
+    const string path = "test_runner_test_baseline.txt"s;
+    {
+        ofstream existing(path);
+        existing << "Other 42\n";
+    }
+    size_t calls = 0;
+    {
+        TestRunner tr;
+        BenchOptions options;
+        options.enabled = true;
+        options.warmup = 1;
+        options.repetitions = 3;
+        options.min_repetition_time = chrono::microseconds(10);
+        options.baseline_path = path;
+        options.update_baseline = true;
+        tr.SetBenchOptions(options);
+        tr.RunBench([&calls] {
+            ++calls;
+            DoNotOptimize(calls);
+        }, "Counting"s);
+    }
+    ASSERT(calls >= 5u);
+
+    ifstream input(path);
+    const BenchBaseline baseline = ReadBenchBaseline(input);
+    remove(path.c_str());
+    ASSERT_EQUAL(baseline.size(), 2u);
+    ASSERT_EQUAL(baseline.at("Other"s), 42.0);
+    ASSERT(baseline.at("Counting"s) > 0);
+}
+
+}  // namespace
+
+void RunBenchTests(TestRunner& tr) {
+    RUN_TEST(tr, TestBenchStats);
+    RUN_TEST(tr, TestBenchBaseline);
+    RUN_TEST(tr, TestRunBenchUpdatesBaseline);
+}
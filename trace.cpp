@@ -0,0 +1,141 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+using namespace std;
+
+namespace trace {
+
+    namespace {
+
+        size_t RoundUpToPowerOfTwo(size_t value) {
+            size_t result = 1;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // Microseconds with nanosecond digits, the unit of the "ts" field.
+        void WriteTimestamp(ostream& out, uint64_t nanoseconds) {
+            out << nanoseconds / 1000 << '.' << setw(3) << setfill('0') << nanoseconds % 1000 << setfill(' ');
+        }
+
+        void WriteEvent(ostream& out, const Event& event, size_t tid) {
+            out << "{\"ph\":\"" << static_cast<char>(event.phase) << "\",\"ts\":";
+            WriteTimestamp(out, event.timestamp);
+            out << ",\"pid\":1,\"tid\":" << tid;
+            if (event.phase == Phase::END) {
+                out << '}';
+                return;
+            }
+            out << ",\"cat\":\"" << event.category << "\",\"name\":\"";
+            if (event.scope) {
+                out << *event.scope << '.';
+            }
+            out << event.name << '"';
+            if (event.phase == Phase::INSTANT) {
+                out << ",\"s\":\"t\"";
+            }
+            if (event.argument) {
+                out << ",\"args\":{\"" << event.argument << "\":" << event.value << '}';
+            }
+            out << '}';
+        }
+
+    }  // namespace
+
+    // ----------------------Ring-----------------------
+
+    Ring::Ring(size_t capacity, Clock::time_point start, size_t id)
+        : events_(RoundUpToPowerOfTwo(max<size_t>(capacity, 1)))
+        , mask_(events_.size() - 1)
+        , start_(start)
+        , id_(id) {}
+
+    size_t Ring::GetId() const {
+        return id_;
+    }
+
+    uint64_t Ring::GetRecordedCount() const {
+        return head_.load(memory_order_acquire);
+    }
+
+    vector<Event> Ring::GetEvents() const {
+        const uint64_t head = head_.load(memory_order_acquire);
+        const uint64_t first = head > events_.size() ? head - events_.size() : 0;
+        vector<Event> result;
+        result.reserve(static_cast<size_t>(head - first));
+        for (uint64_t i = first; i < head; ++i) {
+            result.push_back(events_[i & mask_]);
+        }
+        return result;
+    }
+
+    // ----------------------Scope-----------------------
+
+    Tracer::Scope::Scope(Tracer& tracer)
+        : previous_(current_) {
+        current_ = &tracer.RingOfThisThread();
+    }
+
+    Tracer::Scope::~Scope() {
+        current_ = previous_;
+    }
+
+    // ----------------------Tracer-----------------------
+
+    Tracer::Tracer(size_t capacity_per_thread)
+        : capacity_(capacity_per_thread) {}
+
+    Ring& Tracer::RingOfThisThread() {
+        lock_guard lock(mutex_);
+        const thread::id id = this_thread::get_id();
+        for (const auto& [owner, ring] : rings_) {
+            if (owner == id) {
+                return *ring;
+            }
+        }
+        rings_.emplace_back(id, make_unique<Ring>(capacity_, start_, rings_.size() + 1));
+        return *rings_.back().second;
+    }
+
+    uint64_t Tracer::GetRecordedCount() const {
+        lock_guard lock(mutex_);
+        uint64_t count = 0;
+        for (const auto& [owner, ring] : rings_) {
+            count += ring->GetRecordedCount();
+        }
+        return count;
+    }
+
+    void Tracer::WriteJson(ostream& out) const {
+        lock_guard lock(mutex_);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& [owner, ring] : rings_) {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->GetId()
+                << ",\"args\":{\"name\":\"mython-" << ring->GetId() << "\"}}";
+            first = false;
+            // Ends whose beginning was overwritten would close spans of the viewer's own.
+            size_t depth = 0;
+            for (const Event& event : ring->GetEvents()) {
+                if (event.phase == Phase::END) {
+                    if (depth == 0) {
+                        continue;
+                    }
+                    --depth;
+                }
+                else if (event.phase == Phase::BEGIN) {
+                    ++depth;
+                }
+                out << ",\n";
+                WriteEvent(out, event, ring->GetId());
+            }
+        }
+        out << "\n]}\n";
+    }
+
+}  // namespace trace
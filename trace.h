@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Structured execution tracing. While a Tracer::Scope is open on a thread, the interpreter
+// records method calls, instance constructions, prints and output flushes of that thread into
+// its own ring buffer, which only that thread writes. Tracer::WriteJson renders all rings as
+// Chrome trace-event JSON for chrome://tracing or ui.perfetto.dev. With no scope open, every
+// hook is a single branch on a thread-local pointer.
+namespace trace {
+
+    // ----------------------Event-----------------------
+
+    enum class Phase : char {
+        BEGIN = 'B',
+        END = 'E',
+        INSTANT = 'i'
+    };
+
+    // scope, when set, prefixes name as "scope.name". The strings are owned by the program, so
+    // the trace must be written while it is alive.
+    struct Event {
+        uint64_t                                       timestamp = 0;
+        const char*                                    category = nullptr;
+        const std::string*                             scope = nullptr;
+        std::string_view                               name;
+        const char*                                    argument = nullptr;
+        uint64_t                                       value = 0;
+        Phase                                          phase = Phase::INSTANT;
+    };
+
+    // ----------------------Ring-----------------------
+
+    // A single-producer ring of the most recent events of one thread. Once full, each new event
+    // overwrites the oldest one.
+    class Ring {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+                                                       Ring(size_t capacity, Clock::time_point start, size_t id);
+
+        void                                           Record(Event event);
+
+        [[nodiscard]] size_t                           GetId() const;
+
+        [[nodiscard]] uint64_t                         GetRecordedCount() const;
+
+        // The retained events, oldest first.
+        [[nodiscard]] std::vector<Event>               GetEvents() const;
+
+    private:
+        std::vector<Event>                             events_;
+        size_t                                         mask_;
+        Clock::time_point                              start_;
+        size_t                                         id_;
+        std::atomic<uint64_t>                          head_{0};
+    };
+
+    // ----------------------Tracer-----------------------
+
+    class Tracer {
+    public:
+        static constexpr size_t                        DEFAULT_CAPACITY = 1 << 16;
+
+        // Directs the events of the current thread to its ring of tracer until destroyed.
+        class Scope {
+        public:
+            explicit                                   Scope(Tracer& tracer);
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope();
+
+        private:
+            Ring* previous_;
+        };
+
+        // Records a BEGIN event on construction and the matching END on destruction.
+        class Span {
+        public:
+                                                       Span(const char* category, const std::string* scope,
+                                                            std::string_view name, const char* argument, uint64_t value);
+
+            Span(const Span&) = delete;
+            Span& operator=(const Span&) = delete;
+
+            ~Span();
+
+        private:
+            Ring* ring_;
+        };
+
+        // Capacity is rounded up to a power of two.
+        explicit                                       Tracer(size_t capacity_per_thread = DEFAULT_CAPACITY);
+
+        static void                                    Instant(const char* category, std::string_view name,
+                                                               const char* argument, uint64_t value);
+
+        // Events recorded by all threads, including those already overwritten.
+        [[nodiscard]] uint64_t                         GetRecordedCount() const;
+
+        // Should be called once the traced threads have closed their scopes.
+        void                                           WriteJson(std::ostream& out) const;
+
+    private:
+        Ring&                                          RingOfThisThread();
+
+        size_t                                         capacity_;
+        Ring::Clock::time_point                        start_ = Ring::Clock::now();
+        mutable std::mutex                             mutex_;
+        std::vector<std::pair<std::thread::id, std::unique_ptr<Ring>>> rings_;
+
+        static inline thread_local Ring*               current_ = nullptr;
+    };
+
+    inline void Ring::Record(Event event) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        event.timestamp = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count());
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    inline Tracer::Span::Span(const char* category, const std::string* scope, std::string_view name,
+                              const char* argument, uint64_t value)
+        : ring_(current_) {
+        if (ring_) {
+            ring_->Record(Event{0, category, scope, name, argument, value, Phase::BEGIN});
+        }
+    }
+
+    inline Tracer::Span::~Span() {
+        if (ring_) {
+            ring_->Record(Event{0, nullptr, nullptr, {}, nullptr, 0, Phase::END});
+        }
+    }
+
+    inline void Tracer::Instant(const char* category, std::string_view name, const char* argument, uint64_t value) {
+        if (Ring* ring = current_; ring) {
+            ring->Record(Event{0, category, nullptr, name, argument, value, Phase::INSTANT});
+        }
+    }
+
+}  // namespace trace
@@ -0,0 +1,140 @@
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+#include "test_runner_p.h"
+#include "trace.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace trace {
+
+namespace {
+
+const string COUNTER_PROGRAM = R"(
+class Counter:
+  def __init__(start):
+    self.value = start
+
+  def add(x, y):
+    self.value = self.value + x + y
+    return self.value
+
+c = Counter(5)
+print c.add(1, 2)
+)"s;
+
+size_t Occurrences(const string& text, const string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != string::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+string RunTraced(Tracer* tracer) {
+    istringstream input(COUNTER_PROGRAM);
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    if (tracer) {
+        Tracer::Scope scope(*tracer);
+        program->Execute(closure, context);
+    }
+    else {
+        program->Execute(closure, context);
+    }
+    ostringstream json;
+    if (tracer) {
+        tracer->WriteJson(json);
+    }
+    return json.str();
+}
+
+void TestRecordsCallsConstructionsAndPrints() {
+    Tracer tracer;
+    const string json = RunTraced(&tracer);
+
+    ASSERT_EQUAL(tracer.GetRecordedCount(), 7u);
+    ASSERT(json.find("\"cat\":\"new\",\"name\":\"Counter\",\"args\":{\"arity\":1}"s) != string::npos);
+    ASSERT(json.find("\"cat\":\"call\",\"name\":\"Counter.__init__\",\"args\":{\"arity\":1}"s) != string::npos);
+    ASSERT(json.find("\"cat\":\"call\",\"name\":\"Counter.add\",\"args\":{\"arity\":2}"s) != string::npos);
+    ASSERT(json.find("\"ph\":\"i\""s) != string::npos);
+    ASSERT(json.find("\"cat\":\"print\",\"name\":\"print\",\"s\":\"t\",\"args\":{\"bytes\":2}"s) != string::npos);
+    ASSERT_EQUAL(Occurrences(json, "\"ph\":\"B\""s), 3u);
+    ASSERT_EQUAL(Occurrences(json, "\"ph\":\"E\""s), 3u);
+    // The construction encloses the __init__ call.
+    ASSERT(json.find("\"name\":\"Counter\""s) < json.find("Counter.__init__"s));
+}
+
+void TestDisabledRecordsNothing() {
+    Tracer tracer;
+    RunTraced(nullptr);
+    ASSERT_EQUAL(tracer.GetRecordedCount(), 0u);
+
+    Tracer::Span span("call", nullptr, "outside"sv, nullptr, 0);
+    Tracer::Instant("print", "print"sv, "bytes", 1);
+    ASSERT_EQUAL(tracer.GetRecordedCount(), 0u);
+}
+
+void TestRingKeepsNewestEvents() {
+    Tracer tracer(5);
+    {
+        Tracer::Scope scope(tracer);
+        for (int i = 0; i < 10; ++i) {
+            Tracer::Span span("call", nullptr, "outer"sv, nullptr, 0);
+            Tracer::Instant("print", "print"sv, "bytes", static_cast<uint64_t>(i));
+        }
+    }
+    ASSERT_EQUAL(tracer.GetRecordedCount(), 30u);
+
+    ostringstream json;
+    tracer.WriteJson(json);
+    // Eight are retained; the first of them is an END whose BEGIN was overwritten.
+    ASSERT_EQUAL(Occurrences(json.str(), "\"ph\":\"E\""s), 2u);
+    ASSERT_EQUAL(Occurrences(json.str(), "\"ph\":\"B\""s), 2u);
+    ASSERT_EQUAL(Occurrences(json.str(), "\"ph\":\"i\""s), 3u);
+    ASSERT(json.str().find("{\"bytes\":9}"s) != string::npos);
+    ASSERT(json.str().find("{\"bytes\":6}"s) == string::npos);
+}
+
+void TestThreadsRecordIntoOwnRings() {
+    Tracer tracer;
+    auto work = [&tracer] {
+        Tracer::Scope scope(tracer);
+        for (int i = 0; i < 100; ++i) {
+            Tracer::Span span("call", nullptr, "work"sv, nullptr, 0);
+        }
+    };
+    thread first(work);
+    thread second(work);
+    first.join();
+    second.join();
+    {
+        Tracer::Scope outer(tracer);
+        Tracer::Scope nested(tracer);
+        Tracer::Instant("print", "print"sv, nullptr, 0);
+    }
+
+    ASSERT_EQUAL(tracer.GetRecordedCount(), 401u);
+    ostringstream json;
+    tracer.WriteJson(json);
+    ASSERT(json.str().find("\"tid\":1,\"args\":{\"name\":\"mython-1\"}"s) != string::npos);
+    ASSERT(json.str().find("\"tid\":2,\"args\":{\"name\":\"mython-2\"}"s) != string::npos);
+    ASSERT(json.str().find("\"tid\":3,\"args\":{\"name\":\"mython-3\"}"s) != string::npos);
+    ASSERT(json.str().find("\"tid\":4"s) == string::npos);
+}
+
+}  // namespace
+
+void RunTraceTests(TestRunner& tr) {
+    RUN_TEST(tr, TestRecordsCallsConstructionsAndPrints);
+    RUN_TEST(tr, TestDisabledRecordsNothing);
+    RUN_TEST(tr, TestRingKeepsNewestEvents);
+    RUN_TEST(tr, TestThreadsRecordIntoOwnRings);
+}
+
+}  // namespace trace
@@ -0,0 +1,532 @@
+#include "transpile.h"
+
+#include "statement.h"
+
+#include <cstdio>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace aot {
+
+    namespace {
+        using Comparator = bool (*)(const runtime::ObjectHolder&, const runtime::ObjectHolder&, runtime::Context&);
+
+        const string SELF = "self"s;
+        const string INIT_METHOD = "__init__"s;
+
+        string Quote(const string& text) {
+            string result = "\""s;
+            for (unsigned char c : text) {
+                if (c == '"' || c == '\\') {
+                    result += '\\';
+                    result += static_cast<char>(c);
+                }
+                else if (c >= 0x20 && c < 0x7F) {
+                    result += static_cast<char>(c);
+                }
+                else {
+                    char escaped[5];
+                    snprintf(escaped, sizeof(escaped), "\\%03o", c);
+                    result += escaped;
+                }
+            }
+            return result + "\""s;
+        }
+
+        const char* ComparatorName(const ast::Comparison& node) {
+            const Comparator* comparator = node.GetComparator().target<Comparator>();
+            if (!comparator) {
+                return nullptr;
+            }
+            const pair<Comparator, const char*> known[] = {
+                {&runtime::Equal, "runtime::Equal"},
+                {&runtime::NotEqual, "runtime::NotEqual"},
+                {&runtime::Less, "runtime::Less"},
+                {&runtime::Greater, "runtime::Greater"},
+                {&runtime::LessOrEqual, "runtime::LessOrEqual"},
+                {&runtime::GreaterOrEqual, "runtime::GreaterOrEqual"},
+            };
+            for (const auto& [function, name] : known) {
+                if (*comparator == function) {
+                    return name;
+                }
+            }
+            return nullptr;
+        }
+
+        // ----------------------Transpiler-----------------------
+
+        class Transpiler {
+        public:
+            Transpiler(runtime::Executable& program, const TranspileOptions& options)
+                : program_(program)
+                , options_(options) {}
+
+            void Run(ostream& output) {
+                CollectClasses(program_);
+
+                ostringstream classes;
+                for (size_t i = 0; i < classes_.size(); ++i) {
+                    EmitClassDeclaration(classes, i);
+                }
+                ostringstream methods;
+                for (size_t i = 0; i < classes_.size(); ++i) {
+                    for (size_t j = 0; j < classes_[i]->GetMethods().size(); ++j) {
+                        EmitMethod(methods, i, j);
+                    }
+                }
+                ostringstream entry;
+                EmitEntryPoint(entry);
+
+                output << "// Generated from a Mython program by aot::Transpile.\n"sv;
+                output << "#include \"aot_runtime.h\"\n\n#include <exception>\n#include <iostream>\n\n"sv;
+                output << "namespace {\n\nusing runtime::ObjectHolder;\n\n"sv;
+                EmitConstants(output);
+                output << classes.str();
+                EmitClassTable(output);
+                output << methods.str();
+                output << "}  // namespace\n\n"sv;
+                output << entry.str();
+                if (options_.emit_main) {
+                    EmitMain(output);
+                }
+            }
+
+        private:
+            struct Function {
+                bool                                   is_method = false;
+                set<string>                            locals;
+                ostream* out = nullptr;
+                int                                    indent = 0;
+            };
+
+            void CollectClasses(const runtime::Executable& statement) {
+                if (auto node = dynamic_cast<const ast::ClassDefinition*>(&statement); node) {
+                    const auto* cls = node->GetClass().TryAs<runtime::Class>();
+                    class_index_[cls] = classes_.size();
+                    classes_.push_back(cls);
+                }
+                else if (auto node = dynamic_cast<const ast::Compound*>(&statement); node) {
+                    for (const auto& child : node->GetStatements()) {
+                        CollectClasses(*child);
+                    }
+                }
+                else if (auto node = dynamic_cast<const ast::IfElse*>(&statement); node) {
+                    CollectClasses(*node->GetIfBody());
+                    if (node->GetElseBody()) {
+                        CollectClasses(*node->GetElseBody());
+                    }
+                }
+            }
+
+            static void CollectLocals(const runtime::Executable& statement, set<string>& locals) {
+                if (auto node = dynamic_cast<const ast::Assignment*>(&statement); node) {
+                    locals.insert(node->GetName());
+                }
+                else if (auto node = dynamic_cast<const ast::MethodBody*>(&statement); node) {
+                    CollectLocals(*node->GetBody(), locals);
+                }
+                else if (auto node = dynamic_cast<const ast::Compound*>(&statement); node) {
+                    for (const auto& child : node->GetStatements()) {
+                        CollectLocals(*child, locals);
+                    }
+                }
+                else if (auto node = dynamic_cast<const ast::IfElse*>(&statement); node) {
+                    CollectLocals(*node->GetIfBody(), locals);
+                    if (node->GetElseBody()) {
+                        CollectLocals(*node->GetElseBody(), locals);
+                    }
+                }
+            }
+
+            string ClassName(size_t index) const {
+                return "Class"s + to_string(index) + "_"s + classes_[index]->GetName();
+            }
+
+            string ClassHolder(const runtime::Class& cls) const {
+                auto it = class_index_.find(&cls);
+                if (it == class_index_.end()) {
+                    throw TranspileError("Class "s + cls.GetName() + " is not defined by the program"s);
+                }
+                return "Classes().class_"s + to_string(it->second);
+            }
+
+            void EmitClassDeclaration(ostream& out, size_t index) {
+                out << "// Mython class "sv << classes_[index]->GetName() << '\n';
+                out << "class "sv << ClassName(index) << " {\npublic:\n"sv;
+                const auto& methods = classes_[index]->GetMethods();
+                for (size_t i = 0; i < methods.size(); ++i) {
+                    out << "    static ObjectHolder method_"sv << i
+                        << "(runtime::Closure& closure, runtime::Context& context);  // "sv << methods[i].name << '\n';
+                }
+                out << "};\n\n"sv;
+            }
+
+            void EmitClassTable(ostream& out) {
+                out << "struct ClassTable {\n"sv;
+                for (size_t i = 0; i < classes_.size(); ++i) {
+                    const runtime::Class& cls = *classes_[i];
+                    out << "    ObjectHolder class_"sv << i << " = aot::MakeClass("sv << Quote(cls.GetName()) << ", {\n"sv;
+                    const auto& methods = cls.GetMethods();
+                    for (size_t j = 0; j < methods.size(); ++j) {
+                        out << "        {"sv << Quote(methods[j].name) << ", {"sv;
+                        for (size_t k = 0; k < methods[j].formal_params.size(); ++k) {
+                            out << (k ? ", "sv : ""sv) << Quote(methods[j].formal_params[k]);
+                        }
+                        out << "}, &"sv << ClassName(i) << "::method_"sv << j << "},\n"sv;
+                    }
+                    out << "    }, "sv;
+                    if (cls.GetParent()) {
+                        auto it = class_index_.find(cls.GetParent());
+                        if (it == class_index_.end() || it->second >= i) {
+                            throw TranspileError("Parent of class "s + cls.GetName() + " is not defined before it"s);
+                        }
+                        out << "class_"sv << it->second;
+                    }
+                    else {
+                        out << "ObjectHolder()"sv;
+                    }
+                    out << ");\n"sv;
+                }
+                out << "};\n\n"sv;
+                out << "const ClassTable& Classes() {\n    static const ClassTable classes;\n    return classes;\n}\n\n"sv;
+            }
+
+            void EmitConstants(ostream& out) {
+                out << "struct ConstantTable {\n"sv << constants_.str() << "};\n\n"sv;
+                out << "const ConstantTable& Constants() {\n    static const ConstantTable constants;\n    return constants;\n}\n\n"sv;
+            }
+
+            string Constant(const string& expression) {
+                auto it = constant_index_.find(expression);
+                if (it == constant_index_.end()) {
+                    it = constant_index_.emplace(expression, constant_index_.size()).first;
+                    constants_ << "    ObjectHolder c"sv << it->second << " = ObjectHolder::Own("sv << expression << ");\n"sv;
+                }
+                return "Constants().c"s + to_string(it->second);
+            }
+
+            void EmitMethod(ostream& out, size_t class_index, size_t method_index) {
+                const runtime::Method& method = classes_[class_index]->GetMethods()[method_index];
+                Function function;
+                function.is_method = true;
+                function.out = &out;
+                function.indent = 1;
+                function_ = &function;
+
+                out << "// "sv << classes_[class_index]->GetName() << '.' << method.name << '\n';
+                out << "ObjectHolder "sv << ClassName(class_index) << "::method_"sv << method_index
+                    << "([[maybe_unused]] runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) {\n"sv;
+                Line() << "aot::Local v_self(closure, \"self\");\n"sv;
+                function.locals.insert(SELF);
+                for (const auto& param : method.formal_params) {
+                    if (function.locals.insert(param).second) {
+                        Line() << "aot::Local v_"sv << param << "(closure, "sv << Quote(param) << ");\n"sv;
+                    }
+                }
+                set<string> assigned;
+                CollectLocals(*method.body, assigned);
+                for (const auto& name : assigned) {
+                    if (function.locals.insert(name).second) {
+                        Line() << "aot::Local v_"sv << name << ";\n"sv;
+                    }
+                }
+                Statement(*method.body);
+                Line() << "return ObjectHolder();\n"sv;
+                out << "}\n\n"sv;
+                function_ = nullptr;
+            }
+
+            void EmitEntryPoint(ostream& out) {
+                Function function;
+                function.out = &out;
+                function.indent = 1;
+                function_ = &function;
+                out << "runtime::ObjectHolder "sv << options_.entry_point
+                    << "(runtime::Closure& globals, [[maybe_unused]] runtime::Context& context) {\n"sv;
+                Statement(program_);
+                Line() << "return ObjectHolder();\n"sv;
+                out << "}\n"sv;
+                function_ = nullptr;
+            }
+
+            void EmitMain(ostream& out) {
+                out << "\nint main() {\n"sv;
+                out << "    runtime::SimpleContext context(std::cout);\n"sv;
+                out << "    runtime::Closure globals;\n"sv;
+                out << "    try {\n"sv;
+                out << "        "sv << options_.entry_point << "(globals, context);\n"sv;
+                out << "    }\n"sv;
+                out << "    catch (const std::exception& error) {\n"sv;
+                out << "        std::cout.flush();\n"sv;
+                out << "        std::cerr << error.what() << std::endl;\n"sv;
+                out << "        return 1;\n"sv;
+                out << "    }\n"sv;
+                out << "    return 0;\n"sv;
+                out << "}\n"sv;
+            }
+
+            ostream& Line() {
+                for (int i = 0; i < function_->indent; ++i) {
+                    *function_->out << "    "sv;
+                }
+                return *function_->out;
+            }
+
+            void Open(const string& header) {
+                Line() << header << " {\n"sv;
+                ++function_->indent;
+            }
+
+            void Close(const string& trailer = ""s) {
+                --function_->indent;
+                Line() << "}"sv << trailer << '\n';
+            }
+
+            string Temp() {
+                return "t"s + to_string(next_temp_++);
+            }
+
+            string Define(const string& expression) {
+                string name = Temp();
+                Line() << "const ObjectHolder "sv << name << " = "sv << expression << ";\n"sv;
+                return name;
+            }
+
+            string Declare() {
+                string name = Temp();
+                Line() << "ObjectHolder "sv << name << ";\n"sv;
+                return name;
+            }
+
+            void Statement(const runtime::Executable& statement) {
+                if (auto node = dynamic_cast<const ast::MethodBody*>(&statement); node) {
+                    Statement(*node->GetBody());
+                }
+                else if (auto node = dynamic_cast<const ast::Compound*>(&statement); node) {
+                    for (const auto& child : node->GetStatements()) {
+                        Statement(*child);
+                    }
+                }
+                else if (auto node = dynamic_cast<const ast::Return*>(&statement); node) {
+                    if (!function_->is_method) {
+                        throw TranspileError("return outside of a method"s);
+                    }
+                    const string value = Expression(*node->GetStatement());
+                    Line() << "return "sv << value << ";\n"sv;
+                }
+                else if (auto node = dynamic_cast<const ast::Assignment*>(&statement); node) {
+                    const string value = Expression(*node->GetValue());
+                    if (function_->is_method) {
+                        Line() << "v_"sv << node->GetName() << ".Set("sv << value << ");\n"sv;
+                    }
+                    else {
+                        Line() << "globals["sv << Quote(node->GetName()) << "] = "sv << value << ";\n"sv;
+                    }
+                }
+                else if (auto node = dynamic_cast<const ast::FieldAssignment*>(&statement); node) {
+                    const string object = Expression(node->GetObject());
+                    const string instance = "i"s + to_string(next_temp_++);
+                    Open("if (runtime::ClassInstance* "s + instance + " = aot::AsInstance("s + object + "))"s);
+                    const string value = Expression(*node->GetValue());
+                    Line() << instance << "->SetField("sv << Quote(node->GetFieldName()) << ", "sv << value << ");\n"sv;
+                    Close();
+                }
+                else if (auto node = dynamic_cast<const ast::ClassDefinition*>(&statement); node) {
+                    const auto& cls = *node->GetClass().TryAs<runtime::Class>();
+                    const string holder = ClassHolder(cls);
+                    if (function_->is_method) {
+                        Line() << "v_"sv << cls.GetName() << ".Set("sv << holder << ");\n"sv;
+                    }
+                    else {
+                        Line() << "globals["sv << Quote(cls.GetName()) << "] = "sv << holder << ";\n"sv;
+                    }
+                }
+                else if (auto node = dynamic_cast<const ast::IfElse*>(&statement); node) {
+                    const string condition = Expression(*node->GetCondition());
+                    Open("if (runtime::IsTrue("s + condition + "))"s);
+                    Statement(*node->GetIfBody());
+                    if (node->GetElseBody()) {
+                        Close();
+                        Open("else"s);
+                        Statement(*node->GetElseBody());
+                    }
+                    Close();
+                }
+                else if (auto node = dynamic_cast<const ast::Print*>(&statement); node) {
+                    // Each argument is written before the next is evaluated, as the interpreter does.
+                    const auto& args = node->GetArgs();
+                    for (size_t i = 0; i < args.size(); ++i) {
+                        const string value = Expression(*args[i]);
+                        Line() << "runtime::PrintArgument("sv << value << ", "sv << (i + 1 == args.size() ? "true"sv : "false"sv)
+                               << ", context);\n"sv;
+                    }
+                    if (args.empty()) {
+                        Line() << "context.Write(\"\\n\");\n"sv;
+                    }
+                }
+                else {
+                    Expression(statement);
+                }
+            }
+
+            static string Join(const vector<string>& items) {
+                string result;
+                for (size_t i = 0; i < items.size(); ++i) {
+                    result += (i ? ", "s : ""s) + items[i];
+                }
+                return result;
+            }
+
+            // Emits the statements computing a value and returns the expression naming it.
+            // Intermediate values are kept in temporaries, so evaluation order is the interpreter's.
+            string Expression(const runtime::Executable& expression) {
+                if (auto node = dynamic_cast<const ast::NumericConst*>(&expression); node) {
+                    return Constant("runtime::Number("s + to_string(node->GetValue().TryAs<runtime::Number>()->GetValue()) + ")"s);
+                }
+                if (auto node = dynamic_cast<const ast::StringConst*>(&expression); node) {
+                    return Constant("runtime::String("s + Quote(node->GetValue().TryAs<runtime::String>()->GetValue()) + ")"s);
+                }
+                if (auto node = dynamic_cast<const ast::BoolConst*>(&expression); node) {
+                    return Constant(node->GetValue().TryAs<runtime::Bool>()->GetValue() ? "runtime::Bool(true)"s : "runtime::Bool(false)"s);
+                }
+                if (dynamic_cast<const ast::None*>(&expression)) {
+                    return "ObjectHolder()"s;
+                }
+                if (auto node = dynamic_cast<const ast::VariableValue*>(&expression); node) {
+                    return Variable(*node);
+                }
+                if (auto node = dynamic_cast<const ast::Add*>(&expression); node) {
+                    const auto [lhs, rhs] = Operands(*node);
+                    return Define("aot::Add("s + lhs + ", "s + rhs + ", context)"s);
+                }
+                if (auto node = dynamic_cast<const ast::Sub*>(&expression); node) {
+                    const auto [lhs, rhs] = Operands(*node);
+                    return Define("aot::Sub("s + lhs + ", "s + rhs + ")"s);
+                }
+                if (auto node = dynamic_cast<const ast::Mult*>(&expression); node) {
+                    const auto [lhs, rhs] = Operands(*node);
+                    return Define("aot::Mult("s + lhs + ", "s + rhs + ")"s);
+                }
+                if (auto node = dynamic_cast<const ast::Div*>(&expression); node) {
+                    const auto [lhs, rhs] = Operands(*node);
+                    return Define("aot::Div("s + lhs + ", "s + rhs + ")"s);
+                }
+                if (auto node = dynamic_cast<const ast::Comparison*>(&expression); node) {
+                    const char* comparator = ComparatorName(*node);
+                    if (!comparator) {
+                        throw TranspileError("Unknown comparison"s);
+                    }
+                    const auto [lhs, rhs] = Operands(*node);
+                    return Define("aot::MakeBool("s + comparator + "("s + lhs + ", "s + rhs + ", context))"s);
+                }
+                if (auto node = dynamic_cast<const ast::And*>(&expression); node) {
+                    return Logical(*node, true);
+                }
+                if (auto node = dynamic_cast<const ast::Or*>(&expression); node) {
+                    return Logical(*node, false);
+                }
+                if (auto node = dynamic_cast<const ast::Not*>(&expression); node) {
+                    const string argument = Expression(*node->GetArgument());
+                    return Define("aot::MakeBool(!runtime::IsTrue("s + argument + "))"s);
+                }
+                if (auto node = dynamic_cast<const ast::Stringify*>(&expression); node) {
+                    const string argument = Expression(*node->GetArgument());
+                    return Define("aot::Stringify("s + argument + ", context)"s);
+                }
+                if (auto node = dynamic_cast<const ast::MethodCall*>(&expression); node) {
+                    const string object = Expression(*node->GetObject());
+                    const string result = Declare();
+                    const string instance = "i"s + to_string(next_temp_++);
+                    Open("if (runtime::ClassInstance* "s + instance + " = aot::AsInstance("s + object + "))"s);
+                    const string args = Arguments(node->GetArgs());
+                    Line() << result << " = "sv << instance << "->Call("sv << Quote(node->GetMethod()) << ", {"sv << args
+                           << "}, context);\n"sv;
+                    Close();
+                    return result;
+                }
+                if (auto node = dynamic_cast<const ast::NewInstance*>(&expression); node) {
+                    const runtime::Class& cls = node->GetClass();
+                    const string result = Define("aot::NewInstance("s + ClassHolder(cls) + ")"s);
+                    const runtime::Method* init = cls.GetMethod(INIT_METHOD);
+                    if (init && init->formal_params.size() == node->GetArgs().size()) {
+                        const string args = Arguments(node->GetArgs());
+                        Line() << "aot::AsInstance("sv << result << ")->Call(\"__init__\", {"sv << args << "}, context);\n"sv;
+                    }
+                    return result;
+                }
+                if (dynamic_cast<const ast::Assignment*>(&expression) || dynamic_cast<const ast::FieldAssignment*>(&expression)
+                    || dynamic_cast<const ast::Print*>(&expression) || dynamic_cast<const ast::ClassDefinition*>(&expression)
+                    || dynamic_cast<const ast::IfElse*>(&expression) || dynamic_cast<const ast::Compound*>(&expression)) {
+                    Statement(expression);
+                    return "ObjectHolder()"s;
+                }
+                throw TranspileError("Unsupported statement "s + typeid(expression).name());
+            }
+
+            pair<string, string> Operands(const ast::BinaryOperation& node) {
+                string lhs = Expression(*node.GetLhs());
+                string rhs = Expression(*node.GetRhs());
+                return {move(lhs), move(rhs)};
+            }
+
+            string Arguments(const vector<unique_ptr<ast::Statement>>& args) {
+                vector<string> values;
+                for (const auto& arg : args) {
+                    values.push_back(Expression(*arg));
+                }
+                return Join(values);
+            }
+
+            string Variable(const ast::VariableValue& node) {
+                const auto& ids = node.GetDottedIds();
+                string value;
+                if (!function_->is_method) {
+                    value = Define("aot::Load(globals, "s + Quote(ids[0]) + ")"s);
+                }
+                else if (function_->locals.count(ids[0])) {
+                    value = Define("v_"s + ids[0] + ".Get("s + Quote(ids[0]) + ")"s);
+                }
+                else {
+                    value = Define("aot::Undefined("s + Quote(ids[0]) + ")"s);
+                }
+                for (size_t i = 1; i < ids.size(); ++i) {
+                    value = Define("aot::LoadField("s + value + ", "s + Quote(ids[i]) + ")"s);
+                }
+                return value;
+            }
+
+            string Logical(const ast::BinaryOperation& node, bool is_and) {
+                const string lhs = Expression(*node.GetLhs());
+                const string result = Declare();
+                Open(is_and ? "if (runtime::IsTrue("s + lhs + "))"s : "if (!runtime::IsTrue("s + lhs + "))"s);
+                const string rhs = Expression(*node.GetRhs());
+                Line() << result << " = aot::MakeBool(runtime::IsTrue("sv << rhs << "));\n"sv;
+                Close();
+                Open("else"s);
+                Line() << result << " = aot::MakeBool("sv << (is_and ? "false"sv : "true"sv) << ");\n"sv;
+                Close();
+                return result;
+            }
+
+            runtime::Executable& program_;
+            const TranspileOptions& options_;
+            vector<const runtime::Class*>              classes_;
+            unordered_map<const runtime::Class*, size_t> class_index_;
+            ostringstream                              constants_;
+            unordered_map<string, size_t>              constant_index_;
+            Function* function_ = nullptr;
+            size_t                                     next_temp_ = 0;
+        };
+    }  // namespace
+
+    void Transpile(runtime::Executable& program, ostream& output, const TranspileOptions& options) {
+        Transpiler(program, options).Run(output);
+    }
+
+}  // namespace aot
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace aot {
+
+    // ----------------------TranspileError-----------------------
+
+    class TranspileError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // ----------------------TranspileOptions-----------------------
+
+    struct TranspileOptions {
+        std::string                                    entry_point = "RunMythonProgram";
+        bool                                           emit_main = true;
+    };
+
+    // Writes a C++ translation unit equivalent to a program returned by ParseProgram. Every Mython
+    // class becomes a C++ class whose static member functions are its methods; they operate on
+    // ObjectHolder values through aot_runtime.h. The unit defines
+    //     runtime::ObjectHolder <entry_point>(runtime::Closure& globals, runtime::Context& context);
+    // and, if emit_main is set, a main that runs it on standard output. Build it together with the
+    // interpreter sources, for example
+    //     c++ -std=c++17 -O2 -I<repo> out.cpp $(ls <repo>/*.cpp | grep -v -e main.cpp -e test)
+    // Throws TranspileError for statements it cannot translate.
+    void                                               Transpile(runtime::Executable& program, std::ostream& output,
+                                                                 const TranspileOptions& options = {});
+
+}  // namespace aot
@@ -0,0 +1,166 @@
+#include "lexer.h"
+#include "parse.h"
+#include "test_runner_p.h"
+#include "transpile.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace aot {
+
+namespace {
+
+const string SHAPES_PROGRAM = R"(
+class Shape:
+  def __init__(name):
+    self.name = name
+
+  def area():
+    return 0
+
+  def describe():
+    return self.name + ' of area ' + str(self.area())
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.name = 'rect'
+    self.w = w
+    self.h = h
+
+  def area():
+    return self.w * self.h
+
+  def __str__():
+    return 'Rect(' + str(self.w) + ', ' + str(self.h) + ')'
+
+r = Rect(3, 4)
+if r.area() > 10 and not r.w == r.h:
+  print r, r.describe()
+else:
+  print "small"
+)"s;
+
+// Calls made while a print statement is running print in between its arguments, and the last
+// statement fails after the output before it was written.
+const string PRINT_ORDER_PROGRAM = R"(
+class Loud:
+  def __str__():
+    print 'inner'
+    return 'loud'
+
+  def twice(n):
+    print 'twice', n
+    return n * 2
+
+l = Loud()
+print 'outer', l, l.twice(l.twice(1))
+print
+print 'before', 1 / 0
+)"s;
+
+string TranspileString(const string& source, const TranspileOptions& options = {}) {
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+    ostringstream output;
+    Transpile(*program, output, options);
+    return output.str();
+}
+
+void TestEmitsClassesAndEntryPoint() {
+    const string code = TranspileString(SHAPES_PROGRAM);
+    ASSERT(code.find("#include \"aot_runtime.h\""s) != string::npos);
+    ASSERT(code.find("class Class0_Shape {"s) != string::npos);
+    ASSERT(code.find("class Class1_Rect {"s) != string::npos);
+    ASSERT(code.find("aot::MakeClass(\"Rect\""s) != string::npos);
+    ASSERT(code.find("}, class_0);"s) != string::npos);
+    ASSERT(code.find("runtime::ObjectHolder RunMythonProgram(runtime::Closure& globals"s) != string::npos);
+    ASSERT(code.find("int main()"s) != string::npos);
+}
+
+void TestOptions() {
+    const string code = TranspileString(SHAPES_PROGRAM, TranspileOptions{"RunShapes"s, false});
+    ASSERT(code.find("runtime::ObjectHolder RunShapes("s) != string::npos);
+    ASSERT(code.find("int main()"s) == string::npos);
+}
+
+void TestRejectsTopLevelReturn() {
+    bool thrown = false;
+    try {
+        TranspileString("x = 1\nreturn x\n"s);
+    }
+    catch (const TranspileError&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+}
+
+// Builds the C++ code generated for source together with the runtime sources next to this file,
+// runs it, and checks that its output is that of the tree walker. Skipped when neither the
+// sources nor a C++ compiler are around.
+void CheckGeneratedProgram(const string& source) {
+    namespace fs = std::filesystem;
+    const fs::path source_dir = fs::path(__FILE__).parent_path();
+    if (!fs::exists(source_dir / "aot_runtime.cpp"s) || system("command -v c++ > /dev/null 2>&1") != 0) {
+        return;
+    }
+
+    istringstream input(source);
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    bool interpreted_ok = true;
+    try {
+        program->Execute(closure, context);
+    }
+    catch (const exception&) {
+        interpreted_ok = false;
+    }
+
+    const fs::path work_dir = fs::temp_directory_path() / ("mython_aot_test_"s + to_string(getpid()));
+    fs::create_directories(work_dir);
+    {
+        ofstream generated(work_dir / "generated.cpp"s);
+        Transpile(*program, generated);
+    }
+    string command = "cd '"s + work_dir.string() + "' && for f in generated.cpp"s;
+    for (const auto& entry : fs::directory_iterator(source_dir)) {
+        const string name = entry.path().filename().string();
+        if (entry.path().extension() == ".cpp"s && name != "main.cpp"s && name.find("test"s) == string::npos) {
+            command += " '"s + entry.path().string() + "'"s;
+        }
+    }
+    command += "; do c++ -std=c++17 -pthread -I'"s + source_dir.string()
+               + "' -c \"$f\" -o \"$(basename \"$f\" .cpp).o\" & done; wait; "s
+               + "c++ -pthread -o program *.o && ./program > output.txt 2> /dev/null"s;
+    const int status = system(command.c_str());
+    ASSERT(fs::exists(work_dir / "program"s));
+
+    ifstream output_file(work_dir / "output.txt"s);
+    const string output{istreambuf_iterator<char>(output_file), istreambuf_iterator<char>()};
+    fs::remove_all(work_dir);
+    ASSERT_EQUAL(status == 0, interpreted_ok);
+    ASSERT_EQUAL(output, context.output.str());
+}
+
+void TestGeneratedProgramRuns() {
+    CheckGeneratedProgram(SHAPES_PROGRAM + PRINT_ORDER_PROGRAM);
+}
+
+}  // namespace
+
+void RunTranspileTests(TestRunner& tr) {
+    RUN_TEST(tr, TestEmitsClassesAndEntryPoint);
+    RUN_TEST(tr, TestOptions);
+    RUN_TEST(tr, TestRejectsTopLevelReturn);
+    RUN_TEST(tr, TestGeneratedProgramRuns);
+}
+
+}  // namespace aot
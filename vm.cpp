@@ -0,0 +1,625 @@
+#include "vm.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace vm {
+
+    using runtime::Closure;
+    using runtime::Context;
+    using runtime::ObjectHolder;
+
+    namespace {
+        const string ADD_METHOD = "__add__"s;
+        const string INIT_METHOD = "__init__"s;
+        const string STR_METHOD = "__str__"s;
+        const string SELF = "self"s;
+
+        // Rough cost of one closure entry, used to charge frames against the stack budget.
+        constexpr size_t CLOSURE_ENTRY_BYTES = 64;
+    }  // namespace
+
+    // ----------------------Compiler-----------------------
+
+    class Compiler {
+    public:
+        Compiler(Module& module, Code& code)
+            : module_(module)
+            , code_(code) {}
+
+        void CompileMain(runtime::Executable& program) {
+            CompileExpression(program);
+            Emit(OpCode::RETURN);
+        }
+
+        void CompileMethod(runtime::Executable& body) {
+            if (auto node = dynamic_cast<ast::MethodBody*>(&body); node) {
+                CompileExpression(*node->GetBody());
+                Emit(OpCode::POP);
+                Emit(OpCode::PUSH_NONE);
+            }
+            else {
+                CompileExpression(body);
+            }
+            Emit(OpCode::RETURN);
+        }
+
+        static void CompileClass(Module& module, const runtime::Class& cls) {
+            if (!module.compiled_classes_.insert(&cls).second) {
+                return;
+            }
+            for (const auto& method : cls.GetMethods()) {
+                Code& code = module.methods_[method.body.get()];
+                Compiler(module, code).CompileMethod(*method.body);
+            }
+            if (cls.GetParent()) {
+                CompileClass(module, *cls.GetParent());
+            }
+        }
+
+    private:
+        size_t Emit(OpCode op, uint32_t arg = 0, uint32_t arg2 = 0) {
+            code_.instructions.push_back({op, arg, arg2});
+            return code_.instructions.size() - 1;
+        }
+
+        void PatchJump(size_t index) {
+            code_.instructions[index].arg = static_cast<uint32_t>(code_.instructions.size());
+        }
+
+        uint32_t Name(const string& name) {
+            auto it = find(code_.names.begin(), code_.names.end(), name);
+            if (it == code_.names.end()) {
+                code_.names.push_back(name);
+                return static_cast<uint32_t>(code_.names.size() - 1);
+            }
+            return static_cast<uint32_t>(it - code_.names.begin());
+        }
+
+        template <typename T>
+        static uint32_t Add(vector<T>& pool, T value) {
+            pool.push_back(move(value));
+            return static_cast<uint32_t>(pool.size() - 1);
+        }
+
+        void CompileArgs(const vector<unique_ptr<ast::Statement>>& args) {
+            for (const auto& arg : args) {
+                CompileExpression(*arg);
+            }
+        }
+
+        void CompileVariable(const ast::VariableValue& node) {
+            const auto& ids = node.GetDottedIds();
+            Emit(OpCode::LOAD_VAR, Name(ids.front()));
+            for (size_t i = 1; i < ids.size(); ++i) {
+                Emit(OpCode::LOAD_FIELD, Name(ids[i]));
+            }
+        }
+
+        // Every node leaves exactly one value on the operand stack.
+        void CompileExpression(runtime::Executable& statement) {
+            if (auto node = dynamic_cast<ast::NumericConst*>(&statement); node) {
+                Emit(OpCode::PUSH_CONST, Add(code_.constants, node->GetValue()));
+            }
+            else if (auto node = dynamic_cast<ast::StringConst*>(&statement); node) {
+                Emit(OpCode::PUSH_CONST, Add(code_.constants, node->GetValue()));
+            }
+            else if (auto node = dynamic_cast<ast::BoolConst*>(&statement); node) {
+                Emit(OpCode::PUSH_CONST, Add(code_.constants, node->GetValue()));
+            }
+            else if (dynamic_cast<ast::None*>(&statement)) {
+                Emit(OpCode::PUSH_NONE);
+            }
+            else if (auto node = dynamic_cast<ast::VariableValue*>(&statement); node) {
+                CompileVariable(*node);
+            }
+            else if (auto node = dynamic_cast<ast::Assignment*>(&statement); node) {
+                CompileExpression(*node->GetValue());
+                Emit(OpCode::STORE_VAR, Name(node->GetName()));
+            }
+            else if (auto node = dynamic_cast<ast::FieldAssignment*>(&statement); node) {
+                CompileVariable(node->GetObject());
+                const size_t skip = Emit(OpCode::JUMP_IF_NOT_INSTANCE);
+                CompileExpression(*node->GetValue());
+                Emit(OpCode::STORE_FIELD, Name(node->GetFieldName()));
+                PatchJump(skip);
+            }
+            else if (auto node = dynamic_cast<ast::Print*>(&statement); node) {
+                // One PRINT per argument, so that each is written before the next one runs.
+                const auto& args = node->GetArgs();
+                if (args.empty()) {
+                    Emit(OpCode::PUSH_CONST, Add(code_.constants, ObjectHolder::Own(runtime::String(""s))));
+                    Emit(OpCode::PRINT, 1);
+                }
+                for (size_t i = 0; i < args.size(); ++i) {
+                    CompileExpression(*args[i]);
+                    Emit(OpCode::STRINGIFY);
+                    Emit(OpCode::PRINT, i + 1 == args.size() ? 1 : 0);
+                }
+            }
+            else if (auto node = dynamic_cast<ast::MethodCall*>(&statement); node) {
+                CompileExpression(*node->GetObject());
+                const size_t skip = Emit(OpCode::JUMP_IF_NOT_INSTANCE);
+                CompileArgs(node->GetArgs());
+                Emit(OpCode::CALL_METHOD, Name(node->GetMethod()), static_cast<uint32_t>(node->GetArgs().size()));
+                PatchJump(skip);
+            }
+            else if (auto node = dynamic_cast<ast::NewInstance*>(&statement); node) {
+                const runtime::Class& cls = node->GetClass();
+                CompileClass(module_, cls);
+                const auto* init = cls.GetMethod(INIT_METHOD);
+                const auto& args = node->GetArgs();
+                if (init && init->formal_params.size() == args.size()) {
+                    CompileArgs(args);
+                    Emit(OpCode::NEW_INSTANCE, Add(code_.classes, &cls), static_cast<uint32_t>(args.size() + 1));
+                }
+                else {
+                    Emit(OpCode::NEW_INSTANCE, Add(code_.classes, &cls), 0);
+                }
+            }
+            else if (auto node = dynamic_cast<ast::Stringify*>(&statement); node) {
+                CompileExpression(*node->GetArgument());
+                Emit(OpCode::STRINGIFY);
+            }
+            else if (auto node = dynamic_cast<ast::Not*>(&statement); node) {
+                CompileExpression(*node->GetArgument());
+                Emit(OpCode::NOT);
+            }
+            else if (auto node = dynamic_cast<ast::Add*>(&statement); node) {
+                CompileBinary(*node, OpCode::ADD);
+            }
+            else if (auto node = dynamic_cast<ast::Sub*>(&statement); node) {
+                CompileBinary(*node, OpCode::SUB);
+            }
+            else if (auto node = dynamic_cast<ast::Mult*>(&statement); node) {
+                CompileBinary(*node, OpCode::MULT);
+            }
+            else if (auto node = dynamic_cast<ast::Div*>(&statement); node) {
+                CompileBinary(*node, OpCode::DIV);
+            }
+            else if (auto node = dynamic_cast<ast::Or*>(&statement); node) {
+                CompileLogical(*node, OpCode::JUMP_IF_TRUE_KEEP);
+            }
+            else if (auto node = dynamic_cast<ast::And*>(&statement); node) {
+                CompileLogical(*node, OpCode::JUMP_IF_FALSE_KEEP);
+            }
+            else if (auto node = dynamic_cast<ast::Comparison*>(&statement); node) {
+                CompileExpression(*node->GetLhs());
+                CompileExpression(*node->GetRhs());
+                Emit(OpCode::COMPARE, Add(code_.comparisons, static_cast<const ast::Comparison*>(node)));
+            }
+            else if (auto node = dynamic_cast<ast::Compound*>(&statement); node) {
+                for (const auto& child : node->GetStatements()) {
+                    Emit(OpCode::STATEMENT, Add(code_.statements, static_cast<const runtime::Executable*>(child.get())));
+                    CompileExpression(*child);
+                    Emit(OpCode::POP);
+                }
+                Emit(OpCode::PUSH_NONE);
+            }
+            else if (auto node = dynamic_cast<ast::Return*>(&statement); node) {
+                CompileExpression(*node->GetStatement());
+                Emit(OpCode::RETURN);
+            }
+            else if (auto node = dynamic_cast<ast::ClassDefinition*>(&statement); node) {
+                const auto& cls = *node->GetClass().TryAs<runtime::Class>();
+                CompileClass(module_, cls);
+                Emit(OpCode::PUSH_CONST, Add(code_.constants, node->GetClass()));
+                Emit(OpCode::STORE_VAR, Name(cls.GetName()));
+            }
+            else if (auto node = dynamic_cast<ast::IfElse*>(&statement); node) {
+                CompileExpression(*node->GetCondition());
+                const size_t to_else = Emit(OpCode::JUMP_IF_FALSE);
+                CompileExpression(*node->GetIfBody());
+                const size_t to_end = Emit(OpCode::JUMP);
+                PatchJump(to_else);
+                if (node->GetElseBody()) {
+                    CompileExpression(*node->GetElseBody());
+                }
+                else {
+                    Emit(OpCode::PUSH_NONE);
+                }
+                PatchJump(to_end);
+            }
+            else {
+                Emit(OpCode::EXECUTE_NATIVE, Add(code_.natives, &statement));
+            }
+        }
+
+        void CompileBinary(const ast::BinaryOperation& node, OpCode op) {
+            CompileExpression(*node.GetLhs());
+            CompileExpression(*node.GetRhs());
+            Emit(op);
+        }
+
+        void CompileLogical(const ast::BinaryOperation& node, OpCode short_circuit) {
+            CompileExpression(*node.GetLhs());
+            Emit(OpCode::TO_BOOL);
+            const size_t skip = Emit(short_circuit);
+            Emit(OpCode::POP);
+            CompileExpression(*node.GetRhs());
+            Emit(OpCode::TO_BOOL);
+            PatchJump(skip);
+        }
+
+        Module& module_;
+        Code& code_;
+    };
+
+    // ----------------------Module-----------------------
+
+    Module::Module(runtime::Executable& program) {
+        Compiler(*this, main_).CompileMain(program);
+    }
+
+    const Code& Module::GetMain() const {
+        return main_;
+    }
+
+    const Code* Module::FindMethod(const runtime::Method& method) const {
+        auto it = methods_.find(method.body.get());
+        return it == methods_.end() ? nullptr : &it->second;
+    }
+
+    // ----------------------Interpreter-----------------------
+
+    Interpreter::Interpreter(const Module& module, Closure& closure, Context& context, Options options)
+        : module_(module)
+        , closure_(closure)
+        , context_(context)
+        , options_(options) {}
+
+    ObjectHolder Interpreter::Run() {
+        while (Resume(numeric_limits<size_t>::max()) != Status::FINISHED) {
+        }
+        return result_;
+    }
+
+    Status Interpreter::Resume(size_t safe_points) {
+        if (finished_) {
+            return Status::FINISHED;
+        }
+        runtime::MemoryAccount::Scope memory_scope(context_.GetMemoryAccount());
+        if (!started_) {
+            started_ = true;
+            PushFrame(module_.GetMain(), nullptr, sizeof(Frame), {});
+            frames_.back().closure = &closure_;
+        }
+        try {
+            const Status status = Execute(safe_points);
+            if (status == Status::SUSPENDED) {
+                ++suspensions_;
+            }
+            return status;
+        }
+        catch (...) {
+            finished_ = true;
+            frames_.clear();
+            stack_.clear();
+            throw;
+        }
+    }
+
+    bool Interpreter::IsFinished() const {
+        return finished_;
+    }
+
+    ObjectHolder Interpreter::GetResult() const {
+        return result_;
+    }
+
+    size_t Interpreter::GetSuspensions() const {
+        return suspensions_;
+    }
+
+    Status Interpreter::Execute(size_t safe_points) {
+        while (true) {
+            Frame& frame = frames_.back();
+            const Code& code = *frame.code;
+            const Instruction& instruction = code.instructions[frame.pc++];
+            switch (instruction.op) {
+            case OpCode::STATEMENT:
+                if (safe_points == 0) {
+                    --frame.pc;
+                    return Status::SUSPENDED;
+                }
+                --safe_points;
+                context_.ChargeStep();
+                runtime::CycleCollector::AtSafePoint();
+                break;
+            case OpCode::PUSH_CONST:
+                stack_.push_back(code.constants[instruction.arg]);
+                break;
+            case OpCode::PUSH_NONE:
+                stack_.emplace_back();
+                break;
+            case OpCode::POP:
+                stack_.pop_back();
+                break;
+            case OpCode::LOAD_VAR: {
+                const string& name = code.names[instruction.arg];
+                auto it = frame.closure->find(name);
+                if (it == frame.closure->end()) {
+                    throw runtime_error("Not field"s + name);
+                }
+                stack_.push_back(it->second);
+                break;
+            }
+            case OpCode::LOAD_FIELD: {
+                const string& name = code.names[instruction.arg];
+                auto instance = stack_.back().TryAs<runtime::ClassInstance>();
+                if (!instance) {
+                    throw runtime_error("This isn't object"s);
+                }
+                auto it = instance->Fields().find(name);
+                if (it == instance->Fields().end()) {
+                    throw runtime_error("Not field"s + name);
+                }
+                stack_.back() = ObjectHolder(it->second);
+                break;
+            }
+            case OpCode::STORE_VAR:
+                (*frame.closure)[code.names[instruction.arg]] = stack_.back();
+                break;
+            case OpCode::STORE_FIELD: {
+                ObjectHolder value = Pop();
+                stack_.back().TryAs<runtime::ClassInstance>()->SetField(code.names[instruction.arg], value);
+                stack_.back() = move(value);
+                break;
+            }
+            case OpCode::JUMP:
+                frame.pc = instruction.arg;
+                break;
+            case OpCode::JUMP_IF_TRUE_KEEP:
+                if (runtime::IsTrue(stack_.back())) {
+                    frame.pc = instruction.arg;
+                }
+                break;
+            case OpCode::JUMP_IF_FALSE_KEEP:
+                if (!runtime::IsTrue(stack_.back())) {
+                    frame.pc = instruction.arg;
+                }
+                break;
+            case OpCode::JUMP_IF_FALSE:
+                if (!runtime::IsTrue(Pop())) {
+                    frame.pc = instruction.arg;
+                }
+                break;
+            case OpCode::JUMP_IF_NOT_INSTANCE:
+                if (!stack_.back().TryAs<runtime::ClassInstance>()) {
+                    stack_.back() = ObjectHolder::None();
+                    frame.pc = instruction.arg;
+                }
+                break;
+            case OpCode::TO_BOOL:
+                stack_.back() = ObjectHolder::Own(runtime::Bool(runtime::IsTrue(stack_.back())));
+                break;
+            case OpCode::NOT:
+                stack_.back() = ObjectHolder::Own(runtime::Bool(!runtime::IsTrue(stack_.back())));
+                break;
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MULT:
+            case OpCode::DIV:
+                Arithmetic(instruction.op);
+                break;
+            case OpCode::COMPARE: {
+                ObjectHolder rhs = Pop();
+                ObjectHolder lhs = Pop();
+                const auto& cmp = code.comparisons[instruction.arg]->GetComparator();
+                stack_.push_back(ObjectHolder::Own(runtime::Bool(cmp(lhs, rhs, context_))));
+                break;
+            }
+            case OpCode::STRINGIFY: {
+                ObjectHolder& top = stack_.back();
+                if (top.TryAs<runtime::String>()) {
+                    break;
+                }
+                if (auto instance = top.TryAs<runtime::ClassInstance>(); instance && instance->HasMethod(STR_METHOD, 0)) {
+                    --frame.pc;
+                    CallMethod(Pop(), STR_METHOD, 0);
+                    break;
+                }
+                string buffer;
+                if (top) {
+                    top->FormatTo(buffer, context_);
+                }
+                else {
+                    buffer = "None"s;
+                }
+                top = ObjectHolder::Own(runtime::String(move(buffer)));
+                break;
+            }
+            case OpCode::PRINT: {
+                // arg is 1 for the last argument, which leaves the None value of the statement.
+                runtime::PrintArgument(stack_.back(), instruction.arg != 0, context_);
+                if (instruction.arg != 0) {
+                    stack_.back() = ObjectHolder();
+                }
+                else {
+                    stack_.pop_back();
+                }
+                break;
+            }
+            case OpCode::NEW_INSTANCE: {
+                ObjectHolder instance = ObjectHolder::Own(runtime::ClassInstance(*code.classes[instruction.arg]));
+                if (instruction.arg2 == 0) {
+                    stack_.push_back(move(instance));
+                }
+                else {
+                    ObjectHolder self = instance;
+                    CallMethod(move(self), INIT_METHOD, instruction.arg2 - 1, move(instance));
+                }
+                break;
+            }
+            case OpCode::CALL_METHOD: {
+                if (safe_points == 0) {
+                    --frame.pc;
+                    return Status::SUSPENDED;
+                }
+                --safe_points;
+                const size_t argument_count = instruction.arg2;
+                ObjectHolder self = move(stack_[stack_.size() - argument_count - 1]);
+                stack_.erase(stack_.end() - argument_count - 1);
+                CallMethod(move(self), code.names[instruction.arg], argument_count);
+                break;
+            }
+            case OpCode::RETURN:
+                if (ReturnFromFrame(Pop())) {
+                    return Status::FINISHED;
+                }
+                break;
+            case OpCode::EXECUTE_NATIVE: {
+                ObjectHolder result;
+                try {
+                    result = code.natives[instruction.arg]->Execute(*frame.closure, context_);
+                }
+                catch (const ObjectHolder& returned) {
+                    if (ReturnFromFrame(returned)) {
+                        return Status::FINISHED;
+                    }
+                    break;
+                }
+                stack_.push_back(move(result));
+                break;
+            }
+            }
+        }
+    }
+
+    size_t Interpreter::GetMaxDepth() const {
+        return max_depth_;
+    }
+
+    size_t Interpreter::GetPeakStackBytes() const {
+        return peak_stack_bytes_;
+    }
+
+    ObjectHolder Interpreter::Pop() {
+        ObjectHolder result = move(stack_.back());
+        stack_.pop_back();
+        return result;
+    }
+
+    void Interpreter::PushFrame(const Code& code, std::unique_ptr<Closure> closure, size_t cost,
+        ObjectHolder result_override) {
+        const size_t used = stack_bytes_ + cost + stack_.size() * sizeof(ObjectHolder);
+        if (used > options_.max_stack_bytes) {
+            throw StackOverflowError("Mython call stack exceeded its memory budget of "s
+                + to_string(options_.max_stack_bytes) + " bytes"s);
+        }
+        stack_bytes_ += cost;
+        peak_stack_bytes_ = max(peak_stack_bytes_, used);
+
+        Frame frame{&code, 0, closure.get(), move(closure), stack_.size(), cost, move(result_override), {}};
+        frames_.push_back(move(frame));
+        max_depth_ = max(max_depth_, frames_.size());
+    }
+
+    bool Interpreter::ReturnFromFrame(ObjectHolder result) {
+        Frame& frame = frames_.back();
+        stack_.resize(frame.stack_base);
+        if (frame.result_override) {
+            result = move(frame.result_override);
+        }
+        stack_bytes_ -= frame.cost;
+        frames_.pop_back();
+        if (frames_.empty()) {
+            result_ = move(result);
+            finished_ = true;
+            stack_.clear();
+            return true;
+        }
+        stack_.push_back(move(result));
+        return false;
+    }
+
+    void Interpreter::CallMethod(ObjectHolder self, const std::string& method, size_t argument_count,
+        ObjectHolder result_override) {
+        auto instance = self.TryAs<runtime::ClassInstance>();
+        const runtime::Method* target = instance->GetClass().GetMethod(method);
+        if (!target || target->formal_params.size() != argument_count) {
+            throw runtime_error("No method "s + method);
+        }
+
+        // The Jit is not consulted here: compiled code recurses on the native stack, which this
+        // interpreter exists to keep flat.
+        const size_t first = stack_.size() - argument_count;
+        const Code* code = module_.FindMethod(*target);
+        if (!code) {
+            // ClassInstance::Call charges the step of the call.
+            vector<ObjectHolder> args(make_move_iterator(stack_.begin() + first), make_move_iterator(stack_.end()));
+            stack_.resize(first);
+            ObjectHolder result = instance->Call(*target, args, context_);
+            stack_.push_back(result_override ? move(result_override) : move(result));
+            return;
+        }
+        context_.ChargeStep();
+
+        auto closure = make_unique<Closure>();
+        for (size_t i = 0; i < argument_count; ++i) {
+            closure->emplace(target->formal_params[i], move(stack_[first + i]));
+        }
+        closure->emplace(SELF, ObjectHolder::Share(*instance));
+        stack_.resize(first);
+        PushFrame(*code, move(closure), sizeof(Frame) + sizeof(Closure) + (argument_count + 1) * CLOSURE_ENTRY_BYTES,
+            move(result_override));
+        frames_.back().receiver = move(self);
+    }
+
+    void Interpreter::Arithmetic(OpCode op) {
+        ObjectHolder rhs = Pop();
+        ObjectHolder lhs = Pop();
+        auto lhs_number = lhs.TryAs<runtime::Number>();
+        auto rhs_number = rhs.TryAs<runtime::Number>();
+        if (lhs_number && rhs_number) {
+            const int left = lhs_number->GetValue();
+            const int right = rhs_number->GetValue();
+            switch (op) {
+            case OpCode::ADD:
+                stack_.push_back(ObjectHolder::Own(runtime::Number(left + right)));
+                return;
+            case OpCode::SUB:
+                stack_.push_back(ObjectHolder::Own(runtime::Number(left - right)));
+                return;
+            case OpCode::MULT:
+                stack_.push_back(ObjectHolder::Own(runtime::Number(left * right)));
+                return;
+            default:
+                if (right == 0) {
+                    throw runtime_error("The denominator is zero"s);
+                }
+                stack_.push_back(ObjectHolder::Own(runtime::Number(left / right)));
+                return;
+            }
+        }
+        if (op == OpCode::ADD) {
+            auto lhs_string = lhs.TryAs<runtime::String>();
+            auto rhs_string = rhs.TryAs<runtime::String>();
+            if (lhs_string && rhs_string) {
+                stack_.push_back(ObjectHolder::Own(runtime::String(lhs_string->GetValue() + rhs_string->GetValue())));
+                return;
+            }
+            if (lhs.TryAs<runtime::ClassInstance>()) {
+                stack_.push_back(move(rhs));
+                CallMethod(move(lhs), ADD_METHOD, 1);
+                return;
+            }
+            throw runtime_error("The operator is not overloaded +"s);
+        }
+        switch (op) {
+        case OpCode::SUB:
+            throw runtime_error("The operator is not overloaded -"s);
+        case OpCode::MULT:
+            throw runtime_error("The operator is not overloaded *"s);
+        default:
+            throw runtime_error("The operator is not overloaded /"s);
+        }
+    }
+
+    ObjectHolder Execute(const Module& module, Closure& closure, Context& context, const Options& options) {
+        return Interpreter(module, closure, context, options).Run();
+    }
+
+}  // namespace vm
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vm {
+
+    // ----------------------OpCode-----------------------
+
+    enum class OpCode : uint8_t {
+        STATEMENT,
+        PUSH_CONST,
+        PUSH_NONE,
+        POP,
+        LOAD_VAR,
+        LOAD_FIELD,
+        STORE_VAR,
+        STORE_FIELD,
+        JUMP,
+        JUMP_IF_TRUE_KEEP,
+        JUMP_IF_FALSE_KEEP,
+        JUMP_IF_FALSE,
+        JUMP_IF_NOT_INSTANCE,
+        TO_BOOL,
+        NOT,
+        ADD,
+        SUB,
+        MULT,
+        DIV,
+        COMPARE,
+        STRINGIFY,
+        PRINT,
+        NEW_INSTANCE,
+        CALL_METHOD,
+        RETURN,
+        EXECUTE_NATIVE
+    };
+
+    // ----------------------Instruction-----------------------
+
+    struct Instruction {
+        OpCode                                         op;
+        uint32_t                                       arg = 0;
+        uint32_t                                       arg2 = 0;
+    };
+
+    // ----------------------Code-----------------------
+
+    struct Code {
+        std::vector<Instruction>                       instructions;
+        std::vector<runtime::ObjectHolder>             constants;
+        std::vector<std::string>                       names;
+        std::vector<const runtime::Class*>             classes;
+        std::vector<const ast::Comparison*>            comparisons;
+        std::vector<runtime::Executable*>              natives;
+        std::vector<const runtime::Executable*>        statements;
+    };
+
+    // ----------------------Module-----------------------
+
+    class Module {
+    public:
+        explicit                                       Module(runtime::Executable& program);
+
+        [[nodiscard]] const Code& GetMain() const;
+
+        [[nodiscard]] const Code* FindMethod(const runtime::Method& method) const;
+
+    private:
+        friend class Compiler;
+
+        Code                                           main_;
+        std::unordered_map<const runtime::Executable*, Code> methods_;
+        std::unordered_set<const runtime::Class*>      compiled_classes_;
+    };
+
+    // ----------------------Options-----------------------
+
+    struct Options {
+        static constexpr size_t                        DEFAULT_STACK_BUDGET = 256 << 20;
+
+        size_t                                         max_stack_bytes = DEFAULT_STACK_BUDGET;
+    };
+
+    // ----------------------StackOverflowError-----------------------
+
+    class StackOverflowError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // ----------------------Interpreter-----------------------
+
+    // An execution whose whole state lives in the interpreter object. Resume runs until the given
+    // number of safe points - statement boundaries and method calls - have passed and then leaves
+    // the execution suspended, so it can be picked up later, possibly by another thread. Methods
+    // and statements that run natively (see Module) are not interrupted.
+    enum class Status {
+        SUSPENDED,
+        FINISHED
+    };
+
+    class Interpreter {
+    public:
+        Interpreter(const Module& module, runtime::Closure& closure, runtime::Context& context,
+            Options options = {});
+
+        runtime::ObjectHolder                          Run();
+
+        Status                                         Resume(size_t safe_points);
+
+        [[nodiscard]] bool                             IsFinished() const;
+
+        [[nodiscard]] runtime::ObjectHolder            GetResult() const;
+
+        [[nodiscard]] size_t                           GetSuspensions() const;
+
+        [[nodiscard]] size_t                           GetMaxDepth() const;
+
+        [[nodiscard]] size_t                           GetPeakStackBytes() const;
+
+    private:
+        struct Frame {
+            const Code*                                code;
+            size_t                                     pc = 0;
+            runtime::Closure*                          closure;
+            std::unique_ptr<runtime::Closure>          owned_closure;
+            size_t                                     stack_base = 0;
+            size_t                                     cost = 0;
+            runtime::ObjectHolder                      result_override;
+            // Keeps the instance a method runs on alive; self in the closure is a shared holder.
+            runtime::ObjectHolder                      receiver;
+        };
+
+        Status                                         Execute(size_t safe_points);
+
+        runtime::ObjectHolder                          Pop();
+
+        void                                           PushFrame(const Code& code, std::unique_ptr<runtime::Closure> closure,
+            size_t cost, runtime::ObjectHolder result_override);
+
+        bool                                           ReturnFromFrame(runtime::ObjectHolder result);
+
+        void                                           CallMethod(runtime::ObjectHolder self, const std::string& method,
+            size_t argument_count, runtime::ObjectHolder result_override = {});
+
+        void                                           Arithmetic(OpCode op);
+
+        const Module&                                  module_;
+        runtime::Closure&                              closure_;
+        runtime::Context&                              context_;
+        Options                                        options_;
+        std::vector<Frame>                             frames_;
+        std::vector<runtime::ObjectHolder>             stack_;
+        size_t                                         stack_bytes_ = 0;
+        size_t                                         peak_stack_bytes_ = 0;
+        size_t                                         max_depth_ = 0;
+        size_t                                         suspensions_ = 0;
+        runtime::ObjectHolder                          result_;
+        bool                                           started_ = false;
+        bool                                           finished_ = false;
+    };
+
+    runtime::ObjectHolder                              Execute(const Module& module, runtime::Closure& closure,
+        runtime::Context& context, const Options& options = {});
+
+}  // namespace vm
@@ -0,0 +1,87 @@
+#include "program.h"
+#include "test_helpers_p.h"
+#include "test_runner_p.h"
+#include "vm.h"
+
+using namespace std;
+
+namespace vm {
+
+namespace {
+
+const string DEEP_PROGRAM = R"(
+class Walker:
+  def down(n):
+    if n == 0:
+      return 0
+    return self.down(n - 1) + 1
+
+w = Walker()
+print w.down(100000)
+)"s;
+
+void TestMatchesTreeWalking() {
+    AssertSampleMatchesTreeWalking(ExecutionMode::STACKLESS);
+}
+
+void TestPrintOrderMatchesTreeWalking() {
+    AssertPrintOrderMatchesTreeWalking(ExecutionMode::STACKLESS);
+}
+
+void TestDeepRecursion() {
+    auto program = CompileFromString(DEEP_PROGRAM);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    Interpreter interpreter(program->GetModule(), closure, context);
+    interpreter.Run();
+    ASSERT_EQUAL(context.output.str(), "100000\n"s);
+    ASSERT(interpreter.GetMaxDepth() > 100000);
+    ASSERT(interpreter.GetPeakStackBytes() <= Options{}.max_stack_bytes);
+}
+
+void TestStackBudget() {
+    auto program = CompileFromString(DEEP_PROGRAM);
+    Options options;
+    options.max_stack_bytes = 64 << 10;
+    ASSERT_THROWS(RunInMode(*program, ExecutionMode::STACKLESS, options), StackOverflowError);
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    Interpreter interpreter(program->GetModule(), closure, context, options);
+    ASSERT_THROWS(interpreter.Run(), StackOverflowError);
+    ASSERT(interpreter.GetPeakStackBytes() <= options.max_stack_bytes);
+}
+
+void TestResume() {
+    auto program = CompileFromString(SAMPLE_PROGRAM);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    Interpreter interpreter(program->GetModule(), closure, context);
+    size_t slices = 1;
+    while (interpreter.Resume(1) == Status::SUSPENDED) {
+        ASSERT(!interpreter.IsFinished());
+        ++slices;
+    }
+    ASSERT(interpreter.IsFinished());
+    ASSERT_EQUAL(interpreter.GetSuspensions(), slices - 1);
+    ASSERT(slices > 20);
+    ASSERT_EQUAL(context.output.str(), RunInMode(*program, ExecutionMode::TREE_WALKING));
+    ASSERT(interpreter.Resume(1) == Status::FINISHED);
+}
+
+void TestErrorsMatchTreeWalking() {
+    AssertErrorsMatchTreeWalking(ExecutionMode::STACKLESS);
+}
+
+}  // namespace
+
+void RunVmTests(TestRunner& tr) {
+    RUN_TEST(tr, TestMatchesTreeWalking);
+    RUN_TEST(tr, TestPrintOrderMatchesTreeWalking);
+    RUN_TEST(tr, TestDeepRecursion);
+    RUN_TEST(tr, TestStackBudget);
+    RUN_TEST(tr, TestResume);
+    RUN_TEST(tr, TestErrorsMatchTreeWalking);
+}
+
+}  // namespace vm